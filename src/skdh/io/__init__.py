@@ -16,6 +16,7 @@ wearable devices from their default binary file format.
     ReadCwa
     ReadBin
     ReadApdmH5
+    counts_to_values
 
 General Data IO
 ---------------
@@ -26,7 +27,45 @@ These processes are generic and not limited to a specific device/manufacturer's
     :toctree: generated/
 
     ReadNumpyFile
+    WriteNumpyFile
     ReadCSV
+
+Block Indexing
+--------------
+
+Per-block indices of device binary files, which can be saved next to the file
+and re-used to compute windows without reading the file.
+
+.. autosummary::
+    :toctree: generated/
+
+    BlockIndex
+    get_block_index
+
+Columnar Cache
+--------------
+
+A chunked columnar file of decoded sensor data, so that repeated analyses of
+the same recording do not need to decode the device file again.
+
+.. autosummary::
+    :toctree: generated/
+
+    WriteColumnar
+    ReadColumnar
+
+Batch Reading
+-------------
+
+Reading many device files, several at a time, and re-using output storage
+between files.
+
+.. autosummary::
+    :toctree: generated/
+
+    ReadBatch
+    BatchResult
+    ReadBuffers
 """
 from skdh.io.axivity import ReadCwa
 from skdh.io import axivity
@@ -34,21 +73,39 @@ from skdh.io.geneactiv import ReadBin
 from skdh.io import geneactiv
 from skdh.io.apdm import ReadApdmH5
 from skdh.io import apdm
-from skdh.io.numpy_compressed import ReadNumpyFile
+from skdh.io.numpy_compressed import ReadNumpyFile, WriteNumpyFile
 from skdh.io import numpy_compressed
 from skdh.io.csv import ReadCSV
 from skdh.io import csv
-from skdh.io.utility import FileSizeError
+from skdh.io.utility import FileSizeError, ReadBuffers, counts_to_values
+from skdh.io.block_index import BlockIndex, get_block_index
+from skdh.io import block_index
+from skdh.io.columnar import ReadColumnar, WriteColumnar
+from skdh.io import columnar
+from skdh.io.batch import ReadBatch, BatchResult
+from skdh.io import batch
 
 __all__ = (
     "ReadCwa",
     "ReadBin",
     "ReadApdmH5",
     "ReadNumpyFile",
+    "WriteNumpyFile",
     "ReadCSV",
     "axivity",
     "geneactiv",
     "apdm",
     "numpy_compressed",
-    "csv"
+    "csv",
+    "BlockIndex",
+    "get_block_index",
+    "block_index",
+    "ReadColumnar",
+    "WriteColumnar",
+    "columnar",
+    "ReadBatch",
+    "BatchResult",
+    "ReadBuffers",
+    "counts_to_values",
+    "batch",
 )
@@ -1,5 +1,23 @@
-from .read import read_axivity, read_geneactiv
+from .read import (
+    read_axivity,
+    read_axivity_chunk,
+    read_axivity_index,
+    find_axivity_blocks,
+    read_geneactiv,
+    read_geneactiv_index,
+    index_windows,
+    read_csv_numeric,
+)
 
 # from .gt3x_convert import read_gt3x
 
-__all__ = ("read_axivity", "read_geneactiv")  # , "read_gt3x")
+__all__ = (
+    "read_axivity",
+    "read_axivity_chunk",
+    "read_axivity_index",
+    "find_axivity_blocks",
+    "read_geneactiv",
+    "read_geneactiv_index",
+    "index_windows",
+    "read_csv_numeric",
+)  # , "read_gt3x")
@@ -0,0 +1,88 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include "read_binary_imu.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Wrapping 16-bit sum of `n` little-endian words, 8 at a time with SIMD where available.
+ *
+ * @param data Start of the words
+ * @param n    Number of words
+ *
+ * @result Sum of the words, modulo 2^16
+ */
+static uint16_t word_sum(const char *data, int n)
+{
+    uint16_t lanes[8], val = 0;
+    int i = 0;
+
+#if defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+
+    for (; i + 8 <= n; i += 8)
+        acc = _mm_add_epi16(acc, _mm_loadu_si128((const __m128i *)(data + 2 * i)));
+    _mm_storeu_si128((__m128i *)lanes, acc);
+#elif defined(__ARM_NEON)
+    uint16x8_t acc = vdupq_n_u16(0);
+
+    for (; i + 8 <= n; i += 8)
+        acc = vaddq_u16(acc, vld1q_u16((const uint16_t *)(data + 2 * i)));
+    vst1q_u16(lanes, acc);
+#else
+    memset(lanes, 0, sizeof(lanes));
+#endif
+    for (int k = 0; k < 8; ++k)
+        val += lanes[k];
+
+    for (; i < n; ++i)
+    {
+        uint16_t word;
+        memcpy(&word, data + 2 * i, sizeof(word));
+        val += word;
+    }
+    return val;
+}
+
+/**
+ * Compute the checksum of a data block, the 16-bit word sum of the block, which is 0 for a good
+ * block. Only the words of the samples are summed for unpacked data, as the block can be padded
+ * after the samples.
+ *
+ * @param info  File information, from `axivity_read_header`
+ * @param block Start of the 512 byte data block
+ *
+ * @result 0 if the checksum is good
+ */
+int axivity_block_checksum(AX_Info_t *info, char *block)
+{
+    int nwords;
+    uint16_t val, word;
+
+    /* packed data is always 120 4-byte samples, unpacked is only the samples in the block */
+    if ((block[25] & 0x0f) == 0)
+        nwords = 240;
+    else
+        nwords = info->count * info->axes;
+    if ((nwords < 0) || (nwords > 240))
+        return 1;
+
+    /* 15 words of header, then the samples */
+    val = word_sum(block, 15 + nwords);
+
+    /* the events/battery and sample rate/axes words have always been summed with the first byte
+    sign extended */
+    if ((int8_t)block[22] < 0)
+        val += 0xff00;
+    if ((int8_t)block[24] < 0)
+        val += 0xff00;
+
+    /* checksum is the last word of the block */
+    memcpy(&word, block + 510, sizeof(word));
+    val += word;
+
+    return val != 0;
+}
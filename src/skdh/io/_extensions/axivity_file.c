@@ -0,0 +1,103 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "read_binary_imu.h"
+
+/*
+Each open file is a separate file descriptor that is only read with `pread`, so there is no shared
+state between files (or between reads of the same file). Several files can be read at once from
+different threads, which is not the case for fortran units, as a file can only be connected to one
+unit at a time.
+*/
+
+/**
+ * Open an axivity file, and read the header (first 1024 bytes) plus a little bit of the first data
+ * block for error checking. The file is left open for `axivity_read_block`, and has to be closed
+ * with `axivity_close`, even if there was an error.
+ *
+ * @param file Name of the file
+ * @param info File information storage
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_read_header(const char *file, AX_Info_t *info)
+{
+    char buf[1536];
+    struct stat st;
+    int ierr = AX_READ_E_NONE;
+
+    info->N = open(file, O_RDONLY);
+    if (info->N == -1)
+        return AX_READ_E_FILE_OPEN;
+
+    /* if errors, taken care of by the calling function with the unset nblocks value */
+    if (fstat(info->N, &st) == 0)
+        info->nblocks = (int)(st.st_size / 512);
+
+    /* header and usage blocks, plus the first data block */
+    if (pread(info->N, buf, sizeof(buf), 0) != (ssize_t)sizeof(buf))
+        return AX_READ_E_FILE_READ;
+
+    axivity_parse_header(buf, info, &ierr);
+    return ierr;
+}
+
+/**
+ * Read and decode a single data block from an open axivity file.
+ *
+ * @param info   File information, from `axivity_read_header`
+ * @param block  Index of the 512 byte block in the file
+ * @param n      Number of samples the storage holds
+ * @param filled Storage to mark the block as decoded, one value per block of the storage, or NULL
+ * @param imu    IMU data storage
+ * @param ts     Timestamp storage
+ * @param temp   Temperature storage
+ * @param winfo  Windowing information, and window index storage
+ * @param repair Timestamp repair state, or NULL to leave the timestamps of bad blocks as 0
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_read_block(AX_Info_t *info, long block, long n, unsigned char *filled, double *imu,
+    double *ts, double *temp, Window_t *winfo, AX_Repair_t *repair)
+{
+    char buf[512];
+    int ierr;
+    long i0, n_bad = info->n_bad_blocks;
+
+    if ((ierr = axivity_window_reserve(info, winfo)) != AX_READ_E_NONE)
+        return ierr;
+
+    if (pread(info->N, buf, sizeof(buf), (off_t)block * 512) != (ssize_t)sizeof(buf))
+        return AX_READ_E_FILE_READ;
+
+    /* the block goes at the location given by its sequence number */
+    if ((i0 = axivity_block_start(info, buf, 0, n)) < 0)
+        return AX_READ_E_NONE;
+
+    axivity_decode_block(info, buf, imu + i0 * info->axes, ts + i0, temp + i0, winfo->bases,
+        winfo->periods, winfo->starts, winfo->i_start, winfo->stops, winfo->i_stop, &ierr);
+
+    if ((ierr != AX_READ_E_NONE) || (info->n_bad_blocks != n_bad))
+        return ierr;
+
+    if (filled)
+        filled[i0 / info->count] = 1;
+    if (repair)
+        ierr = axivity_repair_block(info, repair, ts, i0);
+    return ierr;
+}
+
+/**
+ * Close an axivity file opened with `axivity_read_header`. Safe to call if the file was not opened,
+ * or was already closed.
+ *
+ * @param info File information
+ */
+void axivity_close(AX_Info_t *info)
+{
+    if (info->N != -1)
+        close(info->N);
+    info->N = -1;
+}
@@ -0,0 +1,291 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include "read_binary_imu.h"
+
+
+/* range code of a data block, the accel and gyro range bits at the top of the light field */
+static unsigned char axivity_block_range(char *block)
+{
+    uint16_t light;
+
+    memcpy(&light, block + 18, sizeof(light));
+    return (unsigned char)((light >> 10) & 0x3f);
+}
+
+/**
+ * Get the scale (counts per unit) for each axis from the range code of a data block. Matches the
+ * conversion done in `axivity_decode_block`.
+ *
+ * @param info  File information, from `axivity_read_header`
+ * @param range Range code of the block, the top 6 bits of the light field
+ * @param scale Storage for the scale of each axis. Order is [Gy]Ax[Mag]
+ */
+void axivity_range_scales(AX_Info_t *info, unsigned char range, double *scale)
+{
+    double accel, gyro, mag = 16.0;  /* 1uT = 16 */
+
+    /* accel scale 3 msb, gyro scale next 3 */
+    accel = (double)(1 << (8 + ((range >> 3) & 0x07)));  /* 1g = 256 at the default range */
+    gyro = 32768.0 / (double)(8000 / (1 << (range & 0x07)));
+
+    for (int i = 0; i < info->axes; ++i)
+        scale[i] = accel;
+    if (info->axes >= 6)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            scale[i] = gyro;
+            scale[i + 3] = accel;
+        }
+    }
+    if (info->axes == 9)
+    {
+        for (int i = 6; i < 9; ++i)
+            scale[i] = mag;
+    }
+}
+
+/**
+ * Combine the range codes of the decoded blocks into runs of blocks with the same scale. Blocks
+ * that were not decoded are part of the run before them, and the first run always starts at 0.
+ * If there are no range codes (the output is not integer), there is one run with a scale of 1.
+ *
+ * @param info  File information, from `axivity_read_header`
+ * @param out   Output storage, with the range code of each block
+ * @param scale Storage for the scale of each run, shape (runs, axes). NULL to only count the runs
+ * @param index Storage for the sample index of the start of each run. NULL to only count the runs
+ *
+ * @result Number of runs, at least 1
+ */
+long axivity_scale_runs(AX_Info_t *info, AX_Output_t *out, double *scale, long *index)
+{
+    unsigned char last = AX_RANGE_NONE;
+    long k = 0;
+
+    for (long r = 0; out->range && (r < out->n_range); ++r)
+    {
+        if ((out->range[r] == AX_RANGE_NONE) || (out->range[r] == last))
+            continue;
+        last = out->range[r];
+
+        if (scale && index)
+        {
+            axivity_range_scales(info, last, scale + k * info->axes);
+            index[k] = k == 0 ? 0 : r * info->count;
+        }
+        k += 1;
+    }
+
+    if (k == 0)
+    {
+        if (scale && index)
+        {
+            for (int a = 0; a < info->axes; ++a)
+                scale[a] = 1.0;
+            index[0] = 0;
+        }
+        k = 1;
+    }
+    return k;
+}
+
+/**
+ * Make sure there is window index storage for one more block, and pass its size on to the
+ * decoder. Does nothing if there are no windows.
+ *
+ * @param info  File information, from `axivity_read_header`
+ * @param winfo Windowing information
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_window_reserve(AX_Info_t *info, Window_t *winfo)
+{
+    if (info->Nwin > 0)
+    {
+        if (window_reserve(winfo) != 0)
+            return AX_READ_E_MEMORY;
+        info->max_days = winfo->max_days;
+    }
+    return AX_READ_E_NONE;
+}
+
+/**
+ * Get the location of a data block in storage that starts at an arbitrary sample in the file,
+ * from its sequence number. Blocks with a sequence number that would put their data outside of
+ * the storage are counted as bad blocks (this only happens in corrupted files).
+ *
+ * @param info   File information, from `axivity_read_header`
+ * @param block  Start of the 512 byte data block
+ * @param offset Sample index (in the file) of the first sample in the storage
+ * @param n      Number of samples the storage holds
+ *
+ * @result Index in the storage of the first sample of the block, or -1 if it does not fit
+ */
+long axivity_block_start(AX_Info_t *info, char *block, long offset, long n)
+{
+    int32_t seq;
+    long i0;
+
+    memcpy(&seq, block + 10, sizeof(seq));
+    /* same as the decoder, unpacked data has at most 80 samples per block */
+    if (((block[25] & 0x0f) == 2) && (info->count > 80))
+        info->count = 80;
+
+    i0 = (long)seq * info->count - offset;
+    if ((seq < 0) || (info->count <= 0) || (i0 < 0) || (i0 > n - info->count))
+    {
+        info->n_bad_blocks += 1;
+        info->tLast = -1.0;
+        return -1;
+    }
+    return i0;
+}
+
+/**
+ * Decode a single data block into storage that starts at an arbitrary sample in the file, and
+ * is of any of the output data types. Timestamps are always double.
+ *
+ * Integer output is the raw counts of the block, and the range code of the block is stored so
+ * that the scale of each block is known.
+ *
+ * @param info   File information, from `axivity_read_header`
+ * @param block  Start of the 512 byte data block
+ * @param out    Output type and storage, if not double
+ * @param imu    IMU data storage, if `out->dtype` is double
+ * @param ts     Timestamp storage
+ * @param temp   Temperature storage, if `out->dtype` is double
+ * @param winfo  Windowing information, and window index storage
+ * @param repair Timestamp repair state, or NULL to leave the timestamps of bad blocks as 0
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_decode_block_as(AX_Info_t *info, char *block, AX_Output_t *out, double *imu, double *ts,
+    double *temp, Window_t *winfo, AX_Repair_t *repair)
+{
+    double imu_s[AX_MAX_BLOCK_VALUES], temp_s[AX_MAX_BLOCK_SAMPLES], scale[9];
+    int ierr = AX_READ_E_NONE;
+    long i0, n_bad = info->n_bad_blocks, v;
+    unsigned char range;
+
+    if ((i0 = axivity_block_start(info, block, out->offset, out->n)) < 0)
+        return AX_READ_E_NONE;
+
+    if ((ierr = axivity_window_reserve(info, winfo)) != AX_READ_E_NONE)
+        return ierr;
+
+    /* the decoder only writes the storage of the block, at `i0` (or the scratch space) */
+    if (out->dtype == READ_OUT_FLOAT64)
+    {
+        axivity_decode_block(info, block, imu + i0 * info->axes, ts + i0, temp + i0, winfo->bases,
+            winfo->periods, winfo->starts, winfo->i_start, winfo->stops, winfo->i_stop, &ierr);
+        if ((ierr != AX_READ_E_NONE) || (info->n_bad_blocks != n_bad))
+            return ierr;
+
+        if (out->filled)
+            out->filled[i0 / info->count] = 1;
+        return repair ? axivity_repair_block(info, repair, ts, i0) : AX_READ_E_NONE;
+    }
+
+    axivity_decode_block(info, block, imu_s, ts + i0, temp_s, winfo->bases, winfo->periods,
+        winfo->starts, winfo->i_start, winfo->stops, winfo->i_stop, &ierr);
+
+    /* bad blocks are not written, see `axivity_clear_undecoded` */
+    if ((ierr != AX_READ_E_NONE) || (info->n_bad_blocks != n_bad))
+        return ierr;
+    if (out->filled)
+        out->filled[i0 / info->count] = 1;
+
+    if (out->dtype == READ_OUT_FLOAT32)
+    {
+        float *o = (float *)out->imu + i0 * info->axes;
+        for (int k = 0; k < info->count * info->axes; ++k)
+            o[k] = (float)imu_s[k];
+    }
+    else
+    {
+        /* the decoded values are the counts divided by the scale of this block, so this is exact */
+        range = axivity_block_range(block);
+        axivity_range_scales(info, range, scale);
+        if (out->range && (i0 / info->count < out->n_range))
+            out->range[i0 / info->count] = range;
+
+        int16_t *o = (int16_t *)out->imu + i0 * info->axes;
+        for (int j = 0; j < info->count; ++j)
+        {
+            for (int a = 0; a < info->axes; ++a)
+            {
+                v = lrint(imu_s[j * info->axes + a] * scale[a]);
+                v = v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+                o[j * info->axes + a] = (int16_t)v;
+            }
+        }
+    }
+
+    for (int j = 0; j < info->count; ++j)
+        out->temp[i0 + j] = (float)temp_s[j];
+
+    return repair ? axivity_repair_block(info, repair, ts, i0) : AX_READ_E_NONE;
+}
+
+/* clear the timestamps in [start, stop) that are not part of a repaired run. `r` is the first run
+that could overlap, and is updated for the next call. Runs are in order, and do not overlap */
+static void clear_unrepaired(AX_Repair_t *repair, long *r, double *ts, long start, long stop)
+{
+    long *runs = repair ? repair->runs : NULL, n = repair ? repair->n : 0, next;
+
+    while ((*r < n) && (runs[2 * *r + 1] <= start))
+        *r += 1;
+
+    while (start < stop)
+    {
+        if ((*r < n) && (runs[2 * *r] <= start))
+        {
+            /* inside a run, skip to its end */
+            start = runs[2 * *r + 1];
+            *r += 1;
+            continue;
+        }
+        next = ((*r < n) && (runs[2 * *r] < stop)) ? runs[2 * *r] : stop;
+        memset(ts + start, 0, (next - start) * sizeof(double));
+        start = next;
+    }
+}
+
+/**
+ * Clear the storage of the blocks that were not decoded, ie bad blocks, and any blocks of the
+ * storage that no data block was decoded into. The storage then does not need to be cleared
+ * before decoding. Sensor data and temperature are set to 0, as are timestamps, except for the
+ * repaired runs of bad blocks, which keep their filled in timestamps.
+ *
+ * @param info   File information, with the state after decoding
+ * @param out    Output type and storage, with the blocks that were decoded marked in `filled`
+ * @param imu    IMU data storage, if `out->dtype` is double
+ * @param ts     Timestamp storage
+ * @param temp   Temperature storage, if `out->dtype` is double
+ * @param repair Timestamp repair state after `axivity_repair_finish`, or NULL if not repaired
+ */
+void axivity_clear_undecoded(AX_Info_t *info, AX_Output_t *out, double *imu, double *ts,
+    double *temp, AX_Repair_t *repair)
+{
+    size_t isize = out->dtype == READ_OUT_FLOAT64 ? sizeof(double)
+        : (out->dtype == READ_OUT_FLOAT32 ? sizeof(float) : sizeof(int16_t));
+    size_t tsize = out->dtype == READ_OUT_FLOAT64 ? sizeof(double) : sizeof(float);
+    char *imu_p = out->dtype == READ_OUT_FLOAT64 ? (char *)imu : (char *)out->imu;
+    char *temp_p = out->dtype == READ_OUT_FLOAT64 ? (char *)temp : (char *)out->temp;
+    long start, stop, r = 0;
+
+    if (!out->filled || (info->count <= 0))
+        return;
+
+    for (long b = 0; (b < out->n_filled) && (b * info->count < out->n); ++b)
+    {
+        if (out->filled[b])
+            continue;
+        /* the storage can end part way through a block */
+        start = b * info->count;
+        stop = start + info->count < out->n ? start + info->count : out->n;
+
+        memset(imu_p + start * info->axes * isize, 0, (stop - start) * info->axes * isize);
+        memset(temp_p + start * tsize, 0, (stop - start) * tsize);
+        clear_unrepaired(repair, &r, ts, start, stop);
+    }
+}
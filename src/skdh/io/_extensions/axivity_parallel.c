@@ -0,0 +1,201 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include <pthread.h>
+
+#include "read_binary_imu.h"
+
+/* work for a single decoding thread */
+typedef struct {
+    AX_Info_t info;  /* thread local copy of the file information */
+    char *data;  /* start of the memory mapped file */
+    int start;  /* first block to decode */
+    int stop;  /* last block (+1) to decode */
+    AX_Output_t *out;
+    double *imu;
+    double *ts;
+    double *temp;
+    Window_t *winfo;
+    char *status;  /* status of each block, AX_Block_Status_t */
+    int ierr;
+} AX_Thread_t;
+
+
+/**
+ * Decode a contiguous range of data blocks. Run by each of the worker threads.
+ *
+ * @param arg Pointer to the AX_Thread_t work definition for this thread
+ */
+static void *axivity_decode_range(void *arg)
+{
+    AX_Thread_t *t = (AX_Thread_t *)arg;
+    long n_bad;
+
+    for (int i = t->start; i < t->stop; ++i)
+    {
+        n_bad = t->info.n_bad_blocks;
+
+        t->ierr = axivity_decode_block_as(&(t->info), t->data + 512 * (size_t)i, t->out, t->imu,
+            t->ts, t->temp, t->winfo, NULL);
+
+        if (t->ierr != AX_READ_E_NONE)
+            return NULL;
+
+        if (t->info.n_bad_blocks == n_bad)
+            t->status[i] = AX_BLOCK_GOOD;
+        else
+            t->status[i] = (t->info.tLast == -1.0) ? AX_BLOCK_BAD_RESET : AX_BLOCK_BAD;
+    }
+
+    return NULL;
+}
+
+/**
+ * Decode all the data blocks of a memory mapped axivity file across multiple threads.
+ *
+ * Each block maps to a fixed location in the output arrays, so the block range is split into
+ * contiguous chunks that are decoded independently. Block timestamps depend on the time of the
+ * previous block, and the window indices and timestamp repairs are accumulated in order, so these
+ * are computed afterwards in a (much cheaper) sequential pass over the block headers.
+ *
+ * With the end time of the previous block for every block from an index (`t_seed`), each thread
+ * starts from the right time, and the block times are only recomputed in the sequential pass if
+ * there are windows, or an index is being recorded.
+ *
+ * @param info    File information, from `axivity_read_header`
+ * @param data    Start of the memory mapped file
+ * @param workers Number of threads to use
+ * @param out     Output type and storage, if not double
+ * @param imu     IMU data storage
+ * @param ts      Timestamp storage
+ * @param temp    Temperature storage
+ * @param winfo   Windowing information, and window index storage
+ * @param repair  Timestamp repair state, or NULL to leave the timestamps of bad blocks as 0
+ * @param t_seed  End time of the last good block after each data block, from an index, or NULL
+ * @param index   Storage for the index records of each data block, or NULL to not record them
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_read_blocks_parallel(AX_Info_t *info, char *data, int workers, AX_Output_t *out,
+    double *imu, double *ts, double *temp, Window_t *winfo, AX_Repair_t *repair,
+    double *t_seed, Index_t *index)
+{
+    int nblocks = info->nblocks - 2;  /* 2 header blocks */
+    double ts_s[AX_MAX_BLOCK_SAMPLES], t_prev;
+    int ierr = AX_READ_E_NONE, chunk, refill, times;
+    int32_t seq;
+    long i0 = 0;
+
+    if (nblocks <= 0)
+        return AX_READ_E_NONE;
+    if (workers > nblocks)
+        workers = nblocks;
+    if (workers < 1)
+        workers = 1;
+
+    char *status = (char *)malloc(info->nblocks * sizeof(char));
+    int *range_start = (int *)calloc(info->nblocks, sizeof(int));
+    AX_Thread_t *work = (AX_Thread_t *)malloc(workers * sizeof(AX_Thread_t));
+    pthread_t *threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    int *started = (int *)calloc(workers, sizeof(int));
+
+    if (!status || !range_start || !work || !threads || !started)
+    {
+        free(status); free(range_start); free(work); free(threads); free(started);
+        return AX_READ_E_MEMORY;
+    }
+
+    chunk = (nblocks + workers - 1) / workers;
+
+    for (int k = 0; k < workers; ++k)
+    {
+        work[k].info = *info;
+        /* no windowing in the threads, these are computed sequentially afterwards */
+        work[k].info.Nwin = 0;
+        work[k].data = data;
+        work[k].start = 2 + k * chunk;
+        work[k].stop = 2 + (k + 1) * chunk < info->nblocks ? 2 + (k + 1) * chunk : info->nblocks;
+        work[k].out = out;
+        work[k].imu = imu;
+        work[k].ts = ts;
+        work[k].temp = temp;
+        work[k].winfo = winfo;
+        work[k].status = status;
+        work[k].ierr = AX_READ_E_NONE;
+
+        if (t_seed && (work[k].start > 2) && (work[k].start < info->nblocks))
+            work[k].info.tLast = t_seed[work[k].start - 3];
+        else if (work[k].start < info->nblocks)
+            range_start[work[k].start] = 1;
+
+        /* if a thread cannot be started, decode its blocks after the others are started */
+        started[k] = pthread_create(&threads[k], NULL, axivity_decode_range, &work[k]) == 0;
+    }
+
+    for (int k = 0; k < workers; ++k)
+    {
+        if (started[k])
+            pthread_join(threads[k], NULL);
+        else
+            axivity_decode_range(&work[k]);
+    }
+
+    for (int k = 0; k < workers; ++k)
+    {
+        if (work[k].ierr != AX_READ_E_NONE)
+        {
+            ierr = work[k].ierr;
+            break;
+        }
+        info->n_bad_blocks += work[k].info.n_bad_blocks;
+    }
+    /* unpacked data can adjust the number of samples per block */
+    info->count = work[0].info.count;
+
+    /* sequential pass for the block times and window indices. Only the first good block in
+    each thread's range might have been decoded with the wrong previous block time */
+    refill = 0;
+    times = !t_seed || (info->Nwin > 0) || index;
+    for (int i = 2; (i < info->nblocks) && (ierr == AX_READ_E_NONE); ++i)
+    {
+        if (range_start[i] && (i > 2))
+            refill = 1;
+
+        t_prev = info->tLast;
+        if (status[i] == AX_BLOCK_BAD_RESET)
+        {
+            info->tLast = -1.0;
+        }
+        else if (status[i] == AX_BLOCK_GOOD)
+        {
+            /* good blocks were checked to fit in the storage when they were decoded */
+            memcpy(&seq, data + 512 * (size_t)i + 10, sizeof(seq));
+            i0 = (long)seq * info->count - out->offset;
+
+            if (times)
+            {
+                if ((ierr = axivity_window_reserve(info, winfo)) != AX_READ_E_NONE)
+                    break;
+                axivity_block_time(info, data + 512 * (size_t)i, &refill, ts_s, winfo->bases,
+                    winfo->periods, winfo->starts, winfo->i_start, winfo->stops, winfo->i_stop);
+
+                if (refill)
+                    memcpy(ts + i0, ts_s, info->count * sizeof(double));
+                refill = 0;
+            }
+
+            if (repair)
+                ierr = axivity_repair_block(info, repair, ts, i0);
+        }
+
+        if (index)
+            axivity_index_block(index, i - 2, data + 512 * (size_t)i, status[i], t_prev,
+                status[i] == AX_BLOCK_GOOD ? ts[i0] : 0.0, info->tLast);
+    }
+
+    free(status);
+    free(range_start);
+    free(work);
+    free(threads);
+    free(started);
+
+    return ierr;
+}
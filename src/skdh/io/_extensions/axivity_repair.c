@@ -0,0 +1,204 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include "read_binary_imu.h"
+
+/*
+Bad blocks are left as 0 by the decoder, including their timestamps. Timestamps for runs of bad
+blocks are filled in as the blocks are decoded: whenever a good block is decoded past the end of
+the last good block, the samples in between are interpolated from the last sample of the last good
+block to the first sample of the new one. A run at the end is filled in by `axivity_repair_finish`.
+Each repaired run is recorded, so it can be reported back to the caller.
+
+The last good block can be before the start of the storage, when a file is read in chunks. Its end
+and last timestamp are then carried over from the previous chunk, so that runs of bad blocks are
+filled in exactly the same as when the whole file is read at once.
+*/
+
+/**
+ * Initialize the timestamp repair state.
+ *
+ * @param rep Repair state
+ */
+void axivity_repair_init(AX_Repair_t *rep)
+{
+    rep->end = 0;
+    rep->t_end = 0.0;
+    rep->n = 0;
+    rep->size = 0;
+    rep->runs = NULL;
+}
+
+/* record a repaired run of samples */
+static int repair_record(AX_Repair_t *rep, long start, long stop)
+{
+    long *tmp;
+
+    if (rep->n == rep->size)
+    {
+        rep->size = rep->size > 0 ? 2 * rep->size : 8;
+        if (!(tmp = (long *)realloc(rep->runs, 2 * rep->size * sizeof(long))))
+            return AX_READ_E_MEMORY;
+        rep->runs = tmp;
+    }
+    rep->runs[2 * rep->n] = start;
+    rep->runs[2 * rep->n + 1] = stop;
+    rep->n += 1;
+
+    return AX_READ_E_NONE;
+}
+
+/* fill in the timestamps of the samples in [start, stop), up to a good block starting at sample
+`i_next` at time `t_next`. Continues on from the last good block if there is one, otherwise steps
+back from the good block to the start of the file */
+static void repair_fill(AX_Info_t *info, AX_Repair_t *rep, double *ts, long start, long stop,
+    long i_next, double t_next)
+{
+    double t0, delta;
+
+    /* the run starts at the end of the last good block (or the start of the file), which can be
+    before `start` */
+    if (rep->t_end > 0.)
+        t0 = rep->t_end + 1. / info->frequency;
+    else
+        t0 = t_next - (i_next - rep->end) / info->frequency;
+    delta = (t_next - t0) / (i_next - rep->end);
+
+    for (long j = start; j < stop; ++j)
+        ts[j] = t0 + (j - rep->end) * delta;
+}
+
+/**
+ * Update the repair state with a good block, filling in the timestamps of any bad blocks between
+ * the last good block and this one. Good blocks have to be passed in order.
+ *
+ * @param info File information, from `axivity_read_header`
+ * @param rep  Repair state
+ * @param ts   Timestamp storage
+ * @param i0   Index in `ts` of the first sample of the good block
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_repair_block(AX_Info_t *info, AX_Repair_t *rep, double *ts, long i0)
+{
+    long start = rep->end > 0 ? rep->end : 0;
+    long len = i0 - start;
+
+    if (len > 0)
+    {
+        /* runs of bad blocks are always full blocks */
+        if (len % info->count != 0)
+            return AX_READ_E_BAD_LENGTH_ZERO_TIMESTAMPS;
+        if (repair_record(rep, start, i0) != AX_READ_E_NONE)
+            return AX_READ_E_MEMORY;
+
+        repair_fill(info, rep, ts, start, i0, i0, ts[i0]);
+    }
+
+    if (i0 + info->count > rep->end)
+    {
+        rep->end = i0 + info->count;
+        rep->t_end = ts[rep->end - 1];
+    }
+    return AX_READ_E_NONE;
+}
+
+/**
+ * Fill in the timestamps of a run of bad blocks at the end of the storage.
+ *
+ * @param info   File information, from `axivity_read_header`
+ * @param rep    Repair state
+ * @param ts     Timestamp storage
+ * @param n      Number of samples in `ts`
+ * @param i_next Index (relative to the start of `ts`) of the first sample of the next good block
+ *               after the storage, from `axivity_repair_next`
+ * @param t_next Time of the first sample of the next good block. If not positive, there is no
+ *               next good block, and the run continues on from the last good block at the
+ *               sampling frequency. The timestamps are set to 0 if there are no good blocks
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_repair_finish(AX_Info_t *info, AX_Repair_t *rep, double *ts, long n, long i_next,
+    double t_next)
+{
+    long start = rep->end > 0 ? rep->end : 0;
+    long len = n - start;
+
+    if (len <= 0)
+        return AX_READ_E_NONE;
+    if (len % info->count != 0)
+        return AX_READ_E_BAD_LENGTH_ZERO_TIMESTAMPS;
+
+    if ((t_next > 0.) && (i_next >= n))
+        repair_fill(info, rep, ts, start, n, i_next, t_next);
+    else if (rep->t_end > 0.)
+    {
+        for (long j = start; j < n; ++j)
+            ts[j] = rep->t_end + 1. / info->frequency + (j - rep->end) * (1. / info->frequency);
+    }
+    else
+    {
+        /* the storage is not cleared before decoding */
+        memset(ts + start, 0, len * sizeof(double));
+    }
+
+    if (repair_record(rep, start, n) != AX_READ_E_NONE)
+        return AX_READ_E_MEMORY;
+
+    return AX_READ_E_NONE;
+}
+
+/**
+ * Find the first good data block after the end of the storage, without decoding it, so that a
+ * run of bad blocks that continues past the end of the storage is filled in the same as if the
+ * whole file was read. Blocks are checked the same as the decoder does.
+ *
+ * @param info   File information, with the state after decoding the last block of the storage.
+ *               Not modified
+ * @param data   Start of the memory mapped data blocks that follow the storage
+ * @param n      Number of mapped data blocks
+ * @param offset Sample index (in the file) of the first sample in the storage
+ * @param i_next Storage for the index (relative to the storage) of the first sample of the block
+ * @param t_next Storage for the time of the first sample of the block
+ *
+ * @result 1 if a good block was found, otherwise 0
+ */
+int axivity_repair_next(AX_Info_t *info, char *data, long n, long offset, long *i_next,
+    double *t_next)
+{
+    AX_Info_t next = *info;
+    double ts[AX_MAX_BLOCK_SAMPLES];
+    int fill = 1, status;
+    int32_t seq;
+    char *block;
+
+    /* only the block time is needed */
+    next.Nwin = 0;
+
+    for (long i = 0; i < n; ++i)
+    {
+        block = data + 512 * (size_t)i;
+        if (axivity_block_status(&next, block, next.nblocks - 2, &status) != AX_READ_E_NONE)
+            return 0;
+        if (status != AX_BLOCK_GOOD)
+            continue;
+
+        axivity_block_time(&next, block, &fill, ts, NULL, NULL, NULL, NULL, NULL, NULL);
+        memcpy(&seq, block + 10, sizeof(seq));
+        *i_next = (long)seq * next.count - offset;
+        *t_next = ts[0];
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Free the repair state storage.
+ *
+ * @param rep Repair state
+ */
+void axivity_repair_free(AX_Repair_t *rep)
+{
+    free(rep->runs);
+    rep->runs = NULL;
+    rep->n = 0;
+    rep->size = 0;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include "read_binary_imu.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+Packed (packing code 0) samples are 32-bit words of three 10-bit signed values (x in the low bits,
+then y, then z), and a 2-bit exponent in the top bits that the values are shifted left by. The
+shifted values are at most 12 bits, so are exact as floats, and scaling by the (power of 2) range is
+exact as well.
+*/
+
+/**
+ * Unpack 4 packed samples into 12 axis-interleaved floats.
+ *
+ * @param data  Start of the 4 packed samples
+ * @param scale Value to multiply the unpacked values by
+ * @param out   Storage for the 12 values
+ */
+static inline void unpack4(const char *data, float scale, float *out)
+{
+#if defined(__SSE2__)
+    __m128i w = _mm_loadu_si128((const __m128i *)data);
+    /* 2^exponent for each sample, from the exponent bits of a float */
+    __m128 pow2 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_srli_epi32(w, 30),
+        _mm_set1_epi32(127)), 23));
+    __m128 s = _mm_mul_ps(pow2, _mm_set1_ps(scale));
+
+    /* move each 10-bit value to the top of the lane, and shift back down to sign extend */
+    __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(w, 22), 22)), s);
+    __m128 y = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(w, 12), 22)), s);
+    __m128 z = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(w, 2), 22)), s);
+
+    /* interleave to x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 */
+    __m128 xy_lo = _mm_unpacklo_ps(x, y);  /* x0 y0 x1 y1 */
+    __m128 xy_hi = _mm_unpackhi_ps(x, y);  /* x2 y2 x3 y3 */
+    __m128 z0x1 = _mm_shuffle_ps(z, xy_lo, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 y1z1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 z2x3 = _mm_shuffle_ps(z, xy_hi, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 y3z3 = _mm_shuffle_ps(xy_hi, z, _MM_SHUFFLE(3, 3, 3, 3));
+
+    _mm_storeu_ps(out, _mm_shuffle_ps(xy_lo, z0x1, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(out + 4, _mm_shuffle_ps(y1z1, xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_storeu_ps(out + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+#elif defined(__ARM_NEON)
+    int32x4_t w = vreinterpretq_s32_u8(vld1q_u8((const uint8_t *)data));
+    int32x4_t e = vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(w), 30));
+    float32x4x3_t v;
+
+    /* sign extend each 10-bit value, then shift left by the exponent */
+    v.val[0] = vcvtq_f32_s32(vshlq_s32(vshrq_n_s32(vshlq_n_s32(w, 22), 22), e));
+    v.val[1] = vcvtq_f32_s32(vshlq_s32(vshrq_n_s32(vshlq_n_s32(w, 12), 22), e));
+    v.val[2] = vcvtq_f32_s32(vshlq_s32(vshrq_n_s32(vshlq_n_s32(w, 2), 22), e));
+    v.val[0] = vmulq_n_f32(v.val[0], scale);
+    v.val[1] = vmulq_n_f32(v.val[1], scale);
+    v.val[2] = vmulq_n_f32(v.val[2], scale);
+
+    vst3q_f32(out, v);
+#else
+    uint32_t w;
+    int32_t v;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        memcpy(&w, data + 4 * i, sizeof(w));
+        for (int a = 0; a < 3; ++a)
+        {
+            v = (int32_t)(w << (22 - 10 * a)) >> 22;
+            out[3 * i + a] = (float)(v * (1 << (w >> 30))) * scale;
+        }
+    }
+#endif
+}
+
+/**
+ * Unpack the packed (packing code 0, 3 axis) samples of a data block into axis-interleaved doubles.
+ * Called from the fortran decoder.
+ *
+ * @param data  Start of the packed samples, 4 bytes per sample
+ * @param n     Number of samples, a multiple of 4 (always 120 for valid blocks)
+ * @param scale Value to multiply the unpacked values by, 1 / counts per unit
+ * @param out   Storage for the values, shape (n, 3)
+ */
+void axivity_unpack_packed(const char *data, int n, double scale, double *out)
+{
+    float tmp[12];
+
+    for (int i = 0; i + 4 <= n; i += 4)
+    {
+        unpack4(data + 4 * i, (float)scale, tmp);
+        for (int k = 0; k < 12; ++k)
+            out[3 * i + k] = (double)tmp[k];
+    }
+}
@@ -0,0 +1,368 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include "read_binary_imu.h"
+
+#define AX_HEADER_ACCEL 22593  /* "AX" */
+
+
+/**
+ * Get the time of the first sample of a data block from its header only, the same as `get_time`
+ * in read_axivity.f95 before the time is adjusted to the end of the previous block.
+ *
+ * @param block     Start of the 512 byte data block
+ * @param tm0       Storage for the broken down header timestamp
+ * @param ts_offset Storage for the sample index of the header timestamp
+ * @param freq      Storage for the sampling frequency of the block
+ *
+ * @result Time of the first sample in the block
+ */
+static double axivity_header_time(char *block, struct tm *tm0, int16_t *ts_offset, double *freq)
+{
+    uint32_t stamp;
+
+    memcpy(&stamp, block + 14, sizeof(stamp));
+    memcpy(ts_offset, block + 26, sizeof(*ts_offset));
+
+    memset(tm0, 0, sizeof(*tm0));
+    tm0->tm_year = (int)((stamp >> 26) & 0x3f) + 100;  /* years since 1900 */
+    tm0->tm_mon  = (int)((stamp >> 22) & 0x0f) - 1;
+    tm0->tm_mday = (int)((stamp >> 17) & 0x1f);
+    tm0->tm_hour = (int)((stamp >> 12) & 0x1f);
+    tm0->tm_min  = (int)((stamp >> 6) & 0x3f);
+    tm0->tm_sec  = (int)(stamp & 0x3f);
+
+    *freq = 3200.0 / (double)(1 << (15 - (block[24] & 0x0f)));
+    if (*freq <= 0.0)
+        *freq = 1.0;
+
+    return (double)timegm(tm0) - *ts_offset / *freq;
+}
+
+/**
+ * Compute the time of day and block duration of a data block, the same as `get_time` in
+ * read_axivity.f95 passes them to `get_day_indexing`.
+ *
+ * @param block    Start of the 512 byte data block
+ * @param t_prev   End time of the previous block, before the block time was computed
+ * @param t0       Time of the first sample of the block
+ * @param t1       End time of the block
+ * @param sec      Time of day of the block header timestamp, in whole seconds
+ * @param msec     Milliseconds from the header timestamp to the first sample. Can be negative
+ * @param duration Time delta of the block used for finding windows
+ */
+static void axivity_block_day(char *block, double t_prev, double t0, double t1, long *sec,
+    long *msec, double *duration)
+{
+    int16_t ts_offset, sample_count;
+    struct tm tm0;
+    double freq, t0_block;
+
+    t0_block = axivity_header_time(block, &tm0, &ts_offset, &freq);
+    memcpy(&sample_count, block + 28, sizeof(sample_count));
+
+    *sec = tm0.tm_hour * SECHOUR + tm0.tm_min * SECMIN + tm0.tm_sec;
+    *msec = (long)(-ts_offset / freq * 1000);
+
+    /* the block start is moved to the end of the previous block if they are close enough */
+    if ((t_prev > 0.0) && ((t0_block - t_prev) < 1.0))
+        *msec -= (long)((t0_block - t_prev) * 1000);
+
+    /* subtract a little bit so that windows are not missed */
+    *duration = t1 - t0 - 0.5 * ((t1 - t0) / sample_count);
+}
+
+/* header time of the first block at or after `i` with a valid header, or HUGE_VAL if none */
+static double axivity_search_time(char *data, long i, long nblocks)
+{
+    int16_t header, ts_offset;
+    struct tm tm0;
+    double freq;
+    char *block;
+
+    for (; i < nblocks; ++i)
+    {
+        block = data + 512 * (size_t)(i + 2);
+        memcpy(&header, block, sizeof(header));
+        if (header == AX_HEADER_ACCEL)
+            return axivity_header_time(block, &tm0, &ts_offset, &freq);
+    }
+    return HUGE_VAL;
+}
+
+/* first block in [lo, hi) whose header time is after `time`, or `hi` if none */
+static long axivity_search_blocks(char *data, long lo, long hi, long nblocks, double time)
+{
+    long mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (axivity_search_time(data, mid, nblocks) > time)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+/**
+ * Find the data blocks of a memory mapped axivity file that overlap a time range, with a binary
+ * search on the block header times. Data blocks are assumed to be stored in time order.
+ *
+ * @param info        File information, from `axivity_read_header`
+ * @param data        Start of the memory mapped file
+ * @param start_time  Start of the time range
+ * @param stop_time   End of the time range
+ * @param block_start Storage for the first data block overlapping the range
+ * @param block_stop  Storage for the data block after the last overlapping block
+ * @param t_last      Storage for the end time of the block before `block_start`, as it would be
+ *                    when reading the whole file. -1 if the block times are not continued
+ */
+void axivity_find_blocks(AX_Info_t *info, char *data, double start_time, double stop_time,
+    long *block_start, long *block_stop, double *t_last)
+{
+    double ts[AX_MAX_BLOCK_SAMPLES];
+    int16_t header, length;
+    int fill = 0;
+    long nblocks = info->nblocks - 2;
+    char *block;
+
+    /* the block containing the start time is the one before the first block after it. Block
+    times can be moved by up to a second from the header time to line up with the previous
+    block, so search a second past either end of the range */
+    *block_start = axivity_search_blocks(data, 0, nblocks, nblocks, start_time - 1.0) - 1;
+    if (*block_start < 0)
+        *block_start = 0;
+    *block_stop = axivity_search_blocks(data, *block_start, nblocks, nblocks, stop_time + 1.0);
+
+    /* the time of a block only depends on the end of the last good block before it. Packed
+    blocks that are bad reset it, unpacked blocks that are bad do not */
+    *t_last = -1.0;
+    info->Nwin = 0;
+    for (long i = *block_start - 1; i >= 0; --i)
+    {
+        block = data + 512 * (size_t)(i + 2);
+        memcpy(&header, block, sizeof(header));
+        memcpy(&length, block + 2, sizeof(length));
+
+        if ((header != AX_HEADER_ACCEL) || (length != 508))
+            break;
+        if ((block[25] & 0x0f) == 2)
+            info->count = info->count > 80 ? 80 : info->count;
+        if (info->verify && (axivity_block_checksum(info, block) != 0))
+        {
+            if ((block[25] & 0x0f) == 0)
+                break;
+            continue;
+        }
+
+        info->tLast = -1.0;
+        axivity_block_time(info, block, &fill, ts, NULL, NULL, NULL, NULL, NULL, NULL);
+        *t_last = info->tLast;
+        break;
+    }
+}
+
+/**
+ * Compute the window start and stop indices from the block times stored in an index, without
+ * reading the file. Blocks are processed in order, skipping any that are not good, and give the
+ * same indices as reading the file.
+ *
+ * @param fs            Sampling frequency
+ * @param block_samples Number of samples in each block
+ * @param max_n         Number of blocks in the file
+ * @param nblocks       Number of blocks in the index
+ * @param block_n       Block number to index from for each block
+ * @param status        Status of each block. Only blocks with status 0 are used
+ * @param day           Time of day and block duration of each block
+ * @param winfo         Window information, and window index storage
+ *
+ * @result 0 if successful, -1 if the window index storage could not be grown
+ */
+int index_day_indexing(double fs, long block_samples, long max_n, long nblocks, long *block_n,
+    char *status, Index_Day_t *day, Window_t *winfo)
+{
+    Time_t t;
+
+    t.hour = 0;
+    t.min = 0;
+
+    for (long i = 0; i < nblocks; ++i)
+    {
+        if (status[i] != 0)
+            continue;
+
+        t.sec = day->sec[i];
+        t.msec = day->msec[i];
+
+        if (window_reserve(winfo) != 0)
+            return -1;
+
+        get_day_indexing(&fs, &t, &(day->duration[i]), &(winfo->max_days), &(winfo->n),
+            winfo->bases, winfo->periods, &block_n[i], &max_n, &block_samples, winfo->starts,
+            winfo->i_start, winfo->stops, winfo->i_stop);
+    }
+    return 0;
+}
+
+/**
+ * Check a data block the same as the decoder does, without decoding the data. Bad blocks are
+ * counted, and reset the previous block time if the decoder would.
+ *
+ * @param info    File information, from `axivity_read_header`
+ * @param block   Start of the 512 byte data block
+ * @param nblocks Number of data blocks in the file
+ * @param status  Storage for the AX_Block_Status_t of the block
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_block_status(AX_Info_t *info, char *block, long nblocks, int *status)
+{
+    int16_t header, length;
+    int32_t seq;
+
+    memcpy(&header, block, sizeof(header));
+    memcpy(&length, block + 2, sizeof(length));
+    memcpy(&seq, block + 10, sizeof(seq));
+
+    if ((header != AX_HEADER_ACCEL) || (length != 508) || (seq < 0) || (seq >= nblocks))
+    {
+        *status = AX_BLOCK_BAD_RESET;
+        info->n_bad_blocks += 1;
+        info->tLast = -1.0;
+        return AX_READ_E_NONE;
+    }
+
+    if ((block[25] & 0x0f) == 0)
+    {
+        if (info->axes != 3)
+            return AX_READ_E_BAD_AXES_PACKED;
+        if (info->count != 120)
+            return AX_READ_E_INVALID_BLOCK_SAMPLES;
+    }
+    else if ((block[25] & 0x0f) == 2)
+    {
+        info->count = info->count > 80 ? 80 : info->count;
+        if (info->count < 0)
+            return AX_READ_E_INVALID_BLOCK_SAMPLES;
+    }
+    else
+        return AX_READ_E_BAD_PACKING_CODE;
+
+    *status = AX_BLOCK_GOOD;
+    if (info->verify && (axivity_block_checksum(info, block) != 0))
+    {
+        /* only packed data resets the previous block time */
+        *status = (block[25] & 0x0f) == 0 ? AX_BLOCK_BAD_RESET : AX_BLOCK_BAD;
+        info->n_bad_blocks += 1;
+        if (*status == AX_BLOCK_BAD_RESET)
+            info->tLast = -1.0;
+    }
+    return AX_READ_E_NONE;
+}
+
+/**
+ * Record a data block in an index, as it is read. Bad blocks have no time of day, and are skipped
+ * when computing window indices from the index.
+ *
+ * @param index  Index storage
+ * @param i      Data block number, not counting the header blocks
+ * @param block  Start of the 512 byte data block
+ * @param status AX_Block_Status_t of the block
+ * @param t_prev End time of the previous block, before the block time was computed
+ * @param t0     Time of the first sample of the block. Ignored for bad blocks
+ * @param t_last End time of the last good block after reading the block
+ */
+void axivity_index_block(Index_t *index, long i, char *block, int status, double t_prev, double t0,
+    double t_last)
+{
+    int16_t sample_count;
+    int32_t seq;
+
+    memcpy(&seq, block + 10, sizeof(seq));
+    memcpy(&sample_count, block + 28, sizeof(sample_count));
+
+    index->seq[i] = (long)seq;
+    index->count[i] = (long)sample_count;
+    index->status[i] = (char)status;
+    index->t_last[i] = t_last;
+    index->time[i] = 0.0;
+    index->day.sec[i] = 0;
+    index->day.msec[i] = 0;
+    index->day.duration[i] = 0.0;
+
+    if (status != AX_BLOCK_GOOD)
+        return;
+
+    index->time[i] = t0;
+    axivity_block_day(block, t_prev, t0, t_last, &index->day.sec[i], &index->day.msec[i],
+        &index->day.duration[i]);
+}
+
+/**
+ * Record a data block in an index after it was decoded by `axivity_decode_block_as`, from the
+ * change in the decoder state.
+ *
+ * @param info   File information, after decoding the block
+ * @param index  Index storage
+ * @param i      Data block number, not counting the header blocks
+ * @param block  Start of the 512 byte data block
+ * @param n_bad  Number of bad blocks before decoding the block
+ * @param t_prev End time of the previous block, before decoding the block
+ * @param ts     Timestamp storage the block was decoded into
+ * @param offset Sample index (in the file) of the first sample in `ts`
+ */
+void axivity_index_decoded(AX_Info_t *info, Index_t *index, long i, char *block, long n_bad,
+    double t_prev, double *ts, long offset)
+{
+    int32_t seq;
+
+    if (info->n_bad_blocks != n_bad)
+    {
+        axivity_index_block(index, i, block,
+            info->tLast == -1.0 ? AX_BLOCK_BAD_RESET : AX_BLOCK_BAD, t_prev, 0.0, info->tLast);
+        return;
+    }
+
+    /* good blocks were decoded into the storage at their sequence number */
+    memcpy(&seq, block + 10, sizeof(seq));
+    axivity_index_block(index, i, block, AX_BLOCK_GOOD, t_prev,
+        ts[(long)seq * info->count - offset], info->tLast);
+}
+
+/**
+ * Scan the block headers of a memory mapped axivity file, without decoding the data. Block times
+ * are computed the same as when reading the file.
+ *
+ * @param info  File information, from `axivity_read_header`
+ * @param data  Start of the memory mapped file
+ * @param index Storage for the index records of each data block
+ *
+ * @result Read_Cwa_Error_t error value
+ */
+int axivity_read_index(AX_Info_t *info, char *data, Index_t *index)
+{
+    double ts[AX_MAX_BLOCK_SAMPLES], t_prev;
+    int fill = 1, block_status, ierr;
+    long nblocks = info->nblocks - 2;
+    char *block;
+
+    /* windows are not needed, and the time of only one block is stored at a time */
+    ts[0] = 0.0;
+    info->Nwin = 0;
+
+    for (long i = 0; i < nblocks; ++i)
+    {
+        block = data + 512 * (size_t)(i + 2);
+
+        if ((ierr = axivity_block_status(info, block, nblocks, &block_status)) != AX_READ_E_NONE)
+            return ierr;
+
+        t_prev = info->tLast;
+        if (block_status == AX_BLOCK_GOOD)
+            axivity_block_time(info, block, &fill, ts, NULL, NULL, NULL, NULL, NULL, NULL);
+
+        axivity_index_block(index, i, block, block_status, t_prev, ts[0], info->tLast);
+    }
+
+    return AX_READ_E_NONE;
+}
@@ -0,0 +1,189 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include <pthread.h>
+
+#include "read_binary_imu.h"
+
+#define GN_PAGE_MARKER "Recorded Data"
+#define GN_PAGE_MARKER_LEN 13
+
+/* work for a single parsing thread */
+typedef struct {
+    GN_Info_t *info;
+    GN_Data_t *data;
+    char **pages;  /* start of each page, plus the end of the last page */
+    GN_Page_t *page_info;
+    int *status;  /* Read_Bin_Error_t of each page */
+    long start;  /* first page to parse */
+    long stop;  /* last page (+1) to parse */
+} GN_Thread_t;
+
+
+/**
+ * Parse a contiguous range of pages. Run by each of the worker threads.
+ *
+ * @param arg Pointer to the GN_Thread_t work definition for this thread
+ */
+static void *geneactiv_parse_range(void *arg)
+{
+    GN_Thread_t *t = (GN_Thread_t *)arg;
+
+    for (long i = t->start; i < t->stop; ++i)
+        t->status[i] = geneactiv_parse_page(t->pages[i], t->pages[i + 1], t->info, t->data,
+            &(t->page_info[i]));
+
+    return NULL;
+}
+
+/**
+ * Find the start of each page of a memory mapped GeneActiv file, from the "Recorded Data" line
+ * that starts each page.
+ *
+ * @param data      Start of the memory mapped file
+ * @param size      Size of the file
+ * @param offset    Offset of the first page, ie the end of the header
+ * @param max_pages Maximum number of pages to find
+ * @param pages     Storage for the start of each page, plus the end of the last page. Size of
+ *                  `max_pages + 1`
+ *
+ * @result Number of pages found
+ */
+static long geneactiv_find_pages(char *data, size_t size, size_t offset, long max_pages,
+    char **pages)
+{
+    char *pos = data + offset, *end = data + size, *nl;
+    long n = 0;
+
+    while ((pos < end) && (n < max_pages))
+    {
+        if (((size_t)(end - pos) >= GN_PAGE_MARKER_LEN)
+            && (memcmp(pos, GN_PAGE_MARKER, GN_PAGE_MARKER_LEN) == 0))
+            pages[n++] = pos;
+
+        nl = memchr(pos, '\n', end - pos);
+        pos = nl ? nl + 1 : end;
+    }
+    /* the last page ends at the next "Recorded Data" line or the end of the file */
+    if (n > 0)
+    {
+        while (pos < end)
+        {
+            if (((size_t)(end - pos) >= GN_PAGE_MARKER_LEN)
+                && (memcmp(pos, GN_PAGE_MARKER, GN_PAGE_MARKER_LEN) == 0))
+                break;
+            nl = memchr(pos, '\n', end - pos);
+            pos = nl ? nl + 1 : end;
+        }
+    }
+    pages[n] = pos;
+
+    return n;
+}
+
+/**
+ * Parse all the pages of a memory mapped GeneActiv file across multiple threads.
+ *
+ * Each page maps to a fixed location in the output arrays from its sequence number, so the pages
+ * are split into contiguous ranges that are parsed independently. The sampling frequency checks
+ * and window indices depend on the previous pages, so these are done afterwards in a (much
+ * cheaper) sequential pass over the pages.
+ *
+ * @param info    File information, from `geneactiv_read_header`
+ * @param data    Start of the memory mapped file
+ * @param size    Size of the file
+ * @param offset  Offset of the first page, ie the end of the header
+ * @param workers Number of threads to use
+ * @param winfo   Windowing information
+ * @param out     Output storage
+ * @param fs_warn Set to 1 if a page sampling frequency did not match the header
+ * @param index   Storage for the index records of each page, or NULL to not record them
+ * @param n_index Storage for the number of pages recorded in `index`
+ *
+ * @result Read_Bin_Error_t error value. GN_READ_E_BLOCK_MISSING_BLOCK_WARN if there are fewer
+ *         pages in the file than in the header.
+ */
+int geneactiv_read_pages_parallel(GN_Info_t *info, char *data, size_t size, size_t offset,
+    int workers, Window_t *winfo, GN_Data_t *out, int *fs_warn, Index_t *index, long *n_index)
+{
+    long npages, chunk;
+    int ierr = GN_READ_E_NONE;
+
+    *fs_warn = 0;
+    *n_index = 0;
+    if (info->npages <= 0)
+        return GN_READ_E_NONE;
+
+    char **pages = (char **)malloc((info->npages + 1) * sizeof(char *));
+    GN_Page_t *page_info = (GN_Page_t *)malloc(info->npages * sizeof(GN_Page_t));
+    int *status = (int *)malloc(info->npages * sizeof(int));
+    GN_Thread_t *work = (GN_Thread_t *)malloc((workers > 0 ? workers : 1) * sizeof(GN_Thread_t));
+    pthread_t *threads = (pthread_t *)malloc((workers > 0 ? workers : 1) * sizeof(pthread_t));
+    int *started = (int *)calloc(workers > 0 ? workers : 1, sizeof(int));
+
+    if (!pages || !page_info || !status || !work || !threads || !started)
+    {
+        free(pages); free(page_info); free(status); free(work); free(threads); free(started);
+        return GN_READ_E_MEMORY;
+    }
+
+    npages = geneactiv_find_pages(data, size, offset, info->npages, pages);
+
+    if (workers > npages)
+        workers = (int)npages;
+    if (workers < 1)
+        workers = 1;
+    chunk = (npages + workers - 1) / workers;
+
+    for (int k = 0; k < workers; ++k)
+    {
+        work[k].info = info;
+        work[k].data = out;
+        work[k].pages = pages;
+        work[k].page_info = page_info;
+        work[k].status = status;
+        work[k].start = k * chunk < npages ? k * chunk : npages;
+        work[k].stop = (k + 1) * chunk < npages ? (k + 1) * chunk : npages;
+
+        /* if a thread cannot be started, parse its pages after the others are started */
+        started[k] = pthread_create(&threads[k], NULL, geneactiv_parse_range, &work[k]) == 0;
+    }
+
+    for (int k = 0; k < workers; ++k)
+    {
+        if (started[k])
+            pthread_join(threads[k], NULL);
+        else
+            geneactiv_parse_range(&work[k]);
+    }
+
+    /* sequential pass for the sampling frequency, window indices, and index records */
+    for (long i = 0; i < npages; ++i)
+    {
+        ierr = status[i];
+        if (ierr == GN_READ_E_NONE)
+            ierr = geneactiv_finish_page(&page_info[i], info, winfo);
+
+        if (ierr == GN_READ_E_BLOCK_FS_WARN)
+        {
+            *fs_warn = 1;
+            ierr = GN_READ_E_NONE;
+        }
+        if (ierr != GN_READ_E_NONE)
+            break;
+
+        if (index)
+            geneactiv_index_page(index, (*n_index)++, page_info[i].seq, &page_info[i].t,
+                page_info[i].t0, info->fs, 0);
+    }
+
+    if ((ierr == GN_READ_E_NONE) && (npages < info->npages))
+        ierr = GN_READ_E_BLOCK_MISSING_BLOCK_WARN;
+
+    free(pages);
+    free(page_info);
+    free(status);
+    free(work);
+    free(threads);
+    free(started);
+
+    return ierr;
+}
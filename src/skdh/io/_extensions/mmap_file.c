@@ -0,0 +1,125 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "read_binary_imu.h"
+
+/**
+ * Memory map a file for reading
+ *
+ * @param file Name of the file to map
+ * @param mf   Storage for the mapping information
+ *
+ * @result 0 if successful, -1 if the file could not be opened or mapped
+ */
+int map_file(const char *file, MappedFile_t *mf)
+{
+    struct stat st;
+
+    mf->fd = -1;
+    mf->data = NULL;
+    mf->size = 0;
+    mf->pad = 0;
+
+    mf->fd = open(file, O_RDONLY);
+    if (mf->fd == -1)
+        return -1;
+
+    if ((fstat(mf->fd, &st) == -1) || (st.st_size == 0))
+    {
+        close(mf->fd);
+        mf->fd = -1;
+        return -1;
+    }
+    mf->size = (size_t)st.st_size;
+
+    mf->data = (char *)mmap(NULL, mf->size, PROT_READ, MAP_PRIVATE, mf->fd, 0);
+    if (mf->data == MAP_FAILED)
+    {
+        close(mf->fd);
+        mf->fd = -1;
+        mf->data = NULL;
+        return -1;
+    }
+
+    /* reading is (mostly) front to back, let the kernel read ahead aggressively */
+    madvise(mf->data, mf->size, MADV_SEQUENTIAL);
+
+    return 0;
+}
+
+/**
+ * Memory map part of a file for reading. Only the pages covering the requested range are mapped,
+ * which keeps the address space (and resident memory) bounded when reading a file piece by piece.
+ *
+ * @param file   Name of the file to map
+ * @param offset Offset in bytes of the start of the range
+ * @param length Length in bytes of the range
+ * @param mf     Storage for the mapping information. `data` points to `offset` in the file
+ *
+ * @result 0 if successful, -1 if the file could not be opened/mapped, or is shorter than the range
+ */
+int map_file_range(const char *file, size_t offset, size_t length, MappedFile_t *mf)
+{
+    struct stat st;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    char *map;
+
+    mf->fd = -1;
+    mf->data = NULL;
+    mf->size = 0;
+    mf->pad = 0;
+
+    if (length == 0)
+        return -1;
+
+    mf->fd = open(file, O_RDONLY);
+    if (mf->fd == -1)
+        return -1;
+
+    if ((fstat(mf->fd, &st) == -1) || ((size_t)st.st_size < offset + length))
+    {
+        close(mf->fd);
+        mf->fd = -1;
+        return -1;
+    }
+
+    /* mappings have to start on a page boundary */
+    mf->pad = offset % page;
+    mf->size = length;
+
+    map = (char *)mmap(NULL, mf->size + mf->pad, PROT_READ, MAP_PRIVATE, mf->fd, (off_t)(offset - mf->pad));
+    if (map == MAP_FAILED)
+    {
+        close(mf->fd);
+        mf->fd = -1;
+        mf->size = 0;
+        mf->pad = 0;
+        return -1;
+    }
+    mf->data = map + mf->pad;
+
+    madvise(map, mf->size + mf->pad, MADV_SEQUENTIAL);
+
+    return 0;
+}
+
+/**
+ * Unmap and close a file mapped with `map_file` or `map_file_range`
+ *
+ * @param mf Mapping information to cleanup
+ */
+void unmap_file(MappedFile_t *mf)
+{
+    if (mf->data)
+        munmap(mf->data - mf->pad, mf->size + mf->pad);
+    if (mf->fd != -1)
+        close(mf->fd);
+
+    mf->fd = -1;
+    mf->data = NULL;
+    mf->size = 0;
+    mf->pad = 0;
+}
@@ -26,6 +26,15 @@ void geneactiv_set_error_message(int ierr)
         case GN_READ_E_BLOCK_DATA_3600 :
             PyErr_SetString(PyExc_RuntimeError, "Data length is shorter than 3600");
             break;
+        case GN_READ_E_BLOCK_SEQUENCE :
+            PyErr_SetString(PyExc_RuntimeError, "Page sequence number is larger than the number of pages");
+            break;
+        case GN_READ_E_MEMORY :
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate memory for reading pages");
+            break;
+        case GN_READ_E_MMAP :
+            PyErr_SetString(PyExc_IOError, "Error memory mapping file");
+            break;
         default :
             PyErr_SetString(PyExc_RuntimeError, "Unknown error reading GeneActiv file");
     }
@@ -56,34 +65,266 @@ void axivity_set_error_message(int ierr)
         case AX_READ_E_BAD_LENGTH_ZERO_TIMESTAMPS :
             PyErr_SetString(PyExc_RuntimeError, "Bad block of timestamps not equal to data block sample size.");
             break;
+        case AX_READ_E_MEMORY :
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate memory for decoding.");
+            break;
+        case AX_READ_E_FILE_OPEN :
+            PyErr_SetString(PyExc_IOError, "Error opening file.");
+            break;
+        case AX_READ_E_FILE_READ :
+            PyErr_SetString(PyExc_IOError, "Error reading file, file may be truncated.");
+            break;
         default :
             PyErr_SetString(PyExc_RuntimeError, "Unknown error reading Axivity file");
     }
 }
 
+/* get the output data type from its name. Sets the error if the name is not valid */
+static int get_output_type(const char *name)
+{
+    if (strcmp(name, "float64") == 0)
+        return READ_OUT_FLOAT64;
+    if (strcmp(name, "float32") == 0)
+        return READ_OUT_FLOAT32;
+    if (strcmp(name, "int16") == 0)
+        return READ_OUT_INT16;
+
+    PyErr_Format(PyExc_ValueError, "`dtype` must be one of 'float64', 'float32', or 'int16', not '%s'.", name);
+    return -1;
+}
+
+/* numpy types for the sensor data, and other (temperature, light) data for each output type */
+static int sensor_npy_type(int dtype)
+{
+    return dtype == READ_OUT_INT16 ? NPY_INT16 : (dtype == READ_OUT_FLOAT32 ? NPY_FLOAT : NPY_DOUBLE);
+}
+
+static int other_npy_type(int dtype)
+{
+    return dtype == READ_OUT_FLOAT64 ? NPY_DOUBLE : NPY_FLOAT;
+}
+
+/* convert timestamps in seconds to integer nanoseconds, in place */
+static void timestamps_to_ns(double *ts, npy_intp n)
+{
+    double t;
+    int64_t ns;
+
+    for (npy_intp i = 0; i < n; ++i)
+    {
+        memcpy(&t, ts + i, sizeof(t));
+        ns = llround(t * 1e9);
+        memcpy(ts + i, &ns, sizeof(ns));
+    }
+}
+
+/* copy the rows of window indices that were used to a new (rows, windows) array */
+static PyArrayObject *window_array(Window_t *winfo, long *src)
+{
+    npy_intp dims[2] = {window_rows(winfo), winfo->n};
+    PyArrayObject *arr = (PyArrayObject *)PyArray_ZEROS(2, dims, NPY_LONG, 0);
+
+    if (arr && (dims[0] * dims[1] > 0))
+        memcpy(PyArray_DATA(arr), src, dims[0] * dims[1] * sizeof(long));
+    return arr;
+}
+
+/* output array of shape `dims`. If `buf` is an array (not NULL or None), the output is a view of
+the start of it, which has to be a writeable, C-contiguous array of the same type with at least as
+many elements. Neither is cleared, the readers clear only what they do not write after reading */
+static PyArrayObject *output_array(PyObject *buf, const char *name, int nd, npy_intp *dims, int type)
+{
+    PyArrayObject *arr;
+    npy_intp size = PyArray_MultiplyList(dims, nd);
+
+    if (!buf || (buf == Py_None))
+        return (PyArrayObject *)PyArray_EMPTY(nd, dims, type, 0);
+
+    if (!PyArray_Check(buf)
+        || !PyArray_EquivTypenums(PyArray_TYPE((PyArrayObject *)buf), type)
+        || !PyArray_ISCARRAY((PyArrayObject *)buf)
+        || (PyArray_SIZE((PyArrayObject *)buf) < size))
+    {
+        PyErr_Format(PyExc_ValueError, "`%s` must be a writeable, C-contiguous array of the output type "
+            "with at least %zd elements.", name, (Py_ssize_t)size);
+        return NULL;
+    }
+
+    arr = (PyArrayObject *)PyArray_NewFromDescr(&PyArray_Type, PyArray_DescrFromType(type), nd, dims,
+        NULL, PyArray_DATA((PyArrayObject *)buf), NPY_ARRAY_CARRAY, NULL);
+    if (!arr)
+        return NULL;
+    Py_INCREF(buf);
+    if (PyArray_SetBaseObject(arr, buf) < 0)
+    {
+        Py_DECREF(arr);
+        return NULL;
+    }
+    return arr;
+}
+
+/* storage named `name` for `size` elements of `type` from `buffers`, a `skdh.io.ReadBuffers`, for
+`output_array`. Returns a new reference, or None if there are no buffers or storage is already given
+in `out` */
+static PyObject *buffer_array(PyObject *buffers, PyObject *out, const char *name, npy_intp size, int type)
+{
+    PyArray_Descr *descr;
+    PyObject *buf;
+
+    if (!buffers || (buffers == Py_None) || (out && (out != Py_None)))
+    {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    if (!(descr = PyArray_DescrFromType(type)))
+        return NULL;
+    buf = PyObject_CallMethod(buffers, "get", "snO", name, (Py_ssize_t)size, (PyObject *)descr);
+    Py_DECREF(descr);
+    return buf;
+}
+
+/* storage for which blocks were decoded, and range code storage for integer output, one for each
+block the output storage can hold */
+static int output_range_init(AX_Info_t *info, AX_Output_t *out)
+{
+    /* unpacked blocks can have fewer samples than the first block says */
+    long count = info->count > 80 ? 80 : info->count;
+    long n_blocks = count > 0 ? out->n / count + 1 : 1;
+
+    out->range = NULL;
+    out->n_range = 0;
+    out->n_filled = n_blocks;
+    if (!(out->filled = (unsigned char *)calloc(n_blocks, 1)))
+        return -1;
+    if (out->dtype != READ_OUT_INT16)
+        return 0;
+
+    out->n_range = n_blocks;
+    if (!(out->range = (unsigned char *)malloc(out->n_range)))
+        return -1;
+    memset(out->range, AX_RANGE_NONE, out->n_range);
+    return 0;
+}
+
+/* scale of each run of blocks with the same range as a (runs, axes) array, and the sample index of
+the start of each run. Frees the range code storage */
+static int scale_arrays(AX_Info_t *info, AX_Output_t *out, PyArrayObject **scale, PyArrayObject **index)
+{
+    npy_intp dims[2] = {axivity_scale_runs(info, out, NULL, NULL), info->axes};
+
+    *scale = (PyArrayObject *)PyArray_EMPTY(2, dims, NPY_DOUBLE, 0);
+    *index = (PyArrayObject *)PyArray_EMPTY(1, dims, NPY_LONG, 0);
+    if (*scale && *index)
+        axivity_scale_runs(info, out, (double *)PyArray_DATA(*scale), (long *)PyArray_DATA(*index));
+
+    free(out->range);
+    out->range = NULL;
+
+    if (!*scale || !*index)
+    {
+        Py_XDECREF(*scale);
+        Py_XDECREF(*index);
+        *scale = *index = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+/* repaired runs of bad blocks as a (N, 2) array of [start, stop) sample indices */
+static PyArrayObject *repair_array(AX_Repair_t *rep)
+{
+    npy_intp dims[2] = {rep->n, 2};
+    PyArrayObject *arr = (PyArrayObject *)PyArray_ZEROS(2, dims, NPY_LONG, 0);
+
+    if (arr && (rep->n > 0))
+        memcpy(PyArray_DATA(arr), rep->runs, 2 * rep->n * sizeof(long));
+    return arr;
+}
+
+#define INDEX_ARRAYS 8
+
+/* storage for the index records of `n` blocks, as seq, time, count, status, t_last, day_sec,
+day_msec, and duration arrays. Returns 0 if the storage could not be made */
+static int index_arrays(npy_intp n, PyArrayObject **arr, Index_t *index)
+{
+    int types[INDEX_ARRAYS] = {NPY_LONG, NPY_DOUBLE, NPY_LONG, NPY_INT8, NPY_DOUBLE, NPY_LONG,
+        NPY_LONG, NPY_DOUBLE};
+    int ok = 1;
+
+    for (int k = 0; k < INDEX_ARRAYS; ++k)
+    {
+        arr[k] = (PyArrayObject *)PyArray_ZEROS(1, &n, types[k], 0);
+        ok = ok && arr[k];
+    }
+    if (!ok)
+    {
+        for (int k = 0; k < INDEX_ARRAYS; ++k)
+            Py_CLEAR(arr[k]);
+        return 0;
+    }
+
+    index->seq = (long *)PyArray_DATA(arr[0]);
+    index->time = (double *)PyArray_DATA(arr[1]);
+    index->count = (long *)PyArray_DATA(arr[2]);
+    index->status = (char *)PyArray_DATA(arr[3]);
+    index->t_last = (double *)PyArray_DATA(arr[4]);
+    index->day.sec = (long *)PyArray_DATA(arr[5]);
+    index->day.msec = (long *)PyArray_DATA(arr[6]);
+    index->day.duration = (double *)PyArray_DATA(arr[7]);
+    return 1;
+}
+
+/* tuple of the index record arrays. Steals the references to the arrays */
+static PyObject *index_tuple(PyArrayObject **arr)
+{
+    return Py_BuildValue("NNNNNNNN", (PyObject *)arr[0], (PyObject *)arr[1], (PyObject *)arr[2],
+        (PyObject *)arr[3], (PyObject *)arr[4], (PyObject *)arr[5], (PyObject *)arr[6],
+        (PyObject *)arr[7]);
+}
+
 static PyObject *read_axivity(PyObject *NPY_UNUSED(self), PyObject *args)
 {
     char *file;
-    Py_ssize_t flen;
-    int ierr = AX_READ_E_NONE, fail = 0;
-    PyObject *bases_, *periods_;
+    char *dtype_ = "float64";
+    int ierr = AX_READ_E_NONE, fail = 0, use_mmap = 0, workers = 1, time_ns = 0, dtype, verify = 1;
+    int record = 0;
+    long n_bad;
+    double t_prev;
+    PyObject *bases_, *periods_, *out_imu = NULL, *out_time = NULL, *out_temp = NULL;
+    PyObject *t_seed_ = NULL, *records = NULL, *buffers = NULL;
+    PyObject *buf_imu = NULL, *buf_time = NULL, *buf_temp = NULL;
+    PyArrayObject *t_seed = NULL, *index_arr[INDEX_ARRAYS] = {NULL};
 
     AX_Info_t info;
+    AX_Output_t out;
+    AX_Repair_t repair;
     Window_t winfo;
+    MappedFile_t mf;
+    Index_t index;
 
     /* READ INPUT ARGUMENTS */
-    if (!PyArg_ParseTuple(args, "sOO:read_axivity", &file, &bases_, &periods_))
+    if (!PyArg_ParseTuple(args, "sOO|pisppOOOpOO:read_axivity", &file, &bases_, &periods_, &use_mmap,
+        &workers, &dtype_, &time_ns, &verify, &out_imu, &out_time, &out_temp, &record, &t_seed_,
+        &buffers))
         return NULL;
-    flen = strlen(file);
+    if ((dtype = get_output_type(dtype_)) == -1)
+        return NULL;
+    /* parallel decoding, conversion to other types, and recording an index, work directly on the
+    memory mapped file */
+    if ((workers > 1) || (dtype != READ_OUT_FLOAT64) || record)
+        use_mmap = 1;
     
     /* GET NUMPY ARRAYS */
     PyArrayObject *bases = (PyArrayObject *)NP_FROM_ANY(bases_);
     PyArrayObject *periods = (PyArrayObject *)NP_FROM_ANY(periods_);
+    if (t_seed_ && (t_seed_ != Py_None))
+        t_seed = (PyArrayObject *)PyArray_FROMANY(t_seed_, NPY_DOUBLE, 1, 1, NPY_ARRAY_IN_ARRAY);
 
-    if (!bases || !periods)
+    if (!bases || !periods || (t_seed_ && (t_seed_ != Py_None) && !t_seed))
     {
         Py_XDECREF(bases);
         Py_XDECREF(periods);
+        Py_XDECREF(t_seed);
         return NULL;
     }
 
@@ -91,173 +332,912 @@ static PyObject *read_axivity(PyObject *NPY_UNUSED(self), PyObject *args)
     winfo.n = PyArray_Size(bases);
     if (winfo.n != PyArray_Size(periods))
     {
-        Py_XDECREF(bases); Py_XDECREF(periods);
-        PyErr_SetString(PyExc_ValueError, "Size mismatch between bases and periods.");
+        Py_XDECREF(bases); Py_XDECREF(periods); Py_XDECREF(t_seed);
+        PyErr_SetString(PyExc_ValueError, "Size mismatch between bases and periods.");
+        return NULL;
+    }
+    /* window index storage is grown as needed while reading */
+    if (window_init(&winfo, winfo.n, (long *)PyArray_DATA(bases), (long *)PyArray_DATA(periods), 0) != 0)
+    {
+        Py_XDECREF(bases); Py_XDECREF(periods); Py_XDECREF(t_seed);
+        return PyErr_NoMemory();
+    }
+
+    /* INITIALIZATION */
+    info.nblocks = -1;
+    info.axes = -1;
+    info.count = -1;
+    info.max_days = winfo.max_days;
+    info.Nwin = winfo.n;
+    info.verify = verify;
+
+    /* read the header */
+    ierr = axivity_read_header(file, &info);
+
+    if (ierr != AX_READ_E_NONE)
+    {
+        axivity_close(&info);
+
+        window_free(&winfo);
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        Py_XDECREF(t_seed);
+
+        axivity_set_error_message(ierr);
+        return NULL;
+    }
+
+    if ((info.nblocks == -1) || (info.axes == -1) || (info.count == -1))
+    {
+        axivity_close(&info);
+
+        window_free(&winfo);
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        Py_XDECREF(t_seed);
+        PyErr_SetString(PyExc_IOError, "Bad read on number of blocks, axes, or samples");
+        return NULL;
+    }
+    if (t_seed && (PyArray_SIZE(t_seed) != info.nblocks - 2))
+    {
+        axivity_close(&info);
+
+        window_free(&winfo);
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        Py_XDECREF(t_seed);
+        PyErr_SetString(PyExc_ValueError, "`t_last` must have one value for each data block.");
+        return NULL;
+    }
+
+    /* map the whole file, blocks are then decoded straight from memory */
+    if (use_mmap)
+    {
+        /* header info is all we need from the file descriptor */
+        axivity_close(&info);
+
+        if ((map_file(file, &mf) != 0) || (mf.size < (size_t)info.nblocks * 512))
+        {
+            unmap_file(&mf);
+            window_free(&winfo);
+            Py_XDECREF(bases);
+            Py_XDECREF(periods);
+            Py_XDECREF(t_seed);
+            PyErr_SetString(PyExc_IOError, "Error memory mapping file");
+            return NULL;
+        }
+    }
+
+    /* DIMENSIONS FOR RETURN VALUES */
+    npy_intp dim3[2] = {(info.nblocks - 2) * info.count, info.axes};
+    npy_intp dim1[1] = {(info.nblocks - 2) * info.count};
+    npy_intp dim_ax[1] = {info.axes};
+
+    /* re-used storage, sized from the header */
+    buf_imu = buffer_array(buffers, out_imu, "imu", dim3[0] * dim3[1], sensor_npy_type(dtype));
+    buf_time = buf_imu ? buffer_array(buffers, out_time, "time", dim1[0], time_ns ? NPY_INT64 : NPY_DOUBLE) : NULL;
+    buf_temp = buf_time ? buffer_array(buffers, out_temp, "temperature", dim1[0], other_npy_type(dtype)) : NULL;
+    if (buf_imu && (buf_imu != Py_None))
+        out_imu = buf_imu;
+    if (buf_time && (buf_time != Py_None))
+        out_time = buf_time;
+    if (buf_temp && (buf_temp != Py_None))
+        out_temp = buf_temp;
+
+    /* DATA ARRAYS. Timestamps are always decoded as double, and converted in place if necessary */
+    PyArrayObject *imudata = buf_temp ? output_array(out_imu, "out_imu", 2, dim3, sensor_npy_type(dtype)) : NULL;
+    PyArrayObject *time = imudata ? output_array(out_time, "out_time", 1, dim1, time_ns ? NPY_INT64 : NPY_DOUBLE) : NULL;
+    PyArrayObject *temperature = time ? output_array(out_temp, "out_temperature", 1, dim1, other_npy_type(dtype)) : NULL;
+    /* the output arrays hold their own reference to the storage */
+    Py_XDECREF(buf_imu);
+    Py_XDECREF(buf_time);
+    Py_XDECREF(buf_temp);
+
+    PyArrayObject *offset = (PyArrayObject *)PyArray_ZEROS(1, dim_ax, NPY_DOUBLE, 0);
+
+    /* OUTPUT TYPE. Values are `(counts - offset) / scale`, only meaningful for integer output */
+    out.dtype = dtype;
+    out.offset = 0;
+    out.n = dim1[0];
+    if (output_range_init(&info, &out) != 0)
+        PyErr_NoMemory();
+    /* records of each block for an index, made as the blocks are decoded */
+    if (record && !PyErr_Occurred())
+        index_arrays(info.nblocks - 2, index_arr, &index);
+
+    if (!imudata || !time || !temperature || !offset || PyErr_Occurred())
+    {   
+        free(out.range);
+        free(out.filled);
+        for (int k = 0; k < INDEX_ARRAYS; ++k)
+            Py_XDECREF(index_arr[k]);
+        if (use_mmap)
+            unmap_file(&mf);
+        else
+            axivity_close(&info);
+
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        Py_XDECREF(t_seed);
+
+        Py_XDECREF(imudata);
+        Py_XDECREF(time);
+        Py_XDECREF(temperature);
+        Py_XDECREF(offset);
+
+        window_free(&winfo);
+
+        return NULL;
+    }
+
+    /* SET POINTERS */
+    double *imu_p   = dtype == READ_OUT_FLOAT64 ? (double *)PyArray_DATA(imudata) : NULL;
+    double *ts_p    = (double *)PyArray_DATA(time);
+    double *temp_p = dtype == READ_OUT_FLOAT64 ? (double *)PyArray_DATA(temperature) : NULL;
+
+    out.imu = PyArray_DATA(imudata);
+    out.temp = (float *)PyArray_DATA(temperature);
+
+    /* READ FILE */
+    /* no python objects are touched while decoding, and each read has its own file descriptor, so
+    files can be read from several threads at once */
+    axivity_repair_init(&repair);
+    PyThreadState *_save = PyEval_SaveThread();
+
+    if (workers > 1)
+    {
+        ierr = axivity_read_blocks_parallel(&info, mf.data, workers, &out, imu_p, ts_p, temp_p, &winfo,
+            &repair, t_seed ? (double *)PyArray_DATA(t_seed) : NULL, record ? &index : NULL);
+        fail = ierr != AX_READ_E_NONE;
+    }
+    else
+    {
+        for (int i=2; i < info.nblocks; ++i)
+        {
+            n_bad = info.n_bad_blocks;
+            t_prev = info.tLast;
+
+            if (use_mmap)
+            {
+                ierr = axivity_decode_block_as(&info, mf.data + 512 * (size_t)i, &out, imu_p, ts_p,
+                    temp_p, &winfo, &repair);
+            }
+            else
+            {
+                ierr = axivity_read_block(&info, i, dim1[0], out.filled, imu_p, ts_p, temp_p, &winfo,
+                    &repair);
+            }
+
+            if (ierr != 0)
+            {
+                fail = 1;
+                break;
+            }
+
+            if (record)
+                axivity_index_decoded(&info, &index, i - 2, mf.data + 512 * (size_t)i, n_bad, t_prev,
+                    ts_p, 0);
+        }
+    }
+
+    /* timestamps of bad blocks are repaired while decoding, except for any at the very end */
+    if (!fail)
+    {
+        ierr = axivity_repair_finish(&info, &repair, ts_p, dim1[0], -1, 0.);
+        fail = ierr != AX_READ_E_NONE;
+    }
+    /* the storage was not cleared, only bad blocks and any unused storage are */
+    if (!fail)
+        axivity_clear_undecoded(&info, &out, imu_p, ts_p, temp_p, &repair);
+
+    if (!fail && time_ns)
+        timestamps_to_ns(ts_p, dim1[0]);
+
+    PyEval_RestoreThread(_save);
+
+    /* set a warning for the number of bad blocks, the repaired blocks are returned */
+    if (!fail && (info.n_bad_blocks > 0))
+    {
+        int err_ret = PyErr_WarnFormat(PyExc_RuntimeWarning, 1, "%li bad data blocks present",
+            info.n_bad_blocks);
+
+        if (err_ret == -1)  /* warnings are being raised as exceptions */
+        {
+            fail = 1;
+        }
+    }
+
+    if (use_mmap)
+        unmap_file(&mf);
+    else
+        axivity_close(&info);
+
+    /* WINDOW INDICES, only the rows that were used, and the scale of each run of blocks */
+    PyArrayObject *starts = NULL, *stops = NULL, *bad_blocks = NULL, *scale = NULL, *scale_index = NULL;
+    if (!fail)
+    {
+        starts = window_array(&winfo, winfo.starts);
+        stops = window_array(&winfo, winfo.stops);
+        bad_blocks = repair_array(&repair);
+        /* error is already set */
+        fail = !starts || !stops || !bad_blocks || !scale_arrays(&info, &out, &scale, &scale_index);
+    }
+    if (!fail && record)
+    {
+        records = index_tuple(index_arr);
+        fail = !records;
+    }
+    else
+    {
+        for (int k = 0; k < INDEX_ARRAYS; ++k)
+            Py_XDECREF(index_arr[k]);
+    }
+    free(out.range);
+    free(out.filled);
+    window_free(&winfo);
+    axivity_repair_free(&repair);
+
+    /* decrease ref count if successful or failed */
+    Py_XDECREF(bases);
+    Py_XDECREF(periods);
+    Py_XDECREF(t_seed);
+    
+    if (fail)
+    {
+        Py_XDECREF(imudata);
+        Py_XDECREF(time);
+        Py_XDECREF(temperature);
+        Py_XDECREF(starts);
+        Py_XDECREF(stops);
+        Py_XDECREF(scale);
+        Py_XDECREF(scale_index);
+        Py_XDECREF(offset);
+        Py_XDECREF(bad_blocks);
+        Py_XDECREF(records);
+
+        if (!PyErr_Occurred())
+            axivity_set_error_message(ierr);
+        return NULL;
+    }
+    if (!records)
+    {
+        Py_INCREF(Py_None);
+        records = Py_None;
+    }
+
+    return Py_BuildValue(
+        "dlNNNNNNNNNNi",  /* need to use N to not increment reference counter */
+        info.frequency,
+        info.n_bad_blocks * info.count,
+        (PyObject *)imudata,
+        (PyObject *)time,
+        (PyObject *)temperature,
+        (PyObject *)starts,
+        (PyObject *)stops,
+        (PyObject *)scale,
+        (PyObject *)scale_index,
+        (PyObject *)offset,
+        (PyObject *)bad_blocks,
+        records,
+        (int)info.count
+    );
+}
+
+
+/* check that an array can be used directly as (in place) state storage. Any size of the first
+dimension is allowed if `dim0` is negative */
+static int check_state_array(PyObject *arr, const char *name, npy_intp dim0, npy_intp dim1)
+{
+    if (!PyArray_Check(arr)
+        || (PyArray_TYPE((PyArrayObject *)arr) != NPY_LONG)
+        || !PyArray_ISCARRAY((PyArrayObject *)arr)
+        || (PyArray_NDIM((PyArrayObject *)arr) != 2)
+        || ((dim0 >= 0) && (PyArray_DIM((PyArrayObject *)arr, 0) != dim0))
+        || (PyArray_DIM((PyArrayObject *)arr, 1) != dim1))
+    {
+        if (dim0 >= 0)
+            PyErr_Format(PyExc_ValueError, "`%s` must be a writeable, C-contiguous, int array of shape (%zd, %zd).",
+                name, (Py_ssize_t)dim0, (Py_ssize_t)dim1);
+        else
+            PyErr_Format(PyExc_ValueError, "`%s` must be a writeable, C-contiguous, int array of shape (N, %zd).",
+                name, (Py_ssize_t)dim1);
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject *read_axivity_chunk(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    char *file;
+    char *dtype_ = "float64";
+    long block_start, block_stop, i_next = -1;
+    double t_last, t_next = 0., *anchor = NULL;
+    int ierr = AX_READ_E_NONE, fail = 0, time_ns = 0, dtype, verify = 1;
+    PyObject *bases_, *periods_, *starts_, *stops_, *i_window_, *anchor_ = NULL;
+
+    AX_Info_t info;
+    AX_Output_t out;
+    AX_Repair_t repair;
+    Window_t winfo;
+    MappedFile_t mf, mf_next;
+
+    if (!PyArg_ParseTuple(args, "sOOlldOOO|sppO:read_axivity_chunk", &file, &bases_, &periods_,
+        &block_start, &block_stop, &t_last, &starts_, &stops_, &i_window_, &dtype_, &time_ns,
+        &verify, &anchor_))
+        return NULL;
+    if ((dtype = get_output_type(dtype_)) == -1)
+        return NULL;
+    /* end of the last good block, and its last timestamp, is kept by the caller between chunks */
+    if (anchor_ && (anchor_ != Py_None))
+    {
+        if (!PyArray_Check(anchor_)
+            || (PyArray_TYPE((PyArrayObject *)anchor_) != NPY_DOUBLE)
+            || !PyArray_ISCARRAY((PyArrayObject *)anchor_)
+            || (PyArray_SIZE((PyArrayObject *)anchor_) != 2))
+        {
+            PyErr_SetString(PyExc_ValueError, "`anchor` must be a writeable, C-contiguous, float64 array of size 2.");
+            return NULL;
+        }
+        anchor = (double *)PyArray_DATA((PyArrayObject *)anchor_);
+    }
+
+    /* GET NUMPY ARRAYS */
+    PyArrayObject *bases = (PyArrayObject *)NP_FROM_ANY(bases_);
+    PyArrayObject *periods = (PyArrayObject *)NP_FROM_ANY(periods_);
+
+    if (!bases || !periods)
+    {
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        return NULL;
+    }
+
+    /* WINDOWING INFO INIT. Window state is kept by the caller between chunks */
+    winfo.n = PyArray_Size((PyObject *)bases);
+    if ((winfo.n != PyArray_Size((PyObject *)periods))
+        || !check_state_array(starts_, "starts", -1, winfo.n)
+        || !check_state_array(stops_, "stops", -1, winfo.n)
+        || !check_state_array(i_window_, "i_window", 2, winfo.n))
+    {
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "Size mismatch between bases and periods.");
+        return NULL;
+    }
+    if (PyArray_DIM((PyArrayObject *)starts_, 0) != PyArray_DIM((PyArrayObject *)stops_, 0))
+    {
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        PyErr_SetString(PyExc_ValueError, "Size mismatch between starts and stops.");
+        return NULL;
+    }
+    /* copy the state into storage that can be grown while reading. The grown window indices are
+    returned, and the positions updated in place */
+    npy_intp n_rows = PyArray_DIM((PyArrayObject *)starts_, 0);
+    if (window_init(&winfo, winfo.n, (long *)PyArray_DATA(bases), (long *)PyArray_DATA(periods),
+        n_rows) != 0)
+    {
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        return PyErr_NoMemory();
+    }
+    memcpy(winfo.starts, PyArray_DATA((PyArrayObject *)starts_), n_rows * winfo.n * sizeof(long));
+    memcpy(winfo.stops, PyArray_DATA((PyArrayObject *)stops_), n_rows * winfo.n * sizeof(long));
+    memcpy(winfo.i_start, PyArray_DATA((PyArrayObject *)i_window_), 2 * winfo.n * sizeof(long));
+
+    /* INITIALIZATION */
+    info.nblocks = -1;
+    info.axes = -1;
+    info.count = -1;
+    info.max_days = winfo.max_days;
+    info.Nwin = winfo.n;
+    info.verify = verify;
+
+    /* read the header, only the header is read from the file descriptor */
+    ierr = axivity_read_header(file, &info);
+    axivity_close(&info);
+
+    if (ierr != AX_READ_E_NONE)
+    {
+        window_free(&winfo);
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        axivity_set_error_message(ierr);
+        return NULL;
+    }
+    if ((info.nblocks == -1) || (info.axes == -1) || (info.count == -1))
+    {
+        window_free(&winfo);
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        PyErr_SetString(PyExc_IOError, "Bad read on number of blocks, axes, or samples");
+        return NULL;
+    }
+    /* carry the previous block time over from the last chunk */
+    info.tLast = t_last;
+
+    /* block indices are for data blocks, ie not counting the 2 header blocks */
+    if (block_start < 0)
+        block_start = 0;
+    if (block_stop > (info.nblocks - 2))
+        block_stop = info.nblocks - 2;
+    if (block_stop < block_start)
+        block_stop = block_start;
+    long n_blocks = block_stop - block_start;
+
+    /* only map the blocks that are part of this chunk */
+    mf.data = NULL;
+    mf.fd = -1;
+    mf.size = 0;
+    mf.pad = 0;
+    if ((n_blocks > 0)
+        && (map_file_range(file, 512 * (size_t)(block_start + 2), 512 * (size_t)n_blocks, &mf) != 0))
+    {
+        window_free(&winfo);
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        PyErr_SetString(PyExc_IOError, "Error memory mapping file");
+        return NULL;
+    }
+
+    /* DIMENSIONS FOR RETURN VALUES */
+    npy_intp dim3[2] = {n_blocks * info.count, info.axes};
+    npy_intp dim1[1] = {n_blocks * info.count};
+    npy_intp dim_ax[1] = {info.axes};
+
+    /* DATA ARRAYS. Only the storage that is not decoded into is cleared after decoding */
+    PyArrayObject *imudata = (PyArrayObject *)PyArray_EMPTY(2, dim3, sensor_npy_type(dtype), 0);
+    PyArrayObject *time  = (PyArrayObject *)PyArray_EMPTY(1, dim1, time_ns ? NPY_INT64 : NPY_DOUBLE, 0);
+    PyArrayObject *temperature = (PyArrayObject *)PyArray_EMPTY(1, dim1, other_npy_type(dtype), 0);
+    PyArrayObject *offset = (PyArrayObject *)PyArray_ZEROS(1, dim_ax, NPY_DOUBLE, 0);
+
+    /* OUTPUT. The storage starts at the first sample of the chunk */
+    out.dtype = dtype;
+    out.offset = block_start * info.count;
+    out.n = dim1[0];
+    if (output_range_init(&info, &out) != 0)
+        PyErr_NoMemory();
+
+    if (!imudata || !time || !temperature || !offset || PyErr_Occurred())
+    {
+        free(out.range);
+        free(out.filled);
+        unmap_file(&mf);
+        window_free(&winfo);
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        Py_XDECREF(imudata);
+        Py_XDECREF(time);
+        Py_XDECREF(temperature);
+        Py_XDECREF(offset);
+        return NULL;
+    }
+
+    /* SET POINTERS */
+    double *imu_p   = dtype == READ_OUT_FLOAT64 ? (double *)PyArray_DATA(imudata) : NULL;
+    double *ts_p    = (double *)PyArray_DATA(time);
+    double *temp_p = dtype == READ_OUT_FLOAT64 ? (double *)PyArray_DATA(temperature) : NULL;
+
+    out.imu = PyArray_DATA(imudata);
+    out.temp = (float *)PyArray_DATA(temperature);
+
+    /* READ BLOCKS. Timestamps for bad blocks continue on from the last good block of the previous
+    chunks */
+    axivity_repair_init(&repair);
+    if (anchor)
+    {
+        repair.end = (long)anchor[0] - out.offset;
+        repair.t_end = anchor[1];
+    }
+    Py_BEGIN_ALLOW_THREADS
+    for (long i = 0; i < n_blocks; ++i)
+    {
+        ierr = axivity_decode_block_as(&info, mf.data + 512 * (size_t)i, &out, imu_p, ts_p, temp_p,
+            &winfo, &repair);
+
+        if (ierr != AX_READ_E_NONE)
+        {
+            fail = 1;
+            break;
+        }
+    }
+
+    /* a run of bad blocks at the end of the chunk is filled in up to the next good block after
+    the chunk, if there is one */
+    if (!fail && (repair.end < dim1[0]) && (block_stop < info.nblocks - 2)
+        && (map_file_range(file, 512 * (size_t)(block_stop + 2),
+            512 * (size_t)(info.nblocks - 2 - block_stop), &mf_next) == 0))
+    {
+        if (!axivity_repair_next(&info, mf_next.data, info.nblocks - 2 - block_stop, out.offset,
+            &i_next, &t_next))
+            t_next = 0.;
+        unmap_file(&mf_next);
+    }
+    if (!fail)
+    {
+        ierr = axivity_repair_finish(&info, &repair, ts_p, dim1[0], i_next, t_next);
+        fail = ierr != AX_READ_E_NONE;
+    }
+    if (!fail)
+        axivity_clear_undecoded(&info, &out, imu_p, ts_p, temp_p, &repair);
+    if (!fail && anchor)
+    {
+        anchor[0] = (double)(repair.end + out.offset);
+        anchor[1] = repair.t_end;
+    }
+
+    if (!fail && time_ns)
+        timestamps_to_ns(ts_p, dim1[0]);
+    Py_END_ALLOW_THREADS
+
+    unmap_file(&mf);
+    Py_XDECREF(bases);
+    Py_XDECREF(periods);
+
+    /* updated window state, and the scale of each run of blocks in the chunk */
+    PyArrayObject *starts = NULL, *stops = NULL, *bad_blocks = NULL, *scale = NULL, *scale_index = NULL;
+    int ok = 1;
+    if (!fail)
+    {
+        memcpy(PyArray_DATA((PyArrayObject *)i_window_), winfo.i_start, 2 * winfo.n * sizeof(long));
+        starts = window_array(&winfo, winfo.starts);
+        stops = window_array(&winfo, winfo.stops);
+        bad_blocks = repair_array(&repair);
+        ok = starts && stops && bad_blocks && scale_arrays(&info, &out, &scale, &scale_index);
+    }
+    free(out.range);
+    free(out.filled);
+    window_free(&winfo);
+    axivity_repair_free(&repair);
+
+    if (!ok)
+    {
+        Py_XDECREF(imudata);
+        Py_XDECREF(time);
+        Py_XDECREF(temperature);
+        Py_XDECREF(scale);
+        Py_XDECREF(scale_index);
+        Py_XDECREF(offset);
+        Py_XDECREF(starts);
+        Py_XDECREF(stops);
+        Py_XDECREF(bad_blocks);
+        return NULL;
+    }
+
+    if (!fail && (info.n_bad_blocks > 0))
+    {
+        /* warnings are being raised as exceptions */
+        if (PyErr_WarnFormat(PyExc_RuntimeWarning, 1, "%li bad data blocks present",
+            info.n_bad_blocks) == -1)
+        {
+            Py_XDECREF(imudata);
+            Py_XDECREF(time);
+            Py_XDECREF(temperature);
+            Py_XDECREF(scale);
+            Py_XDECREF(scale_index);
+            Py_XDECREF(offset);
+            Py_XDECREF(starts);
+            Py_XDECREF(stops);
+            Py_XDECREF(bad_blocks);
+            return NULL;
+        }
+    }
+
+    if (fail)
+    {
+        Py_XDECREF(imudata);
+        Py_XDECREF(time);
+        Py_XDECREF(temperature);
+        Py_XDECREF(offset);
+
+        axivity_set_error_message(ierr);
+        return NULL;
+    }
+
+    return Py_BuildValue(
+        "dlilNNNdNNNNNN",  /* need to use N to not increment reference counter */
+        info.frequency,
+        (long)(info.nblocks - 2),
+        (int)info.count,
+        info.n_bad_blocks * info.count,
+        (PyObject *)imudata,
+        (PyObject *)time,
+        (PyObject *)temperature,
+        info.tLast,
+        (PyObject *)scale,
+        (PyObject *)scale_index,
+        (PyObject *)offset,
+        (PyObject *)starts,
+        (PyObject *)stops,
+        (PyObject *)bad_blocks
+    );
+}
+
+
+static PyObject *read_axivity_index(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    char *file;
+    int ierr = AX_READ_E_NONE, verify = 1;
+    PyArrayObject *index_arr[INDEX_ARRAYS];
+
+    AX_Info_t info;
+    MappedFile_t mf;
+    Index_t index;
+
+    if (!PyArg_ParseTuple(args, "s|p:read_axivity_index", &file, &verify))
+        return NULL;
+
+    /* INITIALIZATION */
+    info.nblocks = -1;
+    info.axes = -1;
+    info.count = -1;
+    info.max_days = 0;
+    info.Nwin = 0;
+    info.verify = verify;
+
+    ierr = axivity_read_header(file, &info);
+    axivity_close(&info);
+
+    if (ierr != AX_READ_E_NONE)
+    {
+        axivity_set_error_message(ierr);
+        return NULL;
+    }
+    if ((info.nblocks < 2) || (info.axes == -1) || (info.count == -1))
+    {
+        PyErr_SetString(PyExc_IOError, "Bad read on number of blocks, axes, or samples");
+        return NULL;
+    }
+    if ((map_file(file, &mf) != 0) || (mf.size < (size_t)info.nblocks * 512))
+    {
+        unmap_file(&mf);
+        PyErr_SetString(PyExc_IOError, "Error memory mapping file");
+        return NULL;
+    }
+
+    if (!index_arrays(info.nblocks - 2, index_arr, &index))
+    {
+        unmap_file(&mf);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    ierr = axivity_read_index(&info, mf.data, &index);
+    Py_END_ALLOW_THREADS
+
+    unmap_file(&mf);
+
+    if (ierr != AX_READ_E_NONE)
+    {
+        for (int k = 0; k < INDEX_ARRAYS; ++k)
+            Py_XDECREF(index_arr[k]);
+
+        axivity_set_error_message(ierr);
+        return NULL;
+    }
+
+    return Py_BuildValue(
+        "diN",  /* need to use N to not increment reference counter */
+        info.frequency,
+        (int)info.count,
+        index_tuple(index_arr)
+    );
+}
+
+
+static PyObject *find_axivity_blocks(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    char *file;
+    double start_time, stop_time, t_last;
+    long block_start, block_stop;
+    int ierr = AX_READ_E_NONE, verify = 1;
+
+    AX_Info_t info;
+    MappedFile_t mf;
+
+    if (!PyArg_ParseTuple(args, "sdd|p:find_axivity_blocks", &file, &start_time, &stop_time, &verify))
+        return NULL;
+
+    /* INITIALIZATION */
+    info.nblocks = -1;
+    info.axes = -1;
+    info.count = -1;
+    info.max_days = 0;
+    info.Nwin = 0;
+    info.verify = verify;
+
+    ierr = axivity_read_header(file, &info);
+    axivity_close(&info);
+
+    if (ierr != AX_READ_E_NONE)
+    {
+        axivity_set_error_message(ierr);
+        return NULL;
+    }
+    if ((info.nblocks < 2) || (info.axes == -1) || (info.count == -1))
+    {
+        PyErr_SetString(PyExc_IOError, "Bad read on number of blocks, axes, or samples");
+        return NULL;
+    }
+    if ((map_file(file, &mf) != 0) || (mf.size < (size_t)info.nblocks * 512))
+    {
+        unmap_file(&mf);
+        PyErr_SetString(PyExc_IOError, "Error memory mapping file");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    axivity_find_blocks(&info, mf.data, start_time, stop_time, &block_start, &block_stop, &t_last);
+    Py_END_ALLOW_THREADS
+
+    unmap_file(&mf);
+
+    return Py_BuildValue("lld", block_start, block_stop, t_last);
+}
+
+
+static PyObject *read_geneactiv_index(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    char *file;
+    long n;
+    PyArrayObject *index_arr[INDEX_ARRAYS];
+
+    FILE *fp;
+    GN_Info_t info;
+    Index_t index;
+
+    /* INITIALIZATION */
+    info.fs_err = 0;
+    info.max_n = 0;
+    info.npages = -1;
+
+    if (!PyArg_ParseTuple(args, "s:read_geneactiv_index", &file))
+        return NULL;
+
+    fp = fopen(file, "r");
+    if (!fp)
+    {
+        PyErr_SetString(PyExc_IOError, "Error opening file");
         return NULL;
     }
-    winfo.i_start = (long *)malloc(winfo.n * sizeof(winfo.i_start));
-    winfo.i_stop = (long *)malloc(winfo.n * sizeof(winfo.i_stop));
-    winfo.bases = (long *)PyArray_DATA(bases);
-    winfo.periods = (long *)PyArray_DATA(periods);
-    /* set the indices to 0 initially */
-    memset(winfo.i_start, 0, winfo.n * sizeof(winfo.i_start));
-    memset(winfo.i_stop, 0, winfo.n * sizeof(winfo.i_stop));
-
-    /* INITIALIZATION */
-    info.nblocks = -1;
-    info.axes = -1;
-    info.count = -1;
-    info.max_days = MAX_DAYS;
-    info.Nwin = winfo.n;
 
-    /* read the header */
-    axivity_read_header(&flen, file, &info, &ierr);
+    geneactiv_read_header(fp, &info);
 
-    if (ierr != AX_READ_E_NONE)
+    if (info.npages < 0)
     {
-        axivity_close(&info);
-
-        free(winfo.i_start);
-        free(winfo.i_stop);
-        Py_XDECREF(bases);
-        Py_XDECREF(periods);
-
-        axivity_set_error_message(ierr);
+        fclose(fp);
+        PyErr_SetString(PyExc_IOError, "Cannot read number of blocks");
         return NULL;
     }
 
-    if ((info.nblocks == -1) || (info.axes == -1) || (info.count == -1))
+    if (!index_arrays(info.npages, index_arr, &index))
     {
-        axivity_close(&info);
-
-        free(winfo.i_start);
-        free(winfo.i_stop);
-        Py_XDECREF(bases);
-        Py_XDECREF(periods);
-        PyErr_SetString(PyExc_IOError, "Bad read on number of blocks, axes, or samples");
+        fclose(fp);
         return NULL;
     }
 
-    /* DIMENSIONS FOR RETURN VALUES */
-    npy_intp dim3[2] = {(info.nblocks - 2) * info.count, info.axes};
-    npy_intp dim1[1] = {(info.nblocks - 2) * info.count};
-    npy_intp dim_idx[2] = {MAX_DAYS, winfo.n};
-
-    /* DATA ARRAYS */
-    PyArrayObject *imudata = (PyArrayObject *)PyArray_ZEROS(2, dim3, NPY_DOUBLE, 0);
-    PyArrayObject *time  = (PyArrayObject *)PyArray_ZEROS(1, dim1, NPY_DOUBLE, 0);
-    PyArrayObject *temperature = (PyArrayObject *)PyArray_ZEROS(1, dim1, NPY_DOUBLE, 0);
+    Py_BEGIN_ALLOW_THREADS
+    n = geneactiv_read_index(fp, &info, &index);
+    Py_END_ALLOW_THREADS
 
-    PyArrayObject *starts = (PyArrayObject *)PyArray_ZEROS(2, dim_idx, NPY_LONG, 0);
-    PyArrayObject *stops  = (PyArrayObject *)PyArray_ZEROS(2, dim_idx, NPY_LONG, 0);
+    fclose(fp);
 
-    if (!imudata || !time || !temperature || !starts || !stops)
-    {   
-        axivity_close(&info);
+    return Py_BuildValue(
+        "dlN",  /* need to use N to not increment reference counter */
+        info.fs,
+        n,
+        index_tuple(index_arr)
+    );
+}
 
-        Py_XDECREF(bases);
-        Py_XDECREF(periods);
 
-        Py_XDECREF(imudata);
-        Py_XDECREF(time);
-        Py_XDECREF(temperature);
-        Py_XDECREF(starts);
-        Py_XDECREF(stops);
+static PyObject *index_windows(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    double fs;
+    long block_samples, max_n, nblocks = 0;
+    PyObject *block_n_, *status_, *day_sec_, *day_msec_, *duration_, *bases_, *periods_;
 
-        free(winfo.i_start);
-        free(winfo.i_stop);
+    Window_t winfo;
 
+    if (!PyArg_ParseTuple(args, "dllOOOOOOO:index_windows", &fs, &block_samples, &max_n,
+        &block_n_, &status_, &day_sec_, &day_msec_, &duration_, &bases_, &periods_))
         return NULL;
-    }
 
-    /* SET POINTERS */
-    double *imu_p   = (double *)PyArray_DATA(imudata);
-    double *ts_p    = (double *)PyArray_DATA(time);
-    double *temp_p = (double *)PyArray_DATA(temperature);
-    long *starts_p = (long *)PyArray_DATA(starts);
-    long *stops_p  = (long *)PyArray_DATA(stops);
+    /* GET NUMPY ARRAYS */
+    PyArrayObject *block_n = (PyArrayObject *)NP_FROM_ANY(block_n_);
+    PyArrayObject *status = (PyArrayObject *)PyArray_FROMANY(status_, NPY_INT8, 1, 1, NPY_ARRAY_IN_ARRAY);
+    PyArrayObject *day_sec = (PyArrayObject *)NP_FROM_ANY(day_sec_);
+    PyArrayObject *day_msec = (PyArrayObject *)NP_FROM_ANY(day_msec_);
+    PyArrayObject *duration = (PyArrayObject *)PyArray_FROMANY(duration_, NPY_DOUBLE, 1, 1, NPY_ARRAY_IN_ARRAY);
+    PyArrayObject *bases = (PyArrayObject *)NP_FROM_ANY(bases_);
+    PyArrayObject *periods = (PyArrayObject *)NP_FROM_ANY(periods_);
 
-    /* READ FILE */
-    long pos = 0;
-    for (int i=2; i < info.nblocks; ++i)
-    {
-        pos = 512 * i + 1;  /* +1 to account for fortran numbering */
-        axivity_read_block(&info, &pos, imu_p, ts_p, temp_p, winfo.bases, winfo.periods,
-            starts_p, winfo.i_start, stops_p, winfo.i_stop, &ierr);
-        
-        if (ierr != 0)
-        {
-            PyErr_SetString(PyExc_RuntimeError, "Error reading axivity data block.");
-            fail = 1;
-            break;
-        }
+    if (block_n && status && day_sec && day_msec && duration && bases && periods)
+    {
+        nblocks = PyArray_Size((PyObject *)block_n);
+        winfo.n = PyArray_Size((PyObject *)bases);
+
+        if ((PyArray_Size((PyObject *)status) != nblocks)
+            || (PyArray_Size((PyObject *)day_sec) != nblocks)
+            || (PyArray_Size((PyObject *)day_msec) != nblocks)
+            || (PyArray_Size((PyObject *)duration) != nblocks)
+            || (PyArray_Size((PyObject *)periods) != winfo.n))
+            PyErr_SetString(PyExc_ValueError, "Size mismatch between block or window arrays.");
     }
 
-    /* adjust timestamps if there were bad blocks */
-    if (info.n_bad_blocks > 0)
+    if (PyErr_Occurred())
     {
-        adjust_timestamps(&info, ts_p, &ierr);
-        if (ierr != 0)
-        {
-            fail = 1;
-        }
+        Py_XDECREF(block_n);
+        Py_XDECREF(status);
+        Py_XDECREF(day_sec);
+        Py_XDECREF(day_msec);
+        Py_XDECREF(duration);
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        return NULL;
     }
 
-    /* set a warning for the number of bad blocks */
-    if (info.n_bad_blocks > 0)
-    {
-        fprintf(stdout, "WARNING: %li bad blocks\n", info.n_bad_blocks);
-        int err_ret = PyErr_WarnEx(PyExc_RuntimeWarning, "Bad data blocks present", 1);
+    PyArrayObject *starts = NULL, *stops = NULL;
+    int ierr = window_init(&winfo, winfo.n, (long *)PyArray_DATA(bases), (long *)PyArray_DATA(periods), 0);
 
-        if (err_ret == -1)  /* warnings are being raised as exceptions */
+    if (ierr == 0)
+    {
+        Index_Day_t day = {
+            (long *)PyArray_DATA(day_sec),
+            (long *)PyArray_DATA(day_msec),
+            (double *)PyArray_DATA(duration)
+        };
+
+        Py_BEGIN_ALLOW_THREADS
+        ierr = index_day_indexing(fs, block_samples, max_n, nblocks, (long *)PyArray_DATA(block_n),
+            (char *)PyArray_DATA(status), &day, &winfo);
+        Py_END_ALLOW_THREADS
+
+        if (ierr == 0)
         {
-            fail = 1;
+            starts = window_array(&winfo, winfo.starts);
+            stops = window_array(&winfo, winfo.stops);
         }
+        window_free(&winfo);
     }
 
-    axivity_close(&info);
-    free(winfo.i_start);
-    free(winfo.i_stop);
-
-    /* decrease ref count if successful or failed */
+    Py_XDECREF(block_n);
+    Py_XDECREF(status);
+    Py_XDECREF(day_sec);
+    Py_XDECREF(day_msec);
+    Py_XDECREF(duration);
     Py_XDECREF(bases);
     Py_XDECREF(periods);
-    
-    if (fail)
+
+    if (!starts || !stops)
     {
-        Py_XDECREF(imudata);
-        Py_XDECREF(time);
-        Py_XDECREF(temperature);
         Py_XDECREF(starts);
         Py_XDECREF(stops);
-
-        axivity_set_error_message(ierr);
+        if (!PyErr_Occurred())
+            PyErr_NoMemory();
         return NULL;
     }
 
-    return Py_BuildValue(
-        "dlNNNNN",  /* need to use N to not increment reference counter */
-        info.frequency,
-        info.n_bad_blocks * info.count,
-        (PyObject *)imudata,
-        (PyObject *)time,
-        (PyObject *)temperature,
-        (PyObject *)starts,
-        (PyObject *)stops
-    );
+    return Py_BuildValue("NN", (PyObject *)starts, (PyObject *)stops);
 }
 
 
 static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
 {
-    char *file;
-    int ierr = GN_READ_E_NONE, fail = 0;
-    PyObject *bases_, *periods_;
+    char *file, *dtype_ = "float64";
+    int ierr = GN_READ_E_NONE, fail = 0, time_ns = 0, dtype, use_mmap = 0, workers = 1, fs_warn = 0;
+    int record = 0;
+    long offset_ = 0, n_index = 0;
+    PyObject *bases_, *periods_, *out_accel = NULL, *out_time = NULL, *out_light = NULL, *out_temp = NULL;
+    PyObject *records = NULL;
+    PyArrayObject *index_arr[INDEX_ARRAYS] = {NULL};
 
     FILE *fp;
     GN_Info_t info;
     GN_Data_t data;
     Window_t winfo;
+    Index_t index;
 
     /* INITIALIZATION */
     info.fs_err = 0;
@@ -265,8 +1245,14 @@ static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
     info.npages = -1;
 
     /* PYTHON ARGUMENTS */
-    if (!PyArg_ParseTuple(args, "sOO:read_geneactiv", &file, &bases_, &periods_))
+    if (!PyArg_ParseTuple(args, "sOO|sppiOOOOp:read_geneactiv", &file, &bases_, &periods_, &dtype_, &time_ns,
+        &use_mmap, &workers, &out_accel, &out_time, &out_light, &out_temp, &record))
         return NULL;  /* error is set for us */
+    if ((dtype = get_output_type(dtype_)) == -1)
+        return NULL;
+    /* index records are made while finishing the memory mapped pages */
+    if ((workers > 1) || record)
+        use_mmap = 1;
     
     /* GET NUMPY ARRAYS */
     PyArrayObject *bases = (PyArrayObject *)NP_FROM_ANY(bases_);
@@ -288,18 +1274,19 @@ static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
         PyErr_SetString(PyExc_ValueError, "Size mismatch between bases and periods");
         return NULL;
     }
-    winfo.i_start = (long *)malloc(winfo.n * sizeof(winfo.i_start));
-    winfo.i_stop = (long *)malloc(winfo.n * sizeof(winfo.i_stop));
-    winfo.bases = (long *)PyArray_DATA(bases);
-    winfo.periods = (long *)PyArray_DATA(periods);
-    /* set the indices to 0 initially */
-    memset(winfo.i_start, 0, winfo.n * sizeof(winfo.i_stop));
-    memset(winfo.i_stop, 0, winfo.n * sizeof(winfo.i_stop));
+    /* window index storage is grown as needed while reading */
+    if (window_init(&winfo, winfo.n, (long *)PyArray_DATA(bases), (long *)PyArray_DATA(periods), 0) != 0)
+    {
+        Py_XDECREF(bases);
+        Py_XDECREF(periods);
+        return PyErr_NoMemory();
+    }
     
     /* OPEN THE FILE */
     fp = fopen(file, "r");
     if (!fp)
     {
+        window_free(&winfo);
         Py_XDECREF(bases);
         Py_XDECREF(periods);
         PyErr_SetString(PyExc_IOError, "Error opening file");
@@ -313,6 +1300,7 @@ static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
     if (info.npages == -1)
     {
         fclose(fp);
+        window_free(&winfo);
         Py_XDECREF(bases);
         Py_XDECREF(periods);
         PyErr_SetString(PyExc_IOError, "Cannot read number of blocks");
@@ -322,21 +1310,30 @@ static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
     /* DIMENSIONS FOR RETURN VALUES */
     npy_intp dim3[2] = {info.npages * GN_SAMPLES, 3};
     npy_intp dim1[1] = {info.npages * GN_SAMPLES};
+    npy_intp dim_ax[1] = {3};
 
-    npy_intp dim_idx[2] = {MAX_DAYS, winfo.n};
+    /* DATA ARRAYS. Timestamps are always read as double, and converted in place if necessary */
+    PyArrayObject *accel = output_array(out_accel, "out_accel", 2, dim3, sensor_npy_type(dtype));
+    PyArrayObject *time  = accel ? output_array(out_time, "out_time", 1, dim1, time_ns ? NPY_INT64 : NPY_DOUBLE) : NULL;
+    PyArrayObject *light = time ? output_array(out_light, "out_light", 1, dim1, other_npy_type(dtype)) : NULL;
+    PyArrayObject *temp  = light ? output_array(out_temp, "out_temperature", 1, dim1, other_npy_type(dtype)) : NULL;
 
-    /* DATA ARRAYS */
-    PyArrayObject *accel = (PyArrayObject *)PyArray_ZEROS(2, dim3, NPY_DOUBLE, 0);
-    PyArrayObject *time  = (PyArrayObject *)PyArray_ZEROS(1, dim1, NPY_DOUBLE, 0);
-    PyArrayObject *light = (PyArrayObject *)PyArray_ZEROS(1, dim1, NPY_DOUBLE, 0);
-    PyArrayObject *temp  = (PyArrayObject *)PyArray_ZEROS(1, dim1, NPY_DOUBLE, 0);
+    PyArrayObject *scale = (PyArrayObject *)PyArray_ZEROS(1, dim_ax, NPY_DOUBLE, 0);
+    PyArrayObject *offset = (PyArrayObject *)PyArray_ZEROS(1, dim_ax, NPY_DOUBLE, 0);
 
-    PyArrayObject *starts = (PyArrayObject *)PyArray_ZEROS(2, dim_idx, NPY_LONG, 0);
-    PyArrayObject *stops  = (PyArrayObject *)PyArray_ZEROS(2, dim_idx, NPY_LONG, 0);
+    if (record && !PyErr_Occurred())
+        index_arrays(info.npages, index_arr, &index);
+    /* which pages were read, the storage of the rest is cleared after reading */
+    data.filled = PyErr_Occurred() ? NULL : (unsigned char *)calloc(info.npages, 1);
+    if (!data.filled && !PyErr_Occurred())
+        PyErr_NoMemory();
 
-    if (!accel || !time || !light || !temp || !starts || !stops)
+    if (!accel || !time || !light || !temp || !scale || !offset || PyErr_Occurred())
     {
         fclose(fp);
+        free(data.filled);
+        for (int k = 0; k < INDEX_ARRAYS; ++k)
+            Py_XDECREF(index_arr[k]);
 
         Py_XDECREF(bases);
         Py_XDECREF(periods);
@@ -345,26 +1342,71 @@ static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
         Py_XDECREF(time);
         Py_XDECREF(temp);
         Py_XDECREF(light);
-        Py_XDECREF(starts);
-        Py_XDECREF(stops);
+        Py_XDECREF(scale);
+        Py_XDECREF(offset);
 
-        free(winfo.i_start);
-        free(winfo.i_stop);
+        window_free(&winfo);
 
         return NULL;
     }
 
     /* SET POINTERS */
-    data.acc   = (double *)PyArray_DATA(accel);
+    data.dtype = dtype;
+    data.acc   = PyArray_DATA(accel);
     data.ts    = (double *)PyArray_DATA(time);
-    data.light = (double *)PyArray_DATA(light);
-    data.temp  = (double *)PyArray_DATA(temp);
-    data.day_starts = (long *)PyArray_DATA(starts);
-    data.day_stops  = (long *)PyArray_DATA(stops);
+    data.light = PyArray_DATA(light);
+    data.temp  = PyArray_DATA(temp);
+
+    /* values are `(counts - offset) / scale`, only meaningful for integer output */
+    double *scale_p = (double *)PyArray_DATA(scale);
+    double *offset_p = (double *)PyArray_DATA(offset);
+    for (int i = 0; i < 3; ++i)
+    {
+        scale_p[i] = dtype == READ_OUT_INT16 ? info.gain[i] / 100.0 : 1.0;
+        offset_p[i] = dtype == READ_OUT_INT16 ? info.offset[i] / 100.0 : 0.0;
+    }
     
     /* READ FILE */
     DEBUG_PRINTF("Reading pages\n");
-    for (int i = 0; i < info.npages; ++i)
+    if (use_mmap)
+    {
+        MappedFile_t mf;
+
+        offset_ = ftell(fp);
+        fclose(fp);
+        fp = NULL;
+
+        /* map_file cleans up after itself if it fails, so there is nothing to unmap */
+        if ((offset_ < 0) || (map_file(file, &mf) != 0))
+        {
+            fail = 1;
+            ierr = GN_READ_E_MMAP;
+        }
+        else
+        {
+            Py_BEGIN_ALLOW_THREADS
+            ierr = geneactiv_read_pages_parallel(&info, mf.data, mf.size, (size_t)offset_, workers,
+                &winfo, &data, &fs_warn, record ? &index : NULL, &n_index);
+            Py_END_ALLOW_THREADS
+
+            unmap_file(&mf);
+        }
+
+        if (!fail && fs_warn)
+        {
+            if (PyErr_WarnEx(PyExc_RuntimeWarning, "Block fs is not the same as header fs. Setting to block fs.", 1) == -1)
+                fail = 1;
+        }
+        if (!fail && (ierr == GN_READ_E_BLOCK_MISSING_BLOCK_WARN))
+        {
+            if (PyErr_WarnEx(PyExc_RuntimeWarning, "Found an empty block, assuming end of recorded data.", 1) == -1)
+                fail = 1;
+        }
+        else if (ierr != GN_READ_E_NONE)
+            fail = 1;
+    }
+
+    for (int i = 0; (i < info.npages) && !use_mmap; ++i)
     {
         DEBUG_PRINTF("%i\n", i);
         ierr = geneactiv_read_block(fp, &winfo, &info, &data);
@@ -397,9 +1439,35 @@ static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
         }
     }
 
-    fclose(fp);
-    free(winfo.i_start);
-    free(winfo.i_stop);
+    if (fp)
+        fclose(fp);
+
+    if (!fail)
+        geneactiv_clear_unread(&info, &data);
+    free(data.filled);
+
+    /* WINDOW INDICES, only the rows that were used */
+    PyArrayObject *starts = NULL, *stops = NULL;
+    if (!fail)
+    {
+        starts = window_array(&winfo, winfo.starts);
+        stops = window_array(&winfo, winfo.stops);
+        /* error is already set */
+        fail = !starts || !stops;
+    }
+    window_free(&winfo);
+
+    /* records of the pages that were found, as (n, arrays) */
+    if (!fail && record)
+    {
+        records = Py_BuildValue("lN", n_index, index_tuple(index_arr));
+        fail = !records;
+    }
+    else
+    {
+        for (int k = 0; k < INDEX_ARRAYS; ++k)
+            Py_XDECREF(index_arr[k]);
+    }
 
     /* decrease ref count if successful or failed */
     Py_XDECREF(bases);
@@ -413,13 +1481,25 @@ static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
         Py_XDECREF(light);
         Py_XDECREF(starts);
         Py_XDECREF(stops);
+        Py_XDECREF(scale);
+        Py_XDECREF(offset);
+        Py_XDECREF(records);
 
-        geneactiv_set_error_message(ierr);
+        if (!PyErr_Occurred())
+            geneactiv_set_error_message(ierr);
         return NULL;
     }
 
+    if (time_ns)
+        timestamps_to_ns(data.ts, dim1[0]);
+    if (!records)
+    {
+        Py_INCREF(Py_None);
+        records = Py_None;
+    }
+
     return Py_BuildValue(
-        "lfNNNNNN",  /* need to use N to not increment reference counter */
+        "lfNNNNNNNNN",  /* need to use N to not increment reference counter */
         (info.max_n + 1) * GN_SAMPLES,
         info.fs,
         (PyObject *)accel,
@@ -427,13 +1507,154 @@ static PyObject *read_geneactiv(PyObject *NPY_UNUSED(self), PyObject *args)
         (PyObject *)light,
         (PyObject *)temp,
         (PyObject *)starts,
-        (PyObject *)stops
+        (PyObject *)stops,
+        (PyObject *)scale,
+        (PyObject *)offset,
+        records
+    );
+}
+
+
+static PyObject *read_csv_numeric(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    char *file;
+    int ierr = CSV_READ_E_NONE, delimiter = ',', fill_gaps = 1, workers = 1;
+    Py_ssize_t skip = 0;
+    long n_gaps = 0, missing = 0;
+    double fs = 0.;
+
+    CSV_Info_t info;
+    MappedFile_t mf;
+
+    /* PYTHON ARGUMENTS */
+    if (!PyArg_ParseTuple(args, "sn(llll)Cdd|pi:read_csv_numeric", &file, &skip, &info.cols[0],
+        &info.cols[1], &info.cols[2], &info.cols[3], &delimiter, &info.time_scale,
+        &info.accel_scale, &fill_gaps, &workers))
+        return NULL;  /* error is set for us */
+    for (int j = 0; j < 4; ++j)
+    {
+        if (info.cols[j] < 0)
+        {
+            PyErr_SetString(PyExc_ValueError, "Column indices must be non-negative");
+            return NULL;
+        }
+    }
+    info.delimiter = (char)delimiter;
+    info.workers = workers;
+    info.bounds = NULL;
+    info.rows = NULL;
+
+    /* SPLIT THE FILE INTO CHUNKS */
+    if (map_file(file, &mf) != 0)
+    {
+        unmap_file(&mf);
+        PyErr_SetString(PyExc_IOError, "Error memory mapping file");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    ierr = csv_split(&info, mf.data, mf.size, (size_t)skip);
+    Py_END_ALLOW_THREADS
+
+    if (ierr != CSV_READ_E_NONE)
+    {
+        csv_free(&info);
+        unmap_file(&mf);
+        return PyErr_NoMemory();
+    }
+
+    /* DATA ARRAYS */
+    npy_intp dim1[1] = {info.n};
+    npy_intp dim3[2] = {info.n, 3};
+
+    PyArrayObject *time = (PyArrayObject *)PyArray_ZEROS(1, dim1, NPY_DOUBLE, 0);
+    PyArrayObject *accel = (PyArrayObject *)PyArray_ZEROS(2, dim3, NPY_DOUBLE, 0);
+
+    if (!time || !accel)
+    {
+        csv_free(&info);
+        unmap_file(&mf);
+        Py_XDECREF(time);
+        Py_XDECREF(accel);
+        return NULL;
+    }
+
+    /* PARSE */
+    double *time_p = (double *)PyArray_DATA(time), *accel_p = (double *)PyArray_DATA(accel);
+
+    Py_BEGIN_ALLOW_THREADS
+    ierr = csv_parse(&info, time_p, accel_p);
+    if (ierr == CSV_READ_E_NONE)
+    {
+        fs = csv_sampling_rate(time_p, info.n);
+        missing = csv_gap_samples(time_p, info.n, fs, &n_gaps);
+    }
+    Py_END_ALLOW_THREADS
+
+    csv_free(&info);
+    unmap_file(&mf);
+
+    if (ierr != CSV_READ_E_NONE)
+    {
+        Py_XDECREF(time);
+        Py_XDECREF(accel);
+        if (ierr == CSV_READ_E_MEMORY)
+            return PyErr_NoMemory();
+        /* header line is row 0 of the file */
+        PyErr_Format(PyExc_ValueError, "Unable to parse row %li of data as numeric values. "
+            "Use the 'pandas' engine for other file layouts.", info.bad_row + 1);
+        return NULL;
+    }
+
+    /* GAPS */
+    if ((n_gaps > 0) && !fill_gaps)
+    {
+        Py_XDECREF(time);
+        Py_XDECREF(accel);
+        PyErr_SetString(PyExc_ValueError, "There are data gaps in the data, which could potentially "
+            "result in garbage outputs from downstream algorithms.");
+        return NULL;
+    }
+    if (missing > 0)
+    {
+        dim1[0] = info.n + missing;
+        dim3[0] = info.n + missing;
+
+        PyArrayObject *time_f = (PyArrayObject *)PyArray_ZEROS(1, dim1, NPY_DOUBLE, 0);
+        PyArrayObject *accel_f = (PyArrayObject *)PyArray_ZEROS(2, dim3, NPY_DOUBLE, 0);
+
+        if (!time_f || !accel_f)
+        {
+            Py_XDECREF(time);
+            Py_XDECREF(accel);
+            Py_XDECREF(time_f);
+            Py_XDECREF(accel_f);
+            return NULL;
+        }
+
+        Py_BEGIN_ALLOW_THREADS
+        csv_fill_gaps(time_p, accel_p, info.n, fs, (double *)PyArray_DATA(time_f),
+            (double *)PyArray_DATA(accel_f));
+        Py_END_ALLOW_THREADS
+
+        Py_DECREF(time);
+        Py_DECREF(accel);
+        time = time_f;
+        accel = accel_f;
+    }
+
+    return Py_BuildValue(
+        "dNN",  /* need to use N to not increment reference counter */
+        fs,
+        (PyObject *)time,
+        (PyObject *)accel
     );
 }
 
 
-static const char read_axivity__doc__[] = "read_axivity(file, bases, periods)\n"
-"Read an Axivity binary file.\n\n"
+static const char read_axivity__doc__[] = "read_axivity(file, bases, periods, use_mmap=False, workers=1, dtype='float64', time_ns=False, verify=True, out_imu=None, out_time=None, out_temperature=None, index=False, t_last=None, buffers=None)\n"
+"Read an Axivity binary file. The GIL is released while reading, so multiple files can be read\n"
+"at the same time from different threads.\n\n"
 "Parameters\n"
 "----------\n"
 "file : str\n"
@@ -441,20 +1662,249 @@ static const char read_axivity__doc__[] = "read_axivity(file, bases, periods)\n"
 "bases : numpy.ndarray\n"
 "   Base times for providing windowing. Must be in [0, 23].\n"
 "periods : numpy.ndarray\n"
-"   Number of hours for each window. Must be in [1, 24] and the same size as bases.\n\n"
+"   Number of hours for each window. Must be in [1, 24] and the same size as bases.\n"
+"use_mmap : bool, optional\n"
+"   Memory map the file and decode blocks directly from the mapping, instead of reading\n"
+"   each block from the file. Default is False.\n"
+"workers : int, optional\n"
+"   Number of threads to decode the data blocks with. More than 1 worker always memory maps\n"
+"   the file. Default is 1.\n"
+"dtype : {'float64', 'float32', 'int16'}, optional\n"
+"   Data type of the returned sensor data. 'int16' returns the raw sensor counts, see\n"
+"   `scale` and `offset`. Default is 'float64'.\n"
+"time_ns : bool, optional\n"
+"   Return timestamps as int64 nanoseconds instead of float64 seconds. Default is False.\n"
+"verify : bool, optional\n"
+"   Verify the checksum of each data block, and treat blocks that fail as bad blocks. Skipping\n"
+"   the check is faster for files that are known to be good. Default is True.\n"
+"out_imu, out_time, out_temperature : {None, numpy.ndarray}, optional\n"
+"   Storage to decode into instead of allocating new arrays, eg to re-use buffers when reading\n"
+"   many files. Must be writeable, C-contiguous arrays of the output type (timestamps are\n"
+"   int64 if `time_ns`), with at least as many elements as the output. The outputs are views\n"
+"   of the start of the storage, which is cleared before decoding. Default is None.\n"
+"index : bool, optional\n"
+"   Record the sequence, time, sample count, status, and time of day of each data block while\n"
+"   decoding, for a block index. Always memory maps the file. Default is False.\n"
+"t_last : {None, numpy.ndarray}, optional\n"
+"   End time of the last good block after each data block, from a block index of the file. Lets\n"
+"   each worker thread start decoding with the right block times. Default is None.\n"
+"buffers : {None, skdh.io.ReadBuffers}, optional\n"
+"   Re-used storage for any of `out_imu`, `out_time`, and `out_temperature` that are not given,\n"
+"   taken from the buffers named 'imu', 'time', and 'temperature' once the size of the output\n"
+"   is known from the file header. Default is None.\n\n"
 "Returns\n"
 "-------\n"
 "fs : float\n"
 "   Sampling frequency\n"
+"n_bad_samples : int\n"
+"   Number of samples in bad blocks.\n"
 "imudata : numpy.ndarray\n"
 "   IMU data available. Shape is (N, 3/6/9). Order of types is [Gy]Ax[Mag]. Ax (accelerometer) is\n"
 "   required. Gy (gyroscope) and Mag (magnetometer) are optional.\n"
 "time : numpy.ndarray\n"
 "temperature : numpy.ndarray\n"
 "starts : numpy.ndarray\n"
-"stops : numpy.ndarray\n";
+"stops : numpy.ndarray\n"
+"scale : numpy.ndarray\n"
+"   Counts per unit for each axis, for 'int16' output. `value = (counts - offset) / scale`.\n"
+"offset : numpy.ndarray\n"
+"   Offset in counts for each axis, for 'int16' output.\n"
+"bad_blocks : numpy.ndarray\n"
+"   Runs of bad blocks, as [start, stop) sample indices, shape (N, 2). Data for these samples\n"
+"   is 0, and the timestamps are interpolated from the surrounding good blocks.\n"
+"records : {None, tuple}\n"
+"   If `index`, the index records of each data block, the same as `read_axivity_index`.\n"
+"block_samples : int\n"
+"   Number of samples in each data block.\n";
+
+static const char read_axivity_chunk__doc__[] = "read_axivity_chunk(file, bases, periods, block_start, block_stop, t_last, starts, stops, i_window, dtype='float64', time_ns=False, verify=True, anchor=None)\n"
+"Read a range of data blocks from an Axivity binary file. Only the requested blocks are memory\n"
+"mapped and decoded, so a file can be read in pieces with bounded memory use. The GIL is released\n"
+"while decoding.\n\n"
+"Parameters\n"
+"----------\n"
+"file : str\n"
+"   File name to read from\n"
+"bases : numpy.ndarray\n"
+"   Base times for providing windowing. Must be in [0, 23].\n"
+"periods : numpy.ndarray\n"
+"   Number of hours for each window. Must be in [1, 24] and the same size as bases.\n"
+"block_start : int\n"
+"   First data block to read (not counting the 2 header blocks).\n"
+"block_stop : int\n"
+"   Data block to stop reading at (exclusive). Clipped to the number of data blocks.\n"
+"t_last : float\n"
+"   End time of the block before `block_start`, as returned from the previous chunk. Negative if\n"
+"   there is no previous block.\n"
+"starts : numpy.ndarray\n"
+"   Window start indices from the previous chunk, shape (N, bases.size). Use an array of\n"
+"   shape (0, bases.size) for the first chunk.\n"
+"stops : numpy.ndarray\n"
+"   Window stop indices from the previous chunk, shape (N, bases.size).\n"
+"i_window : numpy.ndarray\n"
+"   Current index into `starts` (first row) and `stops` (second row), shape (2, bases.size).\n"
+"   Updated in place.\n"
+"dtype : {'float64', 'float32', 'int16'}, optional\n"
+"   Data type of the returned sensor data. 'int16' returns the raw sensor counts, see\n"
+"   `scale` and `offset`. Default is 'float64'.\n"
+"time_ns : bool, optional\n"
+"   Return timestamps as int64 nanoseconds instead of float64 seconds. Default is False.\n"
+"verify : bool, optional\n"
+"   Verify the checksum of each data block, and treat blocks that fail as bad blocks. Skipping\n"
+"   the check is faster for files that are known to be good. Default is True.\n"
+"anchor : {None, numpy.ndarray}, optional\n"
+"   Sample index (in the file) of the end of the last good block before this chunk, and the\n"
+"   timestamp of its last sample, as a float64 array of size 2. Use [0, 0] for the first chunk.\n"
+"   Updated in place. Default is None, which starts without a previous good block.\n\n"
+"Returns\n"
+"-------\n"
+"fs : float\n"
+"   Sampling frequency\n"
+"n_blocks : int\n"
+"   Total number of data blocks in the file.\n"
+"block_samples : int\n"
+"   Number of samples in each data block.\n"
+"n_bad_samples : int\n"
+"   Number of samples in bad blocks in this chunk.\n"
+"imudata : numpy.ndarray\n"
+"time : numpy.ndarray\n"
+"temperature : numpy.ndarray\n"
+"t_last : float\n"
+"   End time of the last block read, to pass to the next chunk.\n"
+"scale : numpy.ndarray\n"
+"   Counts per unit for each axis, for 'int16' output. `value = (counts - offset) / scale`.\n"
+"offset : numpy.ndarray\n"
+"   Offset in counts for each axis, for 'int16' output.\n"
+"starts : numpy.ndarray\n"
+"   Window start indices up to the end of this chunk, to pass to the next chunk. Grown as needed.\n"
+"stops : numpy.ndarray\n"
+"   Window stop indices up to the end of this chunk, to pass to the next chunk.\n"
+"bad_blocks : numpy.ndarray\n"
+"   Runs of bad blocks in this chunk, as [start, stop) sample indices into the chunk's data,\n"
+"   shape (N, 2). Timestamps are interpolated from the good blocks on either side of each run,\n"
+"   which can be outside of the chunk.\n";
+
+static const char read_axivity_index__doc__[] = "read_axivity_index(file, verify=True)\n"
+"Scan the data block headers of an Axivity binary file, without decoding the data.\n\n"
+"Parameters\n"
+"----------\n"
+"file : str\n"
+"   File name to read from\n"
+"verify : bool, optional\n"
+"   Verify the checksum of each data block, as for `read_axivity`. Default is True.\n\n"
+"Returns\n"
+"-------\n"
+"fs : float\n"
+"   Sampling frequency\n"
+"block_samples : int\n"
+"   Number of samples in each data block.\n"
+"records : tuple\n"
+"   Index records of each data block, as the following arrays:\n\n"
+"sequence : numpy.ndarray\n"
+"   Sequence ID of each data block.\n"
+"time : numpy.ndarray\n"
+"   Time of the first sample of each data block, the same as a full read. 0 for bad blocks.\n"
+"count : numpy.ndarray\n"
+"   Number of samples in each data block.\n"
+"status : numpy.ndarray\n"
+"   0 if the block is good, 1 if bad (checksum failed), 2 if bad and the time of the next\n"
+"   block is not adjusted to the end of the previous block.\n"
+"t_last : numpy.ndarray\n"
+"   End time of the last good block after each block, which the time of the next block\n"
+"   depends on.\n"
+"day_sec : numpy.ndarray\n"
+"   Time of day of each block, in whole seconds, for computing window indices.\n"
+"day_msec : numpy.ndarray\n"
+"   Milliseconds to add to `day_sec` for each block.\n"
+"duration : numpy.ndarray\n"
+"   Time delta of each block for computing window indices.\n";
+
+static const char find_axivity_blocks__doc__[] = "find_axivity_blocks(file, start_time, stop_time, verify=True)\n"
+"Find the data blocks of an Axivity binary file that overlap a time range, with a binary search\n"
+"on the block timestamps.\n\n"
+"Parameters\n"
+"----------\n"
+"file : str\n"
+"   File name to read from\n"
+"start_time : float\n"
+"   Start of the time range, in seconds since the epoch.\n"
+"stop_time : float\n"
+"   End of the time range, in seconds since the epoch.\n"
+"verify : bool, optional\n"
+"   Verify the checksum of the data blocks before the time range, as for `read_axivity_chunk`.\n"
+"   Default is True.\n\n"
+"Returns\n"
+"-------\n"
+"block_start : int\n"
+"   First data block overlapping the time range.\n"
+"block_stop : int\n"
+"   Data block after the last block overlapping the time range.\n"
+"t_last : float\n"
+"   End time of the block before `block_start`, to pass to `read_axivity_chunk` so that\n"
+"   timestamps match a read of the whole file.\n";
+
+static const char read_geneactiv_index__doc__[] = "read_geneactiv_index(file)\n"
+"Scan the pages of a GeneActiv file, without parsing the data.\n\n"
+"Parameters\n"
+"----------\n"
+"file : str\n"
+"   File name to read from\n\n"
+"Returns\n"
+"-------\n"
+"fs : float\n"
+"   Sampling frequency\n"
+"N : int\n"
+"   Number of pages found. Values past this in the returned arrays are not set.\n"
+"records : tuple\n"
+"   Index records of each page, the same arrays as `read_axivity_index`. `count` is always\n"
+"   300, `t_last` is not used and is 0, and `status` is 0 if the page is good, 1 if the page\n"
+"   data is too short. The arrays are:\n\n"
+"sequence : numpy.ndarray\n"
+"   Sequence number of each page.\n"
+"time : numpy.ndarray\n"
+"   Time of the first sample of each page.\n"
+"count : numpy.ndarray\n"
+"status : numpy.ndarray\n"
+"t_last : numpy.ndarray\n"
+"day_sec : numpy.ndarray\n"
+"   Time of day of each page, in whole seconds, for computing window indices.\n"
+"day_msec : numpy.ndarray\n"
+"   Milliseconds to add to `day_sec` for each page.\n"
+"duration : numpy.ndarray\n"
+"   Time delta of each page for computing window indices.\n";
+
+static const char index_windows__doc__[] = "index_windows(fs, block_samples, max_n, block_n, status, day_sec, day_msec, duration, bases, periods)\n"
+"Compute window start and stop indices from the block times of a file index, without reading the file.\n\n"
+"Parameters\n"
+"----------\n"
+"fs : float\n"
+"   Sampling frequency\n"
+"block_samples : int\n"
+"   Number of samples in each block.\n"
+"max_n : int\n"
+"   Number of blocks in the file.\n"
+"block_n : numpy.ndarray\n"
+"   Block number of each block, which the sample indices are computed from.\n"
+"status : numpy.ndarray\n"
+"   Status of each block. Only blocks with a status of 0 are used.\n"
+"day_sec : numpy.ndarray\n"
+"   Time of day of each block, in whole seconds.\n"
+"day_msec : numpy.ndarray\n"
+"   Milliseconds to add to `day_sec` for each block.\n"
+"duration : numpy.ndarray\n"
+"   Time delta of each block.\n"
+"bases : numpy.ndarray\n"
+"   Base (start) hours for windows.\n"
+"periods : numpy.ndarray\n"
+"   Window lengths.\n\n"
+"Returns\n"
+"-------\n"
+"starts : numpy.ndarray\n"
+"   Indices for the start of windows.\n"
+"stops : numpy.ndarray\n"
+"   Indices for the end of windows.\n";
 
-static const char read_geneactiv__doc__[] = "read_geneactiv(file, bases, periods)\n"
+static const char read_geneactiv__doc__[] = "read_geneactiv(file, bases, periods, dtype='float64', time_ns=False, use_mmap=False, workers=1, out_accel=None, out_time=None, out_light=None, out_temperature=None, index=False)\n"
 "Read a Geneactiv File\n\n"
 "Parameters\n"
 "----------\n"
@@ -463,7 +1913,25 @@ static const char read_geneactiv__doc__[] = "read_geneactiv(file, bases, periods
 "bases : numpy.ndarray\n"
 "   Base times for providing windowing. Must be in [0, 23]\n"
 "periods : numpy.ndarray\n"
-"   Number of hours for each window. Must be in [1, 24]\n\n"
+"   Number of hours for each window. Must be in [1, 24]\n"
+"dtype : {'float64', 'float32', 'int16'}, optional\n"
+"   Data type of the returned sensor data. 'int16' returns the raw sensor counts, see\n"
+"   `scale` and `offset`. Default is 'float64'.\n"
+"time_ns : bool, optional\n"
+"   Return timestamps as int64 nanoseconds instead of float64 seconds. Default is False.\n"
+"use_mmap : bool, optional\n"
+"   Memory map the file and parse the pages from the mapping, across `workers` threads.\n"
+"   Default is False.\n"
+"workers : int, optional\n"
+"   Number of threads to parse pages with. If more than 1, the file is always memory mapped.\n"
+"   Default is 1.\n"
+"out_accel, out_time, out_light, out_temperature : {None, numpy.ndarray}, optional\n"
+"   Storage to parse into instead of allocating new arrays. Must be writeable, C-contiguous\n"
+"   arrays of the output type, with at least as many elements as the output. The outputs are\n"
+"   views of the start of the storage, which is cleared before parsing. Default is None.\n"
+"index : bool, optional\n"
+"   Record the sequence, time, and time of day of each page while parsing, for a block index.\n"
+"   Always memory maps the file. Default is False.\n\n"
 "Returns\n"
 "-------\n"
 "N : int\n"
@@ -475,11 +1943,54 @@ static const char read_geneactiv__doc__[] = "read_geneactiv(file, bases, periods
 "light : numpy.ndarray\n"
 "temp : numpy.ndarray\n"
 "starts : numpy.ndarray\n"
-"stops : numpy.ndarray\n";
+"stops : numpy.ndarray\n"
+"scale : numpy.ndarray\n"
+"   Counts per unit for each axis, for 'int16' output. `value = (counts - offset) / scale`.\n"
+"offset : numpy.ndarray\n"
+"   Offset in counts for each axis, for 'int16' output.\n"
+"records : {None, tuple}\n"
+"   If `index`, the number of pages found, and their index records, the same as\n"
+"   `read_geneactiv_index`.\n";
+
+static const char read_csv_numeric__doc__[] = "read_csv_numeric(file, skip, cols, delimiter, time_scale, accel_scale, fill_gaps=True, workers=1)\n"
+"Read a CSV file of numeric timestamps and acceleration values.\n\n"
+"Parameters\n"
+"----------\n"
+"file : str\n"
+"   File name to read from.\n"
+"skip : int\n"
+"   Byte offset of the first row of data, ie the size of the header.\n"
+"cols : tuple\n"
+"   Column indices of the time, and x, y, z acceleration values.\n"
+"delimiter : str\n"
+"   Single character column delimiter.\n"
+"time_scale : float\n"
+"   Timestamps are multiplied by this value to get seconds.\n"
+"accel_scale : float\n"
+"   Acceleration values are multiplied by this value to get g.\n"
+"fill_gaps : bool, optional\n"
+"   Fill gaps in the data with [0, 0, 1] g at the sampling frequency. If False, gaps raise\n"
+"   a ValueError. Default is True.\n"
+"workers : int, optional\n"
+"   Number of threads to parse the file with. Default is 1.\n\n"
+"Returns\n"
+"-------\n"
+"fs : float\n"
+"   Sampling frequency, estimated from the first 2500 samples.\n"
+"time : numpy.ndarray\n"
+"   Timestamps, in seconds.\n"
+"accel : numpy.ndarray\n"
+"   Acceleration, in g.\n";
 
 static struct PyMethodDef methods[] = {
   {"read_geneactiv", read_geneactiv, 1, read_geneactiv__doc__},
   {"read_axivity", read_axivity, 1, read_axivity__doc__},
+  {"read_axivity_chunk", read_axivity_chunk, 1, read_axivity_chunk__doc__},
+  {"read_axivity_index", read_axivity_index, 1, read_axivity_index__doc__},
+  {"find_axivity_blocks", find_axivity_blocks, 1, find_axivity_blocks__doc__},
+  {"read_geneactiv_index", read_geneactiv_index, 1, read_geneactiv_index__doc__},
+  {"index_windows", index_windows, 1, index_windows__doc__},
+  {"read_csv_numeric", read_csv_numeric, 1, read_csv_numeric__doc__},
   {NULL, NULL, 0, NULL}  /* sentinel */
 };
 
@@ -1,6 +1,7 @@
 // Copyright (c) 2021. Pfizer Inc. All rights reserved.
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <time.h>
 #include <math.h>
@@ -17,7 +18,8 @@ GENERAL
 #define SECHOUR 3600
 #define DAYSEC 86400.f
 
-#define MAX_DAYS 25
+/* initial number of window indices allocated, the storage is grown as needed */
+#define WINDOW_INIT_DAYS 16
 
 #ifdef DEBUG
     #define DEBUG_PRINTF(...) printf("DEBUG: "__VA_ARGS__)
@@ -33,8 +35,35 @@ typedef struct {
     long *periods;  /* lengths of windows */
     long *i_start;  /* index for start array */
     long *i_stop;  /* index for end array */
+    long max_days;  /* number of rows allocated for starts/stops */
+    long *starts;  /* (max_days, n) start indices of windows */
+    long *stops;  /* (max_days, n) stop indices of windows */
 } Window_t;
 
+int window_init(Window_t *winfo, long n, long *bases, long *periods, long max_days);
+int window_reserve(Window_t *winfo);
+long window_rows(Window_t *winfo);
+void window_free(Window_t *winfo);
+
+/* data type of the returned sensor data */
+typedef enum {
+    READ_OUT_FLOAT64 = 0,
+    READ_OUT_FLOAT32 = 1,  /* scaled values */
+    READ_OUT_INT16 = 2  /* raw counts, with separate scale and offset for each axis */
+} Read_Output_t;
+
+/* memory mapped (read-only) file */
+typedef struct {
+    int fd;  /* file descriptor */
+    char *data;  /* start of the mapping */
+    size_t size;  /* size of the file/mapping in bytes */
+    size_t pad;  /* bytes between the page aligned start of the mapping and `data` */
+} MappedFile_t;
+
+int map_file(const char *file, MappedFile_t *mf);
+int map_file_range(const char *file, size_t offset, size_t length, MappedFile_t *mf);
+void unmap_file(MappedFile_t *mf);
+
 /* match time_t from utility.f95 */
 typedef struct {
     long hour;
@@ -43,6 +72,26 @@ typedef struct {
     long msec;  /* NOTE that this is an integer! ex. 0.500 -> 500 */
 } Time_t;
 
+/* time of day of each block of an index, as needed for computing window indices */
+typedef struct {
+    long *sec;  /* seconds since midnight of the block time */
+    long *msec;  /* milliseconds to add to `sec`. Can be negative, or over 1000 */
+    double *duration;  /* time delta of the block */
+} Index_Day_t;
+
+/* records of each block of a file for a block index, made as the blocks are read */
+typedef struct {
+    long *seq;  /* sequence number of each block */
+    double *time;  /* time of the first sample of each block, 0 for bad blocks */
+    long *count;  /* number of samples in each block */
+    char *status;  /* status of each block, 0 if good */
+    double *t_last;  /* end time of the last good block after each block, 0 for GeneActiv files */
+    Index_Day_t day;
+} Index_t;
+
+int index_day_indexing(double fs, long block_samples, long max_n, long nblocks, long *block_n,
+    char *status, Index_Day_t *day, Window_t *winfo);
+
 /* 
 get_day_indexing(fs, dtime, mxd, n, bases, periods, block_n, max_n, block_samples, starts, 
     i_starts, stops, i_stops)
@@ -55,6 +104,12 @@ extern void get_day_indexing(double *, Time_t *, double *, long *, long *, long
 AXIVITY
 ======================================
 */
+/* unpacked blocks have at most 80 samples of 3 axes (240 values), packed blocks 120 samples of 3 */
+#define AX_MAX_BLOCK_SAMPLES 120
+#define AX_MAX_BLOCK_VALUES 360
+/* range code of a block that was not decoded */
+#define AX_RANGE_NONE 0xff
+
 typedef struct {
     long deviceId;
     long sessionId;
@@ -62,11 +117,12 @@ typedef struct {
     int8_t axes;
     int16_t count;
     double tLast;
-    int N;
+    int N;  /* file descriptor of the open file, -1 if not open */
     double frequency;
     long Nwin;  /* number of windows (bases/periods) */
-    long max_days;  /* max days set for the size of the starts/stops array */
+    long max_days;  /* rows of the starts/stops arrays, kept in sync with Window_t */
     long n_bad_blocks;  /* number of blocks with nonzero checksums */
+    int verify;  /* verify the checksum of each data block */
 } AX_Info_t;
 
 typedef struct {
@@ -77,6 +133,36 @@ typedef struct {
     long *day_stops;
 } AX_Data_t;
 
+/* status of each block after decoding */
+typedef enum {
+    AX_BLOCK_GOOD = 0,
+    AX_BLOCK_BAD = 1,  /* bad block, previous block time still used for the next block */
+    AX_BLOCK_BAD_RESET = 2  /* bad block, previous block time is reset */
+} AX_Block_Status_t;
+
+/* timestamp repair of bad blocks, done as the blocks are decoded */
+typedef struct {
+    long end;  /* sample index (+1) of the end of the last good block, or of the start of the file
+    if there is none yet. Relative to the start of the storage, so can be negative */
+    double t_end;  /* time of the last sample of the last good block, 0 if none yet */
+    long n;  /* number of repaired runs of bad blocks */
+    long size;  /* number of runs there is storage for */
+    long *runs;  /* (start, stop) sample indices of each repaired run, shape (size, 2) */
+} AX_Repair_t;
+
+/* storage for data that is not returned as double */
+typedef struct {
+    Read_Output_t dtype;
+    void *imu;  /* float or int16_t */
+    float *temp;
+    long offset;  /* sample index (in the file) of the first sample in the storage */
+    long n;  /* number of samples the storage holds */
+    unsigned char *range;  /* range code of each block in the storage for integer output, or NULL */
+    long n_range;  /* number of blocks there is storage for in `range` */
+    unsigned char *filled;  /* if each block of the storage was decoded, n_filled long, or NULL */
+    long n_filled;
+} AX_Output_t;
+
 typedef enum {
     AX_READ_E_NONE = 0,
     AX_READ_E_BAD_HEADER = 1,
@@ -86,13 +172,50 @@ typedef enum {
     AX_READ_E_BAD_PACKING_CODE = 5,
     AX_READ_E_BAD_CHECKSUM = 6,
     AX_READ_E_BAD_LENGTH_ZERO_TIMESTAMPS = 7,
+    AX_READ_E_MEMORY = 8,
+    AX_READ_E_FILE_OPEN = 9,
+    AX_READ_E_FILE_READ = 10,
 } Read_Cwa_Error_t;
 
-extern void axivity_read_header(long *, char[], AX_Info_t *, int *);
-extern void axivity_read_block(AX_Info_t *, long *, double *, double *, double *, long *, long *,
+extern void axivity_parse_header(char *, AX_Info_t *, int *);
+extern void axivity_decode_block(AX_Info_t *, char *, double *, double *, double *, long *, long *,
     long *, long *, long *, long *, int *);
-extern void adjust_timestamps(AX_Info_t *, double *, int *);
-extern void axivity_close(AX_Info_t *);
+extern void axivity_block_time(AX_Info_t *, char *, int *, double *, long *, long *, long *, long *,
+    long *, long *);
+
+int axivity_read_header(const char *file, AX_Info_t *info);
+int axivity_read_block(AX_Info_t *info, long block, long n, unsigned char *filled, double *imu,
+    double *ts, double *temp, Window_t *winfo, AX_Repair_t *repair);
+void axivity_close(AX_Info_t *info);
+
+void axivity_range_scales(AX_Info_t *info, unsigned char range, double *scale);
+long axivity_scale_runs(AX_Info_t *info, AX_Output_t *out, double *scale, long *index);
+int axivity_window_reserve(AX_Info_t *info, Window_t *winfo);
+long axivity_block_start(AX_Info_t *info, char *block, long offset, long n);
+int axivity_decode_block_as(AX_Info_t *info, char *block, AX_Output_t *out, double *imu, double *ts,
+    double *temp, Window_t *winfo, AX_Repair_t *repair);
+void axivity_clear_undecoded(AX_Info_t *info, AX_Output_t *out, double *imu, double *ts,
+    double *temp, AX_Repair_t *repair);
+int axivity_block_checksum(AX_Info_t *info, char *block);
+int axivity_block_status(AX_Info_t *info, char *block, long nblocks, int *status);
+void axivity_unpack_packed(const char *data, int n, double scale, double *out);
+void axivity_index_block(Index_t *index, long i, char *block, int status, double t_prev, double t0,
+    double t_last);
+void axivity_index_decoded(AX_Info_t *info, Index_t *index, long i, char *block, long n_bad,
+    double t_prev, double *ts, long offset);
+int axivity_read_index(AX_Info_t *info, char *data, Index_t *index);
+void axivity_find_blocks(AX_Info_t *info, char *data, double start_time, double stop_time,
+    long *block_start, long *block_stop, double *t_last);
+int axivity_read_blocks_parallel(AX_Info_t *info, char *data, int workers, AX_Output_t *out,
+    double *imu, double *ts, double *temp, Window_t *winfo, AX_Repair_t *repair,
+    double *t_seed, Index_t *index);
+void axivity_repair_init(AX_Repair_t *rep);
+int axivity_repair_block(AX_Info_t *info, AX_Repair_t *rep, double *ts, long i0);
+int axivity_repair_finish(AX_Info_t *info, AX_Repair_t *rep, double *ts, long n, long i_next,
+    double t_next);
+int axivity_repair_next(AX_Info_t *info, char *data, long n, long offset, long *i_next,
+    double *t_next);
+void axivity_repair_free(AX_Repair_t *rep);
 
 /*
 ======================================
@@ -121,7 +244,10 @@ typedef enum {
     GN_READ_E_BLOCK_FS_WARN,  /* warning about FS */
     GN_READ_E_BLOCK_MISSING_BLOCK_WARN,  /* warn about a missing block of data */
     GN_READ_E_BLOCK_DATA,  /* error reading block data */
-    GN_READ_E_BLOCK_DATA_3600  /* data is less than 3600 characters */
+    GN_READ_E_BLOCK_DATA_3600,  /* data is less than 3600 characters */
+    GN_READ_E_BLOCK_SEQUENCE,  /* page sequence number is outside the number of pages */
+    GN_READ_E_MEMORY,  /* error allocating memory */
+    GN_READ_E_MMAP  /* error memory mapping the file */
 } Read_Bin_Error_t;
 
 
@@ -138,14 +264,68 @@ typedef struct {
 } GN_Info_t;
 
 typedef struct {
-    double *acc;
-    double *light;
-    double *temp;
+    Read_Output_t dtype;  /* double, float, or int16_t (raw counts) for acc. light & temp are float if not double */
+    void *acc;
+    void *light;
+    void *temp;
     double *ts;
-    long *day_starts;
-    long *day_stops;
+    unsigned char *filled;  /* if each page was read, npages long, or NULL */
 } GN_Data_t;
 
 
+/* information of a page parsed from memory, needed to finish the page in order */
+typedef struct {
+    long seq;  /* page sequence number */
+    double fs;  /* page sampling frequency */
+    double t0;  /* time of the first sample */
+    Time_t t;  /* time of day of the first sample */
+} GN_Page_t;
+
+
 int geneactiv_read_header(FILE *fp, GN_Info_t *info);
 int geneactiv_read_block(FILE *fp, Window_t *w_info, GN_Info_t *info, GN_Data_t *data);
+double geneactiv_page_time(char time[40], Time_t *t);
+int geneactiv_day_indexing(Time_t *t, GN_Info_t *info, Window_t *winfo);
+int geneactiv_parse_page(char *page, char *end, GN_Info_t *info, GN_Data_t *data, GN_Page_t *pg);
+int geneactiv_finish_page(GN_Page_t *pg, GN_Info_t *info, Window_t *winfo);
+int geneactiv_read_pages_parallel(GN_Info_t *info, char *data, size_t size, size_t offset,
+    int workers, Window_t *winfo, GN_Data_t *out, int *fs_warn, Index_t *index, long *n_index);
+void geneactiv_index_page(Index_t *index, long i, long seq, Time_t *t, double t0, double fs,
+    int status);
+long geneactiv_read_index(FILE *fp, GN_Info_t *info, Index_t *index);
+void geneactiv_clear_unread(GN_Info_t *info, GN_Data_t *data);
+
+
+/*
+======================================
+CSV
+======================================
+*/
+typedef enum {
+    CSV_READ_E_NONE = 0,
+    CSV_READ_E_PARSE = 1,  /* a row of data could not be parsed */
+    CSV_READ_E_MEMORY = 2,
+} Read_Csv_Error_t;
+
+typedef struct {
+    long cols[4];  /* column index of the time, and x, y, z acceleration values */
+    char delimiter;
+    double time_scale;  /* timestamps are multiplied by this to get seconds */
+    double accel_scale;  /* acceleration values are multiplied by this to get g */
+    int workers;  /* maximum number of threads to use */
+    long max_col;  /* last column that is needed */
+    const char *end;  /* end of the file data */
+    int nchunks;  /* number of chunks the data is split into */
+    const char **bounds;  /* start of each chunk, plus the end of the last chunk */
+    long *rows;  /* first row of each chunk, plus the total number of rows */
+    long n;  /* number of rows of data */
+    long bad_row;  /* first row that could not be parsed, -1 if none */
+} CSV_Info_t;
+
+int csv_split(CSV_Info_t *info, const char *data, size_t size, size_t offset);
+int csv_parse(CSV_Info_t *info, double *time, double *accel);
+void csv_free(CSV_Info_t *info);
+double csv_sampling_rate(const double *time, long n);
+long csv_gap_samples(const double *time, long n, double fs, long *n_gaps);
+void csv_fill_gaps(const double *time, const double *accel, long n, double fs, double *time_out,
+    double *accel_out);
@@ -0,0 +1,389 @@
+// Copyright (c) 2023. Pfizer Inc. All rights reserved.
+#include <pthread.h>
+
+#include "read_binary_imu.h"
+
+/*
+Numeric CSV files (eg "time,x,y,z" with unix timestamps) are parsed straight from a memory mapping
+of the file. The data is split into one chunk per thread at line boundaries. The rows of each chunk
+are counted first, so that each chunk knows where its rows go in the output, and then the chunks
+are parsed in parallel straight into the output arrays. Empty lines are skipped.
+*/
+
+/* work for a single counting/parsing thread */
+typedef struct {
+    CSV_Info_t *info;
+    int k;  /* chunk index */
+    double *time;
+    double *accel;
+    long bad_row;  /* first row that could not be parsed */
+    int ierr;
+} CSV_Thread_t;
+
+
+/* end of the line starting at `p`, and the start of the next line */
+static const char *line_end(const char *p, const char *end, const char **next)
+{
+    const char *nl = memchr(p, '\n', end - p), *le;
+
+    le = nl ? nl : end;
+    *next = nl ? nl + 1 : end;
+    /* windows line endings */
+    if ((le > p) && (le[-1] == '\r'))
+        le--;
+    return le;
+}
+
+/* parse a single numeric field in [p, fe). The field has to be followed by a delimiter, a line end,
+or a NUL, so that `strtod` can not run past the end of it */
+static int parse_field(const char *p, const char *fe, double *value)
+{
+    char *e;
+
+    /* strtod skips leading whitespace, which could include the end of the line */
+    while ((p < fe) && ((*p == ' ') || (*p == '\t')))
+        p++;
+    if (p == fe)
+        return 0;
+
+    *value = strtod(p, &e);
+    if ((e == p) || (e > fe))
+        return 0;
+    /* only trailing whitespace after the number */
+    for (; e < fe; ++e)
+    {
+        if ((*e != ' ') && (*e != '\t') && (*e != '\r'))
+            return 0;
+    }
+    return 1;
+}
+
+/* parse the time and acceleration values from a single (non-empty) line */
+static int parse_line(CSV_Info_t *info, const char *p, const char *le, double *time, double *accel)
+{
+    const char *fe;
+    double v;
+    int found = 0;
+
+    for (long col = 0; (col <= info->max_col) && (p <= le); ++col)
+    {
+        fe = memchr(p, info->delimiter, le - p);
+        fe = fe ? fe : le;
+
+        for (int j = 0; j < 4; ++j)
+        {
+            if (info->cols[j] != col)
+                continue;
+            if (!parse_field(p, fe, &v))
+                return 0;
+
+            if (j == 0)
+                *time = v * info->time_scale;
+            else
+                accel[j - 1] = v * info->accel_scale;
+            found++;
+        }
+        p = fe + 1;
+    }
+    return found == 4;
+}
+
+/* count the (non-empty) rows of a chunk */
+static void *csv_count_chunk(void *arg)
+{
+    CSV_Thread_t *t = (CSV_Thread_t *)arg;
+    const char *p = t->info->bounds[t->k], *end = t->info->bounds[t->k + 1], *next, *le;
+    long n = 0;
+
+    while (p < end)
+    {
+        le = line_end(p, end, &next);
+        n += le > p;
+        p = next;
+    }
+    t->info->rows[t->k + 1] = n;
+
+    return NULL;
+}
+
+/* parse the rows of a chunk into their place in the output */
+static void *csv_parse_chunk(void *arg)
+{
+    CSV_Thread_t *t = (CSV_Thread_t *)arg;
+    CSV_Info_t *info = t->info;
+    const char *p = info->bounds[t->k], *end = info->bounds[t->k + 1], *next, *le;
+    char *buf = NULL;
+    long i = info->rows[t->k];
+
+    t->ierr = CSV_READ_E_NONE;
+    while (p < end)
+    {
+        le = line_end(p, end, &next);
+        if (le == p)
+        {
+            p = next;
+            continue;
+        }
+
+        /* the last line of a file without a final newline is not followed by anything that stops
+        strtod, so parse a terminated copy of it */
+        if ((next == info->end) && (le == info->end))
+        {
+            if (!(buf = (char *)malloc(le - p + 1)))
+            {
+                t->ierr = CSV_READ_E_MEMORY;
+                return NULL;
+            }
+            memcpy(buf, p, le - p);
+            buf[le - p] = '\0';
+            le = buf + (le - p);
+            p = buf;
+        }
+
+        if (!parse_line(info, p, le, &t->time[i], &t->accel[3 * i]))
+        {
+            t->ierr = CSV_READ_E_PARSE;
+            t->bad_row = i;
+            free(buf);
+            return NULL;
+        }
+        i++;
+        p = next;
+    }
+    free(buf);
+
+    return NULL;
+}
+
+/* run `fn` over all the chunks, one thread per chunk */
+static int csv_run(CSV_Info_t *info, void *(*fn)(void *), double *time, double *accel)
+{
+    int ierr = CSV_READ_E_NONE;
+    CSV_Thread_t *work = (CSV_Thread_t *)malloc(info->nchunks * sizeof(CSV_Thread_t));
+    pthread_t *threads = (pthread_t *)malloc(info->nchunks * sizeof(pthread_t));
+    int *started = (int *)calloc(info->nchunks, sizeof(int));
+
+    if (!work || !threads || !started)
+    {
+        free(work); free(threads); free(started);
+        return CSV_READ_E_MEMORY;
+    }
+
+    for (int k = 0; k < info->nchunks; ++k)
+    {
+        work[k].info = info;
+        work[k].k = k;
+        work[k].time = time;
+        work[k].accel = accel;
+        work[k].bad_row = -1;
+        work[k].ierr = CSV_READ_E_NONE;
+
+        /* if a thread cannot be started, run its chunk after the others are started. The first
+        chunk is always done on this thread */
+        started[k] = (k > 0) && (pthread_create(&threads[k], NULL, fn, &work[k]) == 0);
+    }
+
+    for (int k = 0; k < info->nchunks; ++k)
+    {
+        if (!started[k])
+            fn(&work[k]);
+    }
+    for (int k = 0; k < info->nchunks; ++k)
+    {
+        if (started[k])
+            pthread_join(threads[k], NULL);
+        /* report the first error in the file */
+        if ((ierr == CSV_READ_E_NONE) && (work[k].ierr != CSV_READ_E_NONE))
+        {
+            ierr = work[k].ierr;
+            info->bad_row = work[k].bad_row;
+        }
+    }
+
+    free(work);
+    free(threads);
+    free(started);
+
+    return ierr;
+}
+
+/**
+ * Split the data of a CSV file into chunks at line boundaries, and count the rows of data.
+ *
+ * @param info    CSV information. `cols`, `delimiter`, `time_scale`, `accel_scale`, and `workers`
+ *                have to be set. Has to be freed with `csv_free`.
+ * @param data    Start of the file data, eg memory mapped
+ * @param size    Size of the file
+ * @param offset  Offset of the first line of data, ie the end of the header
+ *
+ * @result Read_Csv_Error_t error value
+ */
+int csv_split(CSV_Info_t *info, const char *data, size_t size, size_t offset)
+{
+    const char *start = data + (offset < size ? offset : size), *p, *nl;
+    int workers = info->workers > 0 ? info->workers : 1;
+
+    info->end = data + size;
+    info->bad_row = -1;
+    info->n = 0;
+    info->max_col = 0;
+    for (int j = 0; j < 4; ++j)
+        info->max_col = info->cols[j] > info->max_col ? info->cols[j] : info->max_col;
+
+    /* at least 64KB per chunk, not worth the threads otherwise */
+    if ((size_t)workers > (size - (start - data)) / (1 << 16) + 1)
+        workers = (int)((size - (start - data)) / (1 << 16)) + 1;
+
+    info->bounds = (const char **)malloc((workers + 1) * sizeof(char *));
+    info->rows = (long *)calloc(workers + 1, sizeof(long));
+    if (!info->bounds || !info->rows)
+        return CSV_READ_E_MEMORY;
+
+    /* chunks start at the start of a line */
+    info->nchunks = 0;
+    info->bounds[0] = start;
+    for (int k = 1; k < workers; ++k)
+    {
+        p = start + (size - (start - data)) / workers * k;
+        if (p <= info->bounds[info->nchunks])
+            continue;
+        nl = memchr(p, '\n', info->end - p);
+        p = nl ? nl + 1 : info->end;
+        if (p >= info->end)
+            break;
+        if (p > info->bounds[info->nchunks])
+            info->bounds[++info->nchunks] = p;
+    }
+    info->bounds[++info->nchunks] = info->end;
+
+    int ierr = csv_run(info, csv_count_chunk, NULL, NULL);
+
+    /* first output row of each chunk */
+    for (int k = 0; k < info->nchunks; ++k)
+        info->rows[k + 1] += info->rows[k];
+    info->n = info->rows[info->nchunks];
+
+    return ierr;
+}
+
+/**
+ * Parse the rows of data of a CSV file, after splitting with `csv_split`.
+ *
+ * @param info  CSV information, from `csv_split`
+ * @param time  Timestamp storage, in seconds. Size of `info->n`
+ * @param accel Acceleration storage, in g. Shape (info->n, 3)
+ *
+ * @result Read_Csv_Error_t error value. If CSV_READ_E_PARSE, `info->bad_row` is the first row
+ *         that could not be parsed
+ */
+int csv_parse(CSV_Info_t *info, double *time, double *accel)
+{
+    return csv_run(info, csv_parse_chunk, time, accel);
+}
+
+/**
+ * Free the storage of the CSV information.
+ *
+ * @param info CSV information
+ */
+void csv_free(CSV_Info_t *info)
+{
+    free(info->bounds);
+    free(info->rows);
+    info->bounds = NULL;
+    info->rows = NULL;
+}
+
+/**
+ * Estimate the sampling frequency from the first 2500 samples.
+ *
+ * @param time Timestamps, in seconds
+ * @param n    Number of samples
+ *
+ * @result Mean of the inverse of the time deltas
+ */
+double csv_sampling_rate(const double *time, long n)
+{
+    double fs = 0.;
+    long m = n < 2500 ? n : 2500;
+
+    for (long i = 1; i < m; ++i)
+        fs += 1. / (time[i] - time[i - 1]);
+
+    return m > 1 ? fs / (m - 1) : 0.;
+}
+
+/**
+ * Count the samples missing from gaps in the data. A gap is a time delta larger than 1.5 samples.
+ *
+ * @param time   Timestamps, in seconds
+ * @param n      Number of samples
+ * @param fs     Sampling frequency
+ * @param n_gaps Set to the number of gaps, including gaps backwards in time
+ *
+ * @result Number of samples needed to fill the gaps
+ */
+long csv_gap_samples(const double *time, long n, double fs, long *n_gaps)
+{
+    double dt;
+    long missing = 0;
+
+    *n_gaps = 0;
+    for (long i = 1; i < n; ++i)
+    {
+        dt = time[i] - time[i - 1];
+        if (fabs(dt) > 1.5 / fs)
+        {
+            *n_gaps += 1;
+            if (dt > 0.)
+                missing += lround(dt * fs) - 1;
+        }
+    }
+    return missing;
+}
+
+/**
+ * Copy the data into storage that has room for the missing samples, filling the gaps with samples
+ * at the sampling frequency. Filled acceleration values are [0, 0, 1] g.
+ *
+ * @param time      Timestamps, in seconds
+ * @param accel     Acceleration, shape (n, 3)
+ * @param n         Number of samples
+ * @param fs        Sampling frequency
+ * @param time_out  Storage for the filled timestamps, size of `n` plus the missing samples from
+ *                  `csv_gap_samples`
+ * @param accel_out Storage for the filled acceleration
+ */
+void csv_fill_gaps(const double *time, const double *accel, long n, double fs, double *time_out,
+    double *accel_out)
+{
+    double dt;
+    long j = 0, i0 = 0, missing;
+
+    for (long i = 1; i <= n; ++i)
+    {
+        missing = 0;
+        if (i < n)
+        {
+            dt = time[i] - time[i - 1];
+            if ((dt > 0.) && (dt > 1.5 / fs))
+                missing = lround(dt * fs) - 1;
+        }
+        if ((missing == 0) && (i < n))
+            continue;
+
+        /* copy the run of samples since the last gap, then fill the gap */
+        memcpy(time_out + j, time + i0, (i - i0) * sizeof(double));
+        memcpy(accel_out + 3 * j, accel + 3 * i0, 3 * (i - i0) * sizeof(double));
+        j += i - i0;
+        i0 = i;
+
+        for (long k = 1; k <= missing; ++k, ++j)
+        {
+            time_out[j] = time[i - 1] + k / fs;
+            accel_out[3 * j] = 0.;
+            accel_out[3 * j + 1] = 0.;
+            accel_out[3 * j + 2] = 1.;
+        }
+    }
+}
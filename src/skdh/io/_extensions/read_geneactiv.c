@@ -1,13 +1,84 @@
 // Copyright (c) 2021. Pfizer Inc. All rights reserved.
 #include "read_binary_imu.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* value of each hex digit. Characters that are not hex digits are 0 */
+static const uint8_t HEX_NIBBLE[256] = {
+    ['0'] = 0, ['1'] = 1, ['2'] = 2, ['3'] = 3, ['4'] = 4,
+    ['5'] = 5, ['6'] = 6, ['7'] = 7, ['8'] = 8, ['9'] = 9,
+    ['A'] = 10, ['B'] = 11, ['C'] = 12, ['D'] = 13, ['E'] = 14, ['F'] = 15,
+    ['a'] = 10, ['b'] = 11, ['c'] = 12, ['d'] = 13, ['e'] = 14, ['f'] = 15
+};
+
 void parseline(FILE *fp, char *buff, int buff_len, char **key, char **val)
 {
+    char *save = NULL;
+
     fgets(buff, buff_len, fp);
-    *key = strtok(buff, ":");
-    *val = strtok(NULL, ":");
+    /* strtok_r, as files can be read from several threads at once */
+    *key = strtok_r(buff, ":", &save);
+    *val = strtok_r(NULL, ":", &save);
 }
 
+/* set a value in float or double storage */
+static inline void set_value(void *arr, Read_Output_t dtype, long i, double value)
+{
+    if (dtype == READ_OUT_FLOAT64)
+        ((double *)arr)[i] = value;
+    else
+        ((float *)arr)[i] = (float)value;
+}
+
+/**
+ * Convert hex digit characters to their values, 16 at a time with SIMD where available.
+ *
+ * @param str Hex digit characters
+ * @param nib Storage for the value of each character
+ * @param n   Number of characters
+ */
+static void hex_to_nibbles(const char *str, uint8_t *nib, int n)
+{
+    int i = 0;
+
+    /* '0'-'9' are 0x30-0x39, and 'A'-'F' and 'a'-'f' are 0x41-0x46 and 0x61-0x66, so the value
+    is the low 4 bits, plus 9 for letters */
+#if defined(__SSE2__)
+    const __m128i low = _mm_set1_epi8(0x0f);
+    const __m128i digits = _mm_set1_epi8(0x40);
+    const __m128i nine = _mm_set1_epi8(9);
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)(str + i));
+        __m128i letter = _mm_cmpgt_epi8(c, digits);
+        __m128i v = _mm_add_epi8(_mm_and_si128(c, low), _mm_and_si128(letter, nine));
+        _mm_storeu_si128((__m128i *)(nib + i), v);
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t low = vdupq_n_u8(0x0f);
+    const uint8x16_t digits = vdupq_n_u8(0x40);
+    const uint8x16_t nine = vdupq_n_u8(9);
+
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t c = vld1q_u8((const uint8_t *)(str + i));
+        uint8x16_t letter = vcgtq_u8(c, digits);
+        uint8x16_t v = vaddq_u8(vandq_u8(c, low), vandq_u8(letter, nine));
+        vst1q_u8(nib + i, v);
+    }
+#endif
+    for (; i < n; ++i)
+        nib[i] = HEX_NIBBLE[(uint8_t)str[i]];
+}
+
+/* 12-bit value from 3 hex digit values */
+#define GN_HEX12(_n) (((long)(_n)[0] << 8) | ((long)(_n)[1] << 4) | (long)(_n)[2])
+
 int geneactiv_read_header(FILE *fp, GN_Info_t *info)
 {
     char buff[255];
@@ -64,65 +135,117 @@ int geneactiv_read_header(FILE *fp, GN_Info_t *info)
 }
 
 
-int get_timestamps(long *Nps, char time[40], GN_Info_t *info, GN_Data_t *data, Window_t *winfo)
+/* convert the page time line to seconds since the epoch */
+double geneactiv_page_time(char time[40], Time_t *t)
 {
     struct tm tm0;
     double t0;
-    Time_t t;
 
     /* time */
-    t.hour = GN_DATE_HOUR(time);
-    t.min = GN_DATE_MIN(time);
-    t.sec = GN_DATE_SEC(time);
-    t.msec = GN_DATE_MSEC(time);
+    t->hour = GN_DATE_HOUR(time);
+    t->min = GN_DATE_MIN(time);
+    t->sec = GN_DATE_SEC(time);
+    t->msec = GN_DATE_MSEC(time);
 
     memset(&tm0, 0, sizeof(tm0));
     tm0.tm_year = GN_DATE_YEAR(time) - 1900;  /* need years since 1900 */
     tm0.tm_mon  = GN_DATE_MONTH(time) - 1;  /* 0 indexed */
     tm0.tm_mday = GN_DATE_DAY(time);
-    tm0.tm_hour = t.hour;
-    tm0.tm_min  = t.min;
-    tm0.tm_sec  = t.sec;
+    tm0.tm_hour = t->hour;
+    tm0.tm_min  = t->min;
+    tm0.tm_sec  = t->sec;
 
     /* convert to seconds since epoch */
     t0 = (double)timegm(&tm0);
-    t0 += (double)t.msec / 1000.0f;  /* add microseconds */
+    t0 += (double)t->msec / 1000.0f;  /* add microseconds */
 
-    /* create the full timestamp array for the block */
-    for (int j = 0; j < GN_SAMPLES; ++j)
-        data->ts[*Nps + j] = t0 + (double)j / info->fs;
-    
-    /* INDEXING */
-    long mdays = MAX_DAYS;
+    return t0;
+}
+
+/* compute the window indices for a page, from the time of the page. Returns GN_READ_E_MEMORY if
+the window index storage could not be grown */
+int geneactiv_day_indexing(Time_t *t, GN_Info_t *info, Window_t *winfo)
+{
     long gns = GN_SAMPLES;
     double block_t_delta = GN_SAMPLESf / info->fs;
+
+    if (window_reserve(winfo) != 0)
+        return GN_READ_E_MEMORY;
+
     get_day_indexing(
         &(info->fs),  /* sampling frequency */
-        &t,  /* struc containing HMS & msec time info */
+        t,  /* struc containing HMS & msec time info */
         &block_t_delta,  /* block time delta */
-        &mdays,  /* max possible days */
+        &(winfo->max_days),  /* max possible days */
         &(winfo->n),  /* number of different window definitions */
         winfo->bases,  /* starts of windows */
         winfo->periods,  /* window durations */
         &(info->max_n),  /* the number of the block currently on */
         &(info->npages),  /* number of blocks/pages */
         &gns,  /* the number of data samples per block */
-        data->day_starts,  /* storage for start indices of windows */
+        winfo->starts,  /* storage for start indices of windows */
         winfo->i_start,  /* to keep track of where we are in starts */
-        data->day_stops,  /* storage for stop indices of windows */
+        winfo->stops,  /* storage for stop indices of windows */
         winfo->i_stop  /* to keep track of where we are in stops */
     );
     // fs, dtime, p, n, bases, periods, block_n, max_n, block_samples, starts, i_starts, stops, i_stops
     // int idx_err = get_day_indexing(Nps, &hour, &min, &sec, &msec, winfo, info, data);
-
     return GN_READ_E_NONE;
 }
 
+int get_timestamps(long *Nps, char time[40], GN_Info_t *info, GN_Data_t *data, Window_t *winfo)
+{
+    double t0;
+    Time_t t;
+
+    t0 = geneactiv_page_time(time, &t);
+
+    /* create the full timestamp array for the block */
+    for (int j = 0; j < GN_SAMPLES; ++j)
+        data->ts[*Nps + j] = t0 + (double)j / info->fs;
+    
+    /* INDEXING */
+    return geneactiv_day_indexing(&t, info, winfo);
+}
+
+
+/* decode the 3600 hex characters of page data into the sample storage */
+static void geneactiv_decode_data(const char *data_str, long Nps, GN_Info_t *info, GN_Data_t *data)
+{
+    uint8_t nib[3600], *v;
+    long t_;
+    double light_scale;
+
+    /* decode the hex digits, then put the block data into the appropiate location. Each sample
+    is 12 hex digits, 3 each for accel x, y, z, and light */
+    hex_to_nibbles(data_str, nib, 3600);
+    light_scale = info->lux / info->volts;
+
+    int j = 0, jj = 0;
+    for (int i = 0; i < 3600; i += 12)
+    {
+        v = &nib[i];
+        for (int k = 0; k < 3; ++k)  /* first 3 values are accel x, y, z */
+        {
+            t_ = GN_HEX12(v + k * 3);
+            t_ = (t_ > 2047) ? -4096 + t_ : t_;
+            if (data->dtype == READ_OUT_INT16)
+                ((int16_t *)data->acc)[Nps * 3 + j] = (int16_t)t_;
+            else
+                set_value(data->acc, data->dtype, Nps * 3 + j, ((double)t_ * 100.0f - info->offset[k]) / info->gain[k]);
+            ++j;
+        }
+        t_ = GN_HEX12(v + 9);  /* last value is light */
+        set_value(data->light, data->dtype, Nps + jj, floor((double)(t_ >> 2) * light_scale));
+        ++jj;
+    }
+}
+
 
 int geneactiv_read_block(FILE *fp, Window_t *w_info, GN_Info_t *info, GN_Data_t *data)
 {
-    char buff[255], data_str[3610], p[4], time[40];
-    long N = 0, Nps = 0, t_ = 0;
+    char buff[255], data_str[3610], time[40];
+    long N = 0, Nps = 0;
     double fs, temp;
     int ier = GN_READ_E_NONE;
 
@@ -143,7 +266,7 @@ int geneactiv_read_block(FILE *fp, Window_t *w_info, GN_Info_t *info, GN_Data_t
     GN_READLINE; GN_READLINE;
     temp = strtod(&buff[12], NULL);
     for (int i = Nps; i < (Nps + GN_SAMPLES); ++i)
-        data->temp[i] = temp;
+        set_value(data->temp, data->dtype, i, temp);
     
     /* skip 2 more lines then read the sampling rate */
     GN_READLINE; GN_READLINE; GN_READLINE;
@@ -164,25 +287,228 @@ int geneactiv_read_block(FILE *fp, Window_t *w_info, GN_Info_t *info, GN_Data_t
     if (strlen(data_str) < 3601)
         return GN_READ_E_BLOCK_DATA_3600;
 
-    /* put the block data into the appropiate location */
-    int j = 0, jj = 0;
-    for (int i = 0; i < 3600; i += 12)
+    geneactiv_decode_data(data_str, Nps, info, data);
+
+    if (get_timestamps(&Nps, time, info, data, w_info) != GN_READ_E_NONE)
+        return GN_READ_E_MEMORY;
+    if (data->filled && (N >= 0) && (N < info->npages))
+        data->filled[N] = 1;
+
+    return ier;
+}
+
+
+/* next line of a page in memory, and its length including the newline. NULL at the end */
+static char *page_line(char **pos, char *end, size_t *len)
+{
+    char *line = *pos, *nl;
+
+    if (line >= end)
+        return NULL;
+
+    nl = memchr(line, '\n', end - line);
+    *pos = nl ? nl + 1 : end;
+    *len = *pos - line;
+    return line;
+}
+
+/**
+ * Parse a page of a memory mapped GeneActiv file. The data, temperature, and timestamps are put
+ * into their location in the output from the page sequence number, so pages can be parsed
+ * in any order. Checking the sampling frequency and computing window indices depend on the
+ * previous pages, and are left for `geneactiv_finish_page`.
+ *
+ * @param page Start of the page, the "Recorded Data" line
+ * @param end  End of the page (start of the next page, or the end of the file)
+ * @param info File information
+ * @param data Output storage
+ * @param pg   Storage for the page information
+ *
+ * @result Read_Bin_Error_t error value
+ */
+int geneactiv_parse_page(char *page, char *end, GN_Info_t *info, GN_Data_t *data, GN_Page_t *pg)
+{
+    char time[40], *pos = page, *line = NULL;
+    size_t len = 0;
+    long Nps;
+    double temp;
+
+    /* skip the "Recorded Data" line and the next line, 3d line is the sequence number */
+    for (int i = 0; i < 3; ++i)
+        line = page_line(&pos, end, &len);
+    if (!line)
+        return GN_READ_E_BLOCK_TIMESTAMP;
+    pg->seq = strtol(&line[16], NULL, 10);
+    if ((pg->seq < 0) || (pg->seq >= info->npages))
+        return GN_READ_E_BLOCK_SEQUENCE;
+    Nps = pg->seq * GN_SAMPLES;
+
+    /* the line containing the timestamp */
+    if (!(line = page_line(&pos, end, &len)))
+        return GN_READ_E_BLOCK_TIMESTAMP;
+    len = len < 39 ? len : 39;
+    memcpy(time, line, len);
+    time[len] = '\0';
+    pg->t0 = geneactiv_page_time(time, &(pg->t));
+
+    /* skip a line then read the line with the temperature */
+    page_line(&pos, end, &len);
+    if (!(line = page_line(&pos, end, &len)))
+        return GN_READ_E_BLOCK_DATA;
+    temp = strtod(&line[12], NULL);
+
+    /* skip 2 more lines then read the sampling rate */
+    page_line(&pos, end, &len);
+    page_line(&pos, end, &len);
+    if (!(line = page_line(&pos, end, &len)))
+        return GN_READ_E_BLOCK_DATA;
+    pg->fs = strtod(&line[22], NULL);
+
+    /* the 3600 character data string */
+    if (!(line = page_line(&pos, end, &len)))
+        return GN_READ_E_BLOCK_DATA;
+    if (len < 3601)
+        return GN_READ_E_BLOCK_DATA_3600;
+
+    for (long i = Nps; i < (Nps + GN_SAMPLES); ++i)
+        set_value(data->temp, data->dtype, i, temp);
+
+    geneactiv_decode_data(line, Nps, info, data);
+
+    /* the sampling frequency is only used if it matches the file's (or is the first that
+    doesn't), so the page's own can be used for the timestamps */
+    for (int j = 0; j < GN_SAMPLES; ++j)
+        data->ts[Nps + j] = pg->t0 + (double)j / pg->fs;
+    if (data->filled)
+        data->filled[pg->seq] = 1;
+
+    return GN_READ_E_NONE;
+}
+
+/**
+ * Clear the storage of the pages that were not read, ie missing pages, and the pages after the
+ * end of the recorded data. The storage then does not need to be cleared before reading.
+ *
+ * @param info File information
+ * @param data Output storage, with the pages that were read marked in `filled`
+ */
+void geneactiv_clear_unread(GN_Info_t *info, GN_Data_t *data)
+{
+    size_t asize = data->dtype == READ_OUT_FLOAT64 ? sizeof(double)
+        : (data->dtype == READ_OUT_FLOAT32 ? sizeof(float) : sizeof(int16_t));
+    size_t osize = data->dtype == READ_OUT_FLOAT64 ? sizeof(double) : sizeof(float);
+    size_t i0;
+
+    if (!data->filled)
+        return;
+
+    for (long p = 0; p < info->npages; ++p)
     {
-        for (int k = 0; k < 3; ++k)  /* first 3 values are accel x, y, z */
-        {
-            memcpy(p, &data_str[i + k * 3], 3);
-            t_ = strtol(p, NULL, 16);
-            t_ = (t_ > 2047) ? -4096 + t_ : t_;
-            data->acc[Nps * 3 + j] = ((double)t_ * 100.0f - info->offset[k]) / info->gain[k];
-            ++j;
-        }
-        memcpy(p, &data_str[i + 9], 3);  /* last value is light */
-        t_ = strtol(p, NULL, 16);
-        data->light[Nps + jj] = floor((double)(t_ >> 2) * (info->lux / info->volts));
-        ++jj;
+        if (data->filled[p])
+            continue;
+        i0 = (size_t)p * GN_SAMPLES;
+
+        memset((char *)data->acc + 3 * i0 * asize, 0, 3 * GN_SAMPLES * asize);
+        memset((char *)data->light + i0 * osize, 0, GN_SAMPLES * osize);
+        memset((char *)data->temp + i0 * osize, 0, GN_SAMPLES * osize);
+        memset(data->ts + i0, 0, GN_SAMPLES * sizeof(double));
     }
+}
+
+/**
+ * Finish a page parsed by `geneactiv_parse_page`, the same as `geneactiv_read_block` does after
+ * reading the page. Must be called for each page in the file order.
+ *
+ * @param pg    Page information
+ * @param info  File information
+ * @param winfo Windowing information
+ *
+ * @result Read_Bin_Error_t error value
+ */
+int geneactiv_finish_page(GN_Page_t *pg, GN_Info_t *info, Window_t *winfo)
+{
+    int ier = GN_READ_E_NONE;
 
-    get_timestamps(&Nps, time, info, data, w_info);
+    info->max_n = (pg->seq > info->max_n) ? pg->seq : info->max_n;  /* max N found so far */
+
+    if ((pg->fs != info->fs) && (info->fs_err < 1)){
+        info->fs_err ++;  /* increment the error counter, this error should only happen once */
+        /* set the sampling frequency to that of the block */
+        info->fs = pg->fs;
+
+        ier = GN_READ_E_BLOCK_FS_WARN;  /* set so that the warning message can be printed after function */
+    } else if ((pg->fs != info->fs) && (info->fs_err >= 1))
+        return GN_READ_E_BLOCK_FS;
+
+    if (geneactiv_day_indexing(&(pg->t), info, winfo) != GN_READ_E_NONE)
+        return GN_READ_E_MEMORY;
 
     return ier;
 }
+
+
+/**
+ * Record a page in an index, as it is read.
+ *
+ * @param index  Index storage
+ * @param i      Page number in the file
+ * @param seq    Sequence number of the page
+ * @param t      Time of day of the first sample of the page
+ * @param t0     Time of the first sample of the page
+ * @param fs     Sampling frequency used for the page
+ * @param status Status of the page, 0 if good
+ */
+void geneactiv_index_page(Index_t *index, long i, long seq, Time_t *t, double t0, double fs,
+    int status)
+{
+    index->seq[i] = seq;
+    index->time[i] = t0;
+    index->count[i] = GN_SAMPLES;
+    index->status[i] = (char)status;
+    index->t_last[i] = 0.0;
+    index->day.sec[i] = t->hour * SECHOUR + t->min * SECMIN + t->sec;
+    index->day.msec[i] = t->msec;
+    index->day.duration[i] = GN_SAMPLESf / fs;
+}
+
+/**
+ * Scan the pages of a GeneActiv file without parsing the data. Call after `geneactiv_read_header`.
+ *
+ * @param fp    Open file, positioned after the header
+ * @param info  File information
+ * @param index Storage for the index records of each page. Size of `info->npages`. Pages with
+ *              data that is too short have a status of 1
+ *
+ * @result Number of pages found
+ */
+long geneactiv_read_index(FILE *fp, GN_Info_t *info, Index_t *index)
+{
+    char buff[255], data_str[3610], time_str[40];
+    Time_t t;
+    double t0;
+    long i, seq;
+
+    for (i = 0; i < info->npages; ++i)
+    {
+        /* "Recorded Data" line */
+        if (GN_READLINE == NULL)
+            break;
+        GN_READLINE;
+        GN_READLINE;  /* 3d line is sequence number */
+        seq = strtol(&buff[16], NULL, 10);
+
+        if (fgets(time_str, 40, fp) == NULL)
+            break;
+        t0 = geneactiv_page_time(time_str, &t);
+
+        /* skip to the data */
+        for (int j = 0; j < 5; ++j)
+            GN_READLINE;
+
+        if (fgets(data_str, 3610, fp) == NULL)
+            break;
+        geneactiv_index_page(index, i, seq, &t, t0, info->fs, strlen(data_str) < 3601);
+    }
+
+    return i;
+}
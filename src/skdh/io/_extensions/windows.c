@@ -0,0 +1,119 @@
+// Copyright (c) 2021. Pfizer Inc. All rights reserved.
+#include "read_binary_imu.h"
+
+
+/**
+ * Initialize the windowing information, and allocate the window index storage. The storage is
+ * grown as needed while reading with `window_reserve`, so does not limit the recording length.
+ *
+ * @param winfo    Windowing information to initialize
+ * @param n        Number of windows (bases/periods)
+ * @param bases    Base hours of the windows
+ * @param periods  Lengths of the windows in hours
+ * @param max_days Initial number of window indices to allocate storage for
+ *
+ * @result 0 if successful, -1 if the storage could not be allocated
+ */
+int window_init(Window_t *winfo, long n, long *bases, long *periods, long max_days)
+{
+    winfo->n = n;
+    winfo->bases = bases;
+    winfo->periods = periods;
+    winfo->max_days = max_days > 0 ? max_days : WINDOW_INIT_DAYS;
+
+    /* calloc(0) can return NULL, always allocate something */
+    winfo->i_start = (long *)calloc(2 * n + 1, sizeof(long));
+    winfo->i_stop = winfo->i_start ? winfo->i_start + n : NULL;
+    winfo->starts = (long *)calloc(winfo->max_days * n + 1, sizeof(long));
+    winfo->stops = (long *)calloc(winfo->max_days * n + 1, sizeof(long));
+
+    if (!winfo->i_start || !winfo->starts || !winfo->stops)
+    {
+        window_free(winfo);
+        return -1;
+    }
+    return 0;
+}
+
+/* grow a (max_days, n) index array to (new_days, n), zeroing the new rows */
+static long *window_grow(long *arr, long n, long max_days, long new_days)
+{
+    long *tmp = (long *)realloc(arr, (new_days * n + 1) * sizeof(long));
+
+    if (tmp)
+        memset(tmp + max_days * n, 0, (new_days - max_days) * n * sizeof(long));
+    return tmp;
+}
+
+/**
+ * Make sure there is storage for the window indices of one more block. A block sets at most one
+ * start and one stop index per window, at the current positions `i_start` and `i_stop`.
+ *
+ * @param winfo Windowing information
+ *
+ * @result 0 if successful, -1 if the storage could not be grown. The existing storage is still
+ *         valid on failure.
+ */
+int window_reserve(Window_t *winfo)
+{
+    long need = 0, new_days;
+    long *tmp;
+
+    for (long i = 0; i < winfo->n; ++i)
+    {
+        need = winfo->i_start[i] >= need ? winfo->i_start[i] + 1 : need;
+        need = winfo->i_stop[i] >= need ? winfo->i_stop[i] + 1 : need;
+    }
+    if (need <= winfo->max_days)
+        return 0;
+
+    new_days = 2 * winfo->max_days > need ? 2 * winfo->max_days : need;
+
+    if (!(tmp = window_grow(winfo->starts, winfo->n, winfo->max_days, new_days)))
+        return -1;
+    winfo->starts = tmp;
+    if (!(tmp = window_grow(winfo->stops, winfo->n, winfo->max_days, new_days)))
+        return -1;
+    winfo->stops = tmp;
+
+    winfo->max_days = new_days;
+    return 0;
+}
+
+/**
+ * Number of rows of the window index storage that are in use.
+ *
+ * @param winfo Windowing information
+ *
+ * @result Number of rows. Stops can be set for the end of the recording without moving on to the
+ *         next row, so this can be one more than `i_stop`.
+ */
+long window_rows(Window_t *winfo)
+{
+    long rows = 0;
+
+    for (long i = 0; i < winfo->n; ++i)
+    {
+        rows = winfo->i_start[i] > rows ? winfo->i_start[i] : rows;
+        rows = winfo->i_stop[i] + 1 > rows ? winfo->i_stop[i] + 1 : rows;
+    }
+    return rows < winfo->max_days ? rows : winfo->max_days;
+}
+
+/**
+ * Free the window index storage.
+ *
+ * @param winfo Windowing information
+ */
+void window_free(Window_t *winfo)
+{
+    free(winfo->i_start);
+    free(winfo->starts);
+    free(winfo->stops);
+
+    winfo->i_start = NULL;
+    winfo->i_stop = NULL;
+    winfo->starts = NULL;
+    winfo->stops = NULL;
+    winfo->max_days = 0;
+}
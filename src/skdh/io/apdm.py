@@ -4,7 +4,10 @@ GeneActiv reading process
 Lukas Adamowicz
 Copyright (c) 2021. Pfizer Inc. All rights reserved.
 """
+from math import ceil
+
 import h5py
+from numpy import mean, diff
 
 from skdh.base import BaseProcess
 from skdh.io.base import check_input_file
@@ -31,6 +34,13 @@ class ReadApdmH5(BaseProcess):
         What to do if the file extension does not match the expected extension (.h5).
         Default is "warn". "raise" raises a ValueError. "skip" skips the file
         reading altogether and attempts to continue with the pipeline.
+    start_time : float, optional
+        Only read data from this time onwards, in seconds since the epoch. Only the
+        requested samples are read from the file. Default is None, which reads from
+        the start of the recording.
+    stop_time : float, optional
+        Only read data before this time, in seconds since the epoch. Default is None,
+        which reads to the end of the recording.
 
     Notes
     -----
@@ -44,14 +54,32 @@ class ReadApdmH5(BaseProcess):
     - Left/Right Upper Leg
     - Lumbar
     - Sternum
+
+    Examples
+    --------
+    Read the lumbar sensor data 10 minutes at a time, so that only one chunk of the
+    data is in memory at once:
+
+    >>> reader = ReadApdmH5("Lumbar")
+    >>> for chunk in reader.iter_chunks("example.h5", n_seconds=600):
+    ...     accel = chunk["accel"]  # the data of about 10 minutes
     """
 
-    def __init__(self, sensor_location, gravity_acceleration=9.81, ext_error="warn"):
+    def __init__(
+        self,
+        sensor_location,
+        gravity_acceleration=9.81,
+        ext_error="warn",
+        start_time=None,
+        stop_time=None,
+    ):
         super().__init__(
             # kwargs
             sensor_location=sensor_location,
             gravity_acceleration=gravity_acceleration,
             ext_error=ext_error,
+            start_time=start_time,
+            stop_time=stop_time,
         )
 
         if ext_error.lower() in ["warn", "raise", "skip"]:
@@ -62,6 +90,81 @@ class ReadApdmH5(BaseProcess):
         self.sens = sensor_location
         self.g = gravity_acceleration
 
+        if (
+            (start_time is not None)
+            and (stop_time is not None)
+            and (stop_time <= start_time)
+        ):
+            raise ValueError("`stop_time` must be after `start_time`.")
+        self.start_time = start_time
+        self.stop_time = stop_time
+
+    def _get_sensor(self, f):
+        """
+        Get the group of the sensor with the requested location.
+        """
+        sid = None  # sensor id
+        for sens in f["Sensors"]:
+            try:
+                sname = f["Sensors"][sens]["Configuration"].attrs["Label 0"]
+            except (RuntimeError, KeyError):
+                # if the sensor has issues, still try to find in other sensors
+                continue
+            if sname.decode("utf-8") == self.sens:
+                sid = sens
+        if sid is None:
+            raise SensorNotFoundError(f"Sensor {self.sens} was not found.")
+
+        return f["Sensors"][sid]
+
+    @staticmethod
+    def _search_time(time, t):
+        """
+        First index of the (sorted) time dataset that is not before `t`. Only the
+        samples needed by the bisection are read.
+        """
+        lo, hi = 0, time.shape[0]
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if time[mid] < t:
+                lo = mid + 1
+            else:
+                hi = mid
+        return lo
+
+    def _sample_range(self, sensor):
+        """
+        Get the [start, stop) sample indices covering `start_time` and `stop_time`.
+        """
+        time = sensor["Time"]  # microseconds
+
+        i1 = 0
+        i2 = time.shape[0]
+        if self.start_time is not None:
+            i1 = self._search_time(time, self.start_time * 1e6)
+        if self.stop_time is not None:
+            i2 = self._search_time(time, self.stop_time * 1e6)
+
+        return i1, max(i1, i2)
+
+    def _read_span(self, sensor, i1, i2):
+        """
+        Read the samples [i1, i2) of the sensor data.
+        """
+        return {
+            self._acc: sensor["Accelerometer"][i1:i2] / self.g,
+            self._time: sensor["Time"][i1:i2] / 1e6,  # to seconds
+            self._gyro: sensor["Gyroscope"][i1:i2],
+            self._temp: sensor["Temperature"][i1:i2],
+        }
+
+    @check_input_file(".h5", check_size=False)
+    def _check_file(self, file=None, **kwargs):
+        """
+        Check the input file the same as `predict`, returning the file name.
+        """
+        return file
+
     @check_input_file(".h5", check_size=False)
     def predict(self, file=None, **kwargs):
         """
@@ -79,7 +182,8 @@ class ReadApdmH5(BaseProcess):
         Returns
         -------
         data : dict
-            Dictionary of the data contained in the file.
+            Dictionary of the data contained in the file. If `start_time` or
+            `stop_time` are set, only the data in that time range.
 
         Raises
         ------
@@ -92,27 +196,98 @@ class ReadApdmH5(BaseProcess):
         """
         super().predict(expect_days=False, expect_wear=False, file=file, **kwargs)
 
-        res = {}
         # read the file
         with h5py.File(file, "r") as f:
-            sid = None  # sensor id
-            for sens in f["Sensors"]:
-                try:
-                    sname = f["Sensors"][sens]["Configuration"].attrs["Label 0"]
-                except (RuntimeError, KeyError):
-                    # if the sensor has issues, still try to find in other sensors
-                    continue
-                if sname.decode("utf-8") == self.sens:
-                    sid = sens
-            if sid is None:
-                raise SensorNotFoundError(f"Sensor {self.sens} was not found.")
-
-            res[self._acc] = f["Sensors"][sid]["Accelerometer"][()] / self.g
-            res[self._time] = f["Sensors"][sid]["Time"][()] / 1e6  # to seconds
-            res[self._gyro] = f["Sensors"][sid]["Gyroscope"][()]
-            res[self._temp] = f["Sensors"][sid]["Temperature"][()]
+            sensor = self._get_sensor(f)
+            res = self._read_span(sensor, *self._sample_range(sensor))
 
         res["file"] = file
         kwargs.update(res)
 
         return (kwargs, None) if self._in_pipeline else kwargs
+
+    def iter_chunks(self, file, n_seconds=None, n_samples=None):
+        """
+        iter_chunks(file, n_seconds=None, n_samples=None)
+
+        Read the data from the specified sensor in chunks of a fixed duration. Only
+        the data for one chunk is in memory at a time.
+
+        Parameters
+        ----------
+        file : {str, pathlib.Path}
+            Path to the file to read. Must either be a string, or be able to be
+            converted by `str(file)`.
+        n_seconds : float, optional
+            Approximate duration of each chunk, in seconds. Either this or
+            `n_samples` must be provided.
+        n_samples : int, optional
+            Approximate number of samples per chunk.
+
+        Yields
+        ------
+        data : dict
+            Dictionary of the data contained in the chunk. Keys are the same as
+            returned by `predict`, with the addition of `fs`, and `index`, the index
+            of the first sample of the chunk in the data returned by `predict`.
+
+        Raises
+        ------
+        ValueError
+            If neither or both of `n_seconds` and `n_samples` are provided, or the
+            file name is not provided.
+        FileNotFoundError
+            If the file does not exist.
+        skdh.io.SensorNotFoundError
+            If the specified sensor name was not found.
+
+        Notes
+        -----
+        Chunks are rounded up to a whole number of the HDF5 storage chunks of the
+        datasets, and after the first chunk start on a storage chunk boundary, so
+        that each storage chunk is only read and decompressed once.
+
+        The file is checked the same as in `predict`, when `iter_chunks` is called.
+        If the file extension does not match and `ext_error` is "skip", there are no
+        chunks.
+        """
+        if (n_seconds is None) == (n_samples is None):
+            raise ValueError("One of `n_seconds` or `n_samples` must be provided.")
+
+        file = self._check_file(file=file)
+        # a skipped file returns the pipeline data instead of the file name
+        if not isinstance(file, str):
+            return iter(())
+        return self._iter_chunks(file, n_seconds, n_samples)
+
+    def _iter_chunks(self, file, n_seconds, n_samples):
+        """
+        Generator for `iter_chunks`, after the input checks.
+        """
+        with h5py.File(file, "r") as f:
+            sensor = self._get_sensor(f)
+            i1, i2 = self._sample_range(sensor)
+
+            # sampling frequency from the start of the data
+            t = sensor["Time"][i1:min(i1 + 1000, i2)]
+            fs = 1e6 / mean(diff(t)) if t.size > 1 else 0.0
+
+            if n_seconds is not None:
+                n_samples = ceil(n_seconds * fs) if fs > 0 else i2 - i1
+            n_samples = max(int(n_samples), 1)
+
+            # align with the storage chunks
+            storage = sensor["Accelerometer"].chunks
+            if storage is not None:
+                n_samples = ceil(n_samples / storage[0]) * storage[0]
+
+            start = i1
+            while start < i2:
+                stop = min((start // n_samples + 1) * n_samples, i2)
+
+                results = self._read_span(sensor, start, stop)
+                results.update({"file": file, "fs": fs, "index": start - i1})
+
+                yield results
+
+                start = stop
@@ -4,13 +4,35 @@ Axivity reading functions
 Lukas Adamowicz
 Copyright (c) 2021. Pfizer Inc. All rights reserved.
 """
-from warnings import warn
+from math import ceil
+from pathlib import Path
 
-from numpy import vstack, asarray, ascontiguousarray, minimum, int_
+from numpy import (
+    vstack,
+    asarray,
+    ascontiguousarray,
+    minimum,
+    int_,
+    int64,
+    zeros,
+    array,
+    clip,
+    searchsorted,
+    insert,
+    append,
+    inf,
+)
 
 from skdh.base import BaseProcess
-from skdh.io.base import check_input_file
-from skdh.io._extensions import read_axivity
+from skdh.utility.time_anchors import TimeAnchors
+from skdh.io.base import check_input_file, handle_bases_periods
+from skdh.io.block_index import BlockIndex
+from skdh.io.utility import ReadBuffers, trim_scale_runs
+from skdh.io._extensions import (
+    read_axivity,
+    read_axivity_chunk,
+    find_axivity_blocks,
+)
 
 
 class UnexpectedAxesError(Exception):
@@ -38,6 +60,60 @@ class ReadCwa(BaseProcess):
         What to do if the file extension does not match the expected extension (.cwa).
         Default is "warn". "raise" raises a ValueError. "skip" skips the file
         reading altogether and attempts to continue with the pipeline.
+    use_mmap : bool, optional
+        Memory map the file and decode data blocks directly from the mapping, instead
+        of reading each block from the file separately. Default is True, so files
+        are memory mapped unless this is set to False, which reads the blocks
+        with file reads as before, eg for file systems that do not support
+        memory mapping well.
+    workers : int, optional
+        Number of threads to decode the data blocks with. If more than 1, the file
+        is always memory mapped. Default is 1.
+    dtype : {"float64", "float32", "int16"}, optional
+        Data type of the returned sensor data. Types other than "float64" always
+        memory map the file. "float32" halves the memory used.
+        "int16" returns the raw sensor counts, along with a scale and offset for
+        each sensor (eg `accel_scale`, `accel_offset`) such that
+        `value = (counts - offset) / scale`. The scale is read from each data block,
+        and given for each run of samples with the same scale, see
+        :func:`skdh.io.counts_to_values`. Default is "float64".
+    time_ns : bool, optional
+        Return timestamps as int64 nanoseconds since the epoch, instead of float64
+        seconds. Default is False.
+    index : bool, optional
+        Use the block index saved next to the file (`<file>.skdhidx.npz`), which
+        gives the windows, the blocks of a time range, and the time each decoding
+        thread starts from, without computing them from the file. If there is not a
+        current index, it is recorded while decoding the whole file (not a time
+        range) and saved. The index
+        can also be loaded with :func:`skdh.io.get_block_index` to compute windows
+        for other `bases` and `periods` without reading the file again. Default is
+        False.
+    start_time : float, optional
+        Only read data from this time onwards, in seconds since the epoch. Only the
+        data blocks that overlap the requested time range are decoded. Default is
+        None, which reads from the start of the file.
+    stop_time : float, optional
+        Only read data before this time, in seconds since the epoch. Default is None,
+        which reads to the end of the file.
+    verify_checksum : bool, optional
+        Verify the checksum of each data block, and treat blocks that fail as bad
+        blocks. Skipping verification is faster, but should only be done for files
+        that are known to be good. Default is True.
+    time_anchors : bool, optional
+        Return `time` as :class:`skdh.utility.time_anchors.TimeAnchors`, one anchor
+        per data block, instead of a full array with one timestamp per sample. The
+        anchors behave like a read-only array, and timestamps are only computed when
+        indexed, or when converted to a full array (eg `numpy.asarray(time)`).
+        Timestamps match the full array to within floating point rounding. Only
+        applies to `predict`. Default is False.
+    buffers : {None, skdh.io.ReadBuffers}, optional
+        Storage to decode the file into, re-used between files. The returned data
+        are views of the buffers, and are overwritten by the next file read with the
+        same buffers. For files with a gyroscope (or magnetometer), the sensors are
+        decoded together, so each sensor's data is a strided (not C-contiguous) view.
+        Only applies to `predict` of the full file. Default is None, which allocates
+        new arrays for each file.
 
     Examples
     --------
@@ -52,48 +128,84 @@ class ReadCwa(BaseProcess):
     >>> reader = ReadCwa(bases=8, periods=12)  # 8 + 12 = 20
     >>> reader.predict('example.cwa')
     {'accel': ..., 'time': ..., 'day_ends': [130, 13951, ...], ...}
+
+    Read only the first hour of a file:
+
+    >>> reader = ReadCwa(start_time=1572339600.0, stop_time=1572343200.0)
+    >>> reader.predict('example.cwa')
+    {'accel': ..., 'time': ..., ...}
+
+    Read a large file an hour at a time:
+
+    >>> for chunk in reader.iter_chunks('example.cwa', n_seconds=3600):
+    ...     chunk['index'], chunk['accel'].shape
+    (0, (360000, 3))
+    (360000, (360000, 3))
+    ...
     """
 
-    def __init__(self, bases=None, periods=None, ext_error="warn"):
+    def __init__(
+        self,
+        bases=None,
+        periods=None,
+        ext_error="warn",
+        use_mmap=True,
+        workers=1,
+        dtype="float64",
+        time_ns=False,
+        index=False,
+        start_time=None,
+        stop_time=None,
+        verify_checksum=True,
+        time_anchors=False,
+        buffers=None,
+    ):
         super().__init__(
             # kwargs
             bases=bases,
             periods=periods,
             ext_error=ext_error,
+            use_mmap=use_mmap,
+            workers=workers,
+            dtype=dtype,
+            time_ns=time_ns,
+            index=index,
+            start_time=start_time,
+            stop_time=stop_time,
+            verify_checksum=verify_checksum,
+            time_anchors=time_anchors,
+            buffers=buffers,
         )
 
+        self.use_mmap = use_mmap
+        self.workers = max(int(workers), 1)
+
+        if dtype not in ["float64", "float32", "int16"]:
+            raise ValueError("`dtype` must be one of 'float64', 'float32', 'int16'.")
+        self.dtype = dtype
+        self.time_ns = time_ns
+        self.index = index
+
+        if (
+            (start_time is not None)
+            and (stop_time is not None)
+            and (stop_time <= start_time)
+        ):
+            raise ValueError("`stop_time` must be after `start_time`.")
+        self.start_time = start_time
+        self.stop_time = stop_time
+        self.verify_checksum = verify_checksum
+        self.time_anchors = time_anchors
+        if (buffers is not None) and not isinstance(buffers, ReadBuffers):
+            raise ValueError("`buffers` must be a `skdh.io.ReadBuffers` instance.")
+        self.buffers = buffers
+
         if ext_error.lower() in ["warn", "raise", "skip"]:
             self.ext_error = ext_error.lower()
         else:
             raise ValueError("`ext_error` must be one of 'raise', 'warn', 'skip'.")
 
-        if (bases is None) and (periods is None):
-            self.window = False
-            self.bases = asarray([0])  # needs to be defined for passing to extensions
-            self.periods = asarray([12])
-        elif (bases is None) or (periods is None):
-            warn("One of base or period is None, not windowing", UserWarning)
-            self.window = False
-            self.bases = asarray([0])
-            self.periods = asarray([12])
-        else:
-            if isinstance(bases, int) and isinstance(periods, int):
-                bases = asarray([bases])
-                periods = asarray([periods])
-            else:
-                bases = asarray(bases, dtype=int_)
-                periods = asarray(periods, dtype=int_)
-
-            if ((0 <= bases) & (bases <= 23)).all() and (
-                (1 <= periods) & (periods <= 24)
-            ).all():
-                self.window = True
-                self.bases = bases
-                self.periods = periods
-            else:
-                raise ValueError(
-                    "Base must be in [0, 23] and period must be in [1, 23]"
-                )
+        self.window, self.bases, self.periods = handle_bases_periods(bases, periods)
 
     @check_input_file(".cwa")
     def predict(self, file=None, **kwargs):
@@ -127,47 +239,126 @@ class ReadCwa(BaseProcess):
         - `accel`: acceleration [g]
         - `gyro`: angular velocity [deg/s]
         - `magnet`: magnetic field readings [uT]
-        - `time`: timestamps [s]
+        - `time`: timestamps [s], or [ns] if `time_ns`
         - `day_ends`: window indices
+        - `accel_scale`, `accel_offset`, etc: scale and offset of the raw counts,
+          if `dtype` is "int16". The scale has one row for each run of samples with
+          the same scale (almost always only one), and `accel_scale_index`, etc,
+          is the index of the first sample of each run
+        - `bad_blocks`: runs of bad data blocks, as [start, stop) sample indices,
+          shape (N, 2). Sensor data for these samples is 0, and the timestamps are
+          interpolated from the surrounding good blocks.
+        - `block_samples`: number of samples in each data block. Timestamps are
+          linear within each block.
+        - `block_offset`: index within its data block of the first sample, only
+          non-zero when reading a time range.
+
+        If `start_time` or `stop_time` are set, the data only covers that time range,
+        and `day_ends` are indices into the returned data, with windows that are
+        open at either end of the range cut off at the ends.
         """
         super().predict(expect_days=False, expect_wear=False, file=file, **kwargs)
 
+        index = None
+        if self.index:
+            index = BlockIndex.load(file, verify=self.verify_checksum)
+
         # read the file
-        fs, n_bad_samples, imudata, ts, temperature, starts, stops = read_axivity(
-            file, self.bases, self.periods
-        )
+        ranged = (self.start_time is not None) or (self.stop_time is not None)
+        if ranged:
+            (
+                fs,
+                imudata,
+                ts,
+                temperature,
+                day_ends,
+                scale,
+                scale_index,
+                offset,
+                bad_blocks,
+                block_samples,
+                block_offset,
+            ) = self._read_range(file, index)
+        else:
+            # windows are computed from the index instead of while decoding
+            bases, periods = self._window_inputs(index)
+            # stat before reading, so that a file modified while reading is stale
+            stat = Path(file).stat() if (self.index and index is None) else None
+
+            (
+                fs,
+                n_bad_samples,
+                imudata,
+                ts,
+                temperature,
+                starts,
+                stops,
+                scale,
+                scale_index,
+                offset,
+                bad_blocks,
+                records,
+                block_samples,
+            ) = read_axivity(
+                file,
+                bases,
+                periods,
+                self.use_mmap,
+                self.workers,
+                self.dtype,
+                self.time_ns and not self.time_anchors,
+                self.verify_checksum,
+                None,
+                None,
+                None,
+                stat is not None,
+                None if index is None else index.t_last,
+                self.buffers,
+            )
+            block_offset = 0
+            day_ends = None
+            if (index is not None) and self.window:
+                day_ends = index.day_ends(self.bases, self.periods)
+            elif records is not None:
+                BlockIndex.from_records(
+                    file,
+                    stat,
+                    fs,
+                    block_samples,
+                    records,
+                    verified=self.verify_checksum,
+                ).save()
+            if self.time_anchors:
+                ts = TimeAnchors.from_time(ts, block_samples, fs, ns=self.time_ns)
 
-        # end = None if n_bad_samples == 0 else -n_bad_samples
         end = None
 
-        num_axes = imudata.shape[1]
-        gyr_axes = mag_axes = None
-        if num_axes == 3:
-            acc_axes = slice(None)
-        elif num_axes == 6:
-            gyr_axes = slice(3)
-            acc_axes = slice(3, 6)
-        elif num_axes == 9:  # pragma: no cover :: don't have data to test this
-            gyr_axes = slice(3)
-            acc_axes = slice(3, 6)
-            mag_axes = slice(6, 9)
-        else:  # pragma: no cover :: not expected to reach here only if file is corrupt
-            raise UnexpectedAxesError("Unexpected number of axes in the IMU data")
+        acc_axes, gyr_axes, mag_axes = self._get_axes(imudata.shape[1])
 
         results = {
-            self._time: ts[:end],
+            self._time: ts if self.time_anchors else ts[:end],
             "file": file,
             "fs": fs,
             self._temp: temperature[:end],
+            "bad_blocks": bad_blocks,
+            "block_samples": block_samples,
+            "block_offset": block_offset,
         }
+        # data decoded into the buffers stay as views of the buffers
+        sensor = ascontiguousarray if (self.buffers is None) or ranged else asarray
         if acc_axes is not None:
-            results[self._acc] = ascontiguousarray(imudata[:end, acc_axes])
+            results[self._acc] = sensor(imudata[:end, acc_axes])
         if gyr_axes is not None:
-            results[self._gyro] = ascontiguousarray(imudata[:end, gyr_axes])
+            results[self._gyro] = sensor(imudata[:end, gyr_axes])
         if mag_axes is not None:  # pragma: no cover :: don't have data to test this
-            results[self._mag] = ascontiguousarray(imudata[:end, mag_axes])
+            results[self._mag] = sensor(imudata[:end, mag_axes])
+        self._add_scales(
+            results, scale, scale_index, offset, acc_axes, gyr_axes, mag_axes
+        )
 
-        if self.window:
+        if self.window and (day_ends is not None):
+            results[self._days] = day_ends
+        elif self.window:
             results[self._days] = {}
             for i, data in enumerate(zip(self.bases, self.periods)):
                 strt = starts[stops[:, i] != 0, i]
@@ -180,3 +371,289 @@ class ReadCwa(BaseProcess):
         kwargs.update(results)
 
         return (kwargs, None) if self._in_pipeline else kwargs
+
+    def _window_inputs(self, index):
+        """
+        Bases and periods to pass to the extensions. There are none if the windows
+        come from the block index.
+        """
+        if index is None:
+            return self.bases, self.periods
+        return zeros(0, dtype=int_), zeros(0, dtype=int_)
+
+    def _read_range(self, file, index=None):
+        """
+        Read only the data blocks that overlap `start_time` and `stop_time`, and trim
+        the data to the time range. The blocks, and the windows, are taken from the
+        block index if there is one.
+        """
+        start = -inf if self.start_time is None else float(self.start_time)
+        stop = inf if self.stop_time is None else float(self.stop_time)
+
+        if index is not None:
+            block_start, block_stop, t_last = index.find_blocks(start, stop)
+        else:
+            block_start, block_stop, t_last = find_axivity_blocks(
+                file, start, stop, self.verify_checksum
+            )
+        # anchors are created from timestamps in seconds
+        time_ns = self.time_ns and not self.time_anchors
+
+        bases, periods = self._window_inputs(index)
+        starts = zeros((0, bases.size), dtype=int_)
+        stops = zeros((0, bases.size), dtype=int_)
+        i_window = zeros((2, bases.size), dtype=int_)
+
+        (
+            fs,
+            _,
+            block_samples,
+            _,
+            imudata,
+            ts,
+            temperature,
+            _,
+            scale,
+            scale_index,
+            offset,
+            starts,
+            stops,
+            bad_blocks,
+        ) = read_axivity_chunk(
+            file,
+            bases,
+            periods,
+            block_start,
+            block_stop,
+            t_last,
+            starts,
+            stops,
+            i_window,
+            self.dtype,
+            time_ns,
+            self.verify_checksum,
+        )
+
+        bounds = array([start, stop])
+        if time_ns:
+            # keep infinite bounds in the range of int64 nanoseconds
+            bounds = (clip(bounds, -9e9, 9e9) * 1e9).astype(int64)
+        i1, i2 = searchsorted(ts, bounds)
+        n = i2 - i1
+
+        # window indices are for the full file, and windows can be open at either end
+        first = block_start * block_samples + i1
+        day_ends = {}
+        if (index is not None) and self.window:
+            for k, win in index.day_ends(self.bases, self.periods).items():
+                win = clip(win - first, 0, max(n - 1, 0))
+                day_ends[k] = win[win[:, 1] > win[:, 0]]
+        for i, data in enumerate(zip(bases, periods)):
+            strt = starts[: i_window[0, i], i]
+            stp = stops[: i_window[1, i], i]
+
+            if (stp.size > 0) and ((strt.size == 0) or (stp[0] < strt[0])):
+                strt = insert(strt, 0, first)
+            if strt.size > stp.size:
+                stp = append(stp, first + n - 1)
+
+            win = clip(vstack((strt, stp)).T - first, 0, max(n - 1, 0))
+            day_ends[(data[0], data[1])] = win[win[:, 1] > win[:, 0]]
+
+        # bad block runs and scale runs are also relative to the trimmed data
+        bad_blocks = clip(bad_blocks - i1, 0, n)
+        bad_blocks = bad_blocks[bad_blocks[:, 1] > bad_blocks[:, 0]]
+        scale, scale_index = trim_scale_runs(scale, scale_index, i1, i2)
+
+        ts = ts[i1:i2]
+        if self.time_anchors:
+            ts = TimeAnchors.from_time(
+                ts, block_samples, fs, offset=first, ns=self.time_ns
+            )
+
+        return (
+            fs,
+            imudata[i1:i2],
+            ts,
+            temperature[i1:i2],
+            day_ends,
+            scale,
+            scale_index,
+            offset,
+            bad_blocks,
+            block_samples,
+            first % max(block_samples, 1),
+        )
+
+    def _get_axes(self, num_axes):
+        """
+        Get the slices for the sensors in the IMU data from the number of axes.
+        """
+        gyr_axes = mag_axes = None
+        if num_axes == 3:
+            acc_axes = slice(None)
+        elif num_axes == 6:
+            gyr_axes = slice(3)
+            acc_axes = slice(3, 6)
+        elif num_axes == 9:  # pragma: no cover :: don't have data to test this
+            gyr_axes = slice(3)
+            acc_axes = slice(3, 6)
+            mag_axes = slice(6, 9)
+        else:  # pragma: no cover :: not expected to reach here only if file is corrupt
+            raise UnexpectedAxesError("Unexpected number of axes in the IMU data")
+
+        return acc_axes, gyr_axes, mag_axes
+
+    def _add_scales(
+        self, results, scale, scale_index, offset, acc_axes, gyr_axes, mag_axes
+    ):
+        """
+        Add the scale and offset of each sensor to the results for integer output.
+        """
+        if self.dtype != "int16":
+            return
+
+        for key, axes in zip(
+            [self._acc, self._gyro, self._mag], [acc_axes, gyr_axes, mag_axes]
+        ):
+            if axes is not None:
+                results[f"{key}_scale"] = scale[:, axes]
+                results[f"{key}_scale_index"] = scale_index
+                results[f"{key}_offset"] = offset[axes]
+
+    def iter_chunks(self, file, n_blocks=None, n_seconds=None):
+        """
+        iter_chunks(file, n_blocks=None, n_seconds=None)
+
+        Read the data from the axivity file in chunks of a fixed number of data blocks.
+        Only the data for one chunk is in memory at a time.
+
+        Parameters
+        ----------
+        file : {str, Path}
+            Path to the file to read. Must either be a string, or be able to be converted by
+            `str(file)`
+        n_blocks : int, optional
+            Number of data blocks per chunk. Either this or `n_seconds` must be provided.
+        n_seconds : float, optional
+            Approximate duration of each chunk, in seconds. Rounded up to a whole
+            number of data blocks.
+
+        Yields
+        ------
+        data : dict
+            Dictionary of the data contained in the chunk. Keys are the same as
+            returned by `predict`, with the addition of `index`, the index of the
+            first sample of the chunk in the full recording.
+
+        Raises
+        ------
+        ValueError
+            If neither or both of `n_blocks` and `n_seconds` are provided.
+        UnexpectedAxesError
+            If the number of axes returned is not 3, 6 or 9
+
+        Notes
+        -----
+        Timestamps of each block depend on the previous block, and window indices
+        are accumulated as the file is read, so this state is carried from one chunk
+        to the next. Window indices are for the full recording, and `day_ends`
+        contains the windows that end in the chunk.
+
+        Timestamps for bad data blocks are filled in from the last good block, which
+        is also carried from one chunk to the next, and the next good block, which can
+        be after the end of the chunk. They match the full file read by `predict`. The
+        `bad_blocks` of each chunk are indices into the chunk's data, and a run of bad
+        blocks that spans chunks is reported in each of them.
+        """
+        if (n_blocks is None) == (n_seconds is None):
+            raise ValueError("One of `n_blocks` or `n_seconds` must be provided.")
+
+        file = str(file)
+
+        # state carried between chunks. Window index storage grows as needed
+        starts = zeros((0, self.bases.size), dtype=int_)
+        stops = zeros((0, self.bases.size), dtype=int_)
+        i_window = zeros((2, self.bases.size), dtype=int_)
+        t_last = -1.0
+        # end of the last good block, and its last timestamp
+        anchor = zeros(2)
+
+        # read no blocks to get the file information
+        fs, total_blocks, block_samples, *_ = read_axivity_chunk(
+            file, self.bases, self.periods, 0, 0, t_last, starts, stops, i_window
+        )
+        if n_seconds is not None:
+            n_blocks = ceil(n_seconds * fs / block_samples)
+        n_blocks = max(int(n_blocks), 1)
+
+        n_stops = zeros(self.bases.size, dtype=int_)
+        for block_start in range(0, total_blocks, n_blocks):
+            (
+                _,
+                _,
+                _,
+                _,
+                imudata,
+                ts,
+                temperature,
+                t_last,
+                scale,
+                scale_index,
+                offset,
+                starts,
+                stops,
+                bad_blocks,
+            ) = read_axivity_chunk(
+                file,
+                self.bases,
+                self.periods,
+                block_start,
+                block_start + n_blocks,
+                t_last,
+                starts,
+                stops,
+                i_window,
+                self.dtype,
+                self.time_ns,
+                self.verify_checksum,
+                anchor,
+            )
+
+            acc_axes, gyr_axes, mag_axes = self._get_axes(imudata.shape[1])
+
+            results = {
+                self._time: ts,
+                "file": file,
+                "fs": fs,
+                "index": block_start * block_samples,
+                self._temp: temperature,
+                "bad_blocks": bad_blocks,
+                "block_samples": block_samples,
+                "block_offset": 0,
+            }
+            if acc_axes is not None:
+                results[self._acc] = ascontiguousarray(imudata[:, acc_axes])
+            if gyr_axes is not None:
+                results[self._gyro] = ascontiguousarray(imudata[:, gyr_axes])
+            if mag_axes is not None:  # pragma: no cover :: don't have data to test this
+                results[self._mag] = ascontiguousarray(imudata[:, mag_axes])
+            self._add_scales(
+                results, scale, scale_index, offset, acc_axes, gyr_axes, mag_axes
+            )
+
+            if self.window:
+                results[self._days] = {}
+                for i, data in enumerate(zip(self.bases, self.periods)):
+                    # windows that have been closed since the last chunk
+                    mask = stops[:, i] != 0
+                    strt = starts[mask, i][n_stops[i]:]
+                    stp = stops[mask, i][n_stops[i]:]
+                    n_stops[i] += stp.size
+
+                    results[self._days][(data[0], data[1])] = minimum(
+                        vstack((strt, stp)).T, total_blocks * block_samples - 1
+                    )
+
+            yield results
+
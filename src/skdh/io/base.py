@@ -8,9 +8,54 @@ from pathlib import Path
 import functools
 from warnings import warn
 
+from numpy import asarray, int_
+
 from skdh.io.utility import FileSizeError
 
 
+def handle_bases_periods(bases, periods):
+    """
+    Check the window bases and periods of a reader.
+
+    Parameters
+    ----------
+    bases : {None, int, list-like}
+        Base hours [0, 23] in which to start a window of time.
+    periods : {None, int, list-like}
+        Periods for each window, in [1, 24].
+
+    Returns
+    -------
+    window : bool
+        If windowing is done. False if either `bases` or `periods` is None.
+    bases : numpy.ndarray
+        Base hours. [0] if not windowing, as the extensions still need a value.
+    periods : numpy.ndarray
+        Periods. [12] if not windowing.
+
+    Raises
+    ------
+    ValueError
+        If any of the bases or periods are out of range.
+    """
+    if (bases is None) and (periods is None):
+        return False, asarray([0]), asarray([12])
+    elif (bases is None) or (periods is None):
+        warn("One of base or period is None, not windowing", UserWarning)
+        return False, asarray([0]), asarray([12])
+
+    if isinstance(bases, int) and isinstance(periods, int):
+        bases = asarray([bases])
+        periods = asarray([periods])
+    else:
+        bases = asarray(bases, dtype=int_)
+        periods = asarray(periods, dtype=int_)
+
+    if ((0 <= bases) & (bases <= 23)).all() and ((1 <= periods) & (periods <= 24)).all():
+        return True, bases, periods
+    raise ValueError("Base must be in [0, 23] and period must be in [1, 23]")
+
+
 def check_input_file(
     extension,
     check_size=True,
@@ -21,8 +66,8 @@ def check_input_file(
 
     Parameters
     ----------
-    extension : str
-        Expected file suffix, eg '.abc'.
+    extension : {str, tuple}
+        Expected file suffix, eg '.abc', or a tuple of allowed suffixes.
     check_size : bool, optional
         Check file size is over 1kb. Default is True.
     ext_message : str, optional
@@ -31,6 +76,8 @@ def check_input_file(
         expected suffix.
     """
 
+    extensions = (extension,) if isinstance(extension, str) else tuple(extension)
+
     def decorator_check_input_file(func):
         @functools.wraps(func)
         def wrapper_check_input_file(self, file=None, **kwargs):
@@ -45,11 +92,12 @@ def check_input_file(
                 raise FileNotFoundError(f"File {file} does not exist.")
 
             # check that the file matches the expected extension
-            if pfile.suffix != extension:
+            if pfile.suffix not in extensions:
+                msg = ext_message.format(pfile.suffix, ", ".join(extensions))
                 if self.ext_error == "warn":
-                    warn(ext_message.format(pfile.suffix, extension), UserWarning)
+                    warn(msg, UserWarning)
                 elif self.ext_error == "raise":
-                    raise ValueError(ext_message.format(pfile.suffix, extension))
+                    raise ValueError(msg)
                 elif self.ext_error == "skip":
                     kwargs.update({"file": str(file)})
                     return (kwargs, None) if self._in_pipeline else kwargs
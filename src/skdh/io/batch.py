@@ -0,0 +1,214 @@
+"""
+Reading many device files at once
+
+Lukas Adamowicz
+Copyright (c) 2021. Pfizer Inc. All rights reserved.
+"""
+from collections import deque
+from concurrent.futures import ThreadPoolExecutor, wait, FIRST_COMPLETED
+from pathlib import Path
+
+from skdh.io.axivity import ReadCwa
+from skdh.io.geneactiv import ReadBin
+from skdh.io.utility import ReadBuffers
+
+
+class BatchResult:
+    """
+    Result of reading a single file in a batch.
+
+    Parameters
+    ----------
+    index : int
+        Position of the file in the list of files.
+    file : {str, Path}
+        Path to the file.
+    data : {None, dict}
+        Data read from the file, as returned by the reader's `predict`. None if
+        there was an error.
+    error : {None, Exception}
+        The error raised while reading the file, if any.
+    """
+
+    __slots__ = ("index", "file", "data", "error")
+
+    def __init__(self, index, file, data=None, error=None):
+        self.index = index
+        self.file = file
+        self.data = data
+        self.error = error
+
+    @property
+    def ok(self):
+        """
+        If the file was read without errors.
+        """
+        return self.error is None
+
+    def __repr__(self):
+        status = "ok" if self.ok else f"error={self.error!r}"
+        return f"BatchResult({self.index}, {str(self.file)!r}, {status})"
+
+
+class ReadBatch:
+    """
+    Read a batch of CWA (.cwa) and GeneActiv (.bin) files, several files at a time.
+    Files are decoded by the native readers, which release the GIL while decoding,
+    so the files are read in parallel. Results are yielded as files finish reading,
+    and an error reading one file does not stop the rest of the batch.
+
+    Parameters
+    ----------
+    max_workers : int, optional
+        Maximum number of files to read at the same time. This also limits the
+        number of read files that are held in memory waiting to be consumed.
+        Default is 4.
+    ordered : bool, optional
+        Yield results in the same order as the files. If False, results are yielded
+        in the order that the files finish reading. Default is True.
+    readers : {None, dict}, optional
+        Reader to use for each file suffix, eg `{".cwa": ReadCwa(bases=8, periods=12)}`.
+        Files with a suffix not in `readers` are reported as errors. Default is None,
+        which uses :class:`ReadCwa` for ".cwa" and :class:`ReadBin` for ".bin" files,
+        created with `reader_kwargs`.
+    reader_kwargs
+        Keyword arguments for the default readers, eg `bases`, `periods`, `dtype`.
+        Ignored if `readers` is provided.
+
+    Notes
+    -----
+    Each file is read by a new reader, created with the same parameters as the
+    reader for its suffix, so that files read at the same time do not share any
+    reader state.
+
+    If the readers use `buffers`, each file being read gets its own set of
+    :class:`skdh.io.ReadBuffers`, and the sets are re-used for later files. The data
+    of a result are views of its buffers, and are only valid until the next result
+    is requested from :meth:`iter`. Copy any data that has to outlive that.
+    :meth:`predict` keeps every result, and so cannot be used with `buffers`.
+
+    Examples
+    --------
+    >>> batch = ReadBatch(max_workers=8, ordered=False, bases=8, periods=12)
+    >>> for res in batch.iter(["a.cwa", "b.bin", "c.cwa"]):
+    ...     if res.ok:
+    ...         process(res.file, res.data)
+    ...     else:
+    ...         print(f"{res.file} failed: {res.error}")
+    """
+
+    def __init__(self, max_workers=4, ordered=True, readers=None, **reader_kwargs):
+        self.max_workers = max(int(max_workers), 1)
+        self.ordered = ordered
+
+        if readers is None:
+            readers = {
+                ".cwa": ReadCwa(**reader_kwargs),
+                ".bin": ReadBin(**reader_kwargs),
+            }
+        self.readers = {k.lower(): v for k, v in readers.items()}
+
+    @property
+    def _buffered(self):
+        return any(getattr(r, "buffers", None) is not None for r in self.readers.values())
+
+    def _new_buffers(self):
+        """
+        New set of buffers, with the same headroom as the readers' buffers.
+        """
+        bufs = [getattr(r, "buffers", None) for r in self.readers.values()]
+        return ReadBuffers(headroom=next(b for b in bufs if b is not None).headroom)
+
+    def _read(self, index, file, buffers):
+        """
+        Read a single file with a new reader, capturing any error.
+        """
+        reader = self.readers.get(Path(file).suffix.lower(), None)
+        try:
+            if reader is None:
+                raise ValueError(f"No reader for files with suffix [{Path(file).suffix}].")
+            kw = dict(reader._kw)
+            if kw.get("buffers", None) is not None:
+                kw["buffers"] = buffers
+            return BatchResult(index, file, data=type(reader)(**kw).predict(file=file))
+        except Exception as e:
+            return BatchResult(index, file, error=e)
+
+    def iter(self, files):
+        """
+        iter(files)
+
+        Read the files, yielding the result of each file as it is finished.
+
+        Parameters
+        ----------
+        files : iterable of {str, Path}
+            Paths to the files to read.
+
+        Yields
+        ------
+        result : BatchResult
+            Result of reading each file.
+        """
+        files = iter(enumerate(files))
+        pending = deque()
+        # buffers of each pending read, and the buffers free to use for the next read
+        held = {}
+        free = []
+
+        with ThreadPoolExecutor(max_workers=self.max_workers) as pool:
+            # only keep `max_workers` files in flight, so that finished files do not
+            # pile up in memory if they are consumed slower than they are read
+            for index, file in files:
+                bufs = (free.pop() if free else self._new_buffers()) if self._buffered else None
+                fut = pool.submit(self._read, index, file, bufs)
+                pending.append(fut)
+                held[fut] = bufs
+                if len(pending) < self.max_workers:
+                    continue
+
+                yield from self._pop(pending, held, free)
+
+            while pending:
+                yield from self._pop(pending, held, free)
+
+    def _pop(self, pending, held, free):
+        """
+        Wait for, and remove, the next finished file(s) from the pending reads. The
+        buffers of a file are freed once the consumer asks for the next result.
+        """
+        if self.ordered:
+            done = [pending.popleft()]
+        else:
+            done, _ = wait(pending, return_when=FIRST_COMPLETED)
+            for fut in done:
+                pending.remove(fut)
+
+        for fut in done:
+            yield fut.result()
+            bufs = held.pop(fut)
+            if bufs is not None:
+                free.append(bufs)
+
+    def predict(self, files):
+        """
+        predict(files)
+
+        Read all the files.
+
+        Parameters
+        ----------
+        files : iterable of {str, Path}
+            Paths to the files to read.
+
+        Returns
+        -------
+        results : list of BatchResult
+            Result of reading each file, in the same order as `files`.
+        """
+        if self._buffered:
+            raise ValueError(
+                "`predict` keeps the data of every file, which cannot be done with "
+                "reader `buffers`. Use `iter` instead."
+            )
+        return sorted(self.iter(files), key=lambda r: r.index)
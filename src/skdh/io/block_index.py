@@ -0,0 +1,418 @@
+"""
+Block index sidecar files for device binary files
+
+Lukas Adamowicz
+Copyright (c) 2021. Pfizer Inc. All rights reserved.
+"""
+import os
+from contextlib import suppress
+from pathlib import Path
+from tempfile import NamedTemporaryFile
+from warnings import warn
+from zipfile import BadZipFile
+
+from numpy import load, savez, asarray, maximum, minimum, vstack, nonzero, searchsorted, int_
+
+from skdh.io._extensions import (
+    read_axivity_index,
+    read_geneactiv_index,
+    index_windows,
+)
+
+
+INDEX_VERSION = 2
+INDEX_SUFFIX = ".skdhidx.npz"
+
+
+class BlockIndex:
+    """
+    Index of the data blocks of a CWA or GeneActiv binary file, holding the sequence
+    number, start time, sample count, and status of each block. The index can be
+    saved next to the data file as a sidecar, and is validated against the size and
+    modification time of the data file when loaded. The readers record the index
+    while decoding a file, and use a saved index to skip computing windows and
+    searching for the blocks of a time range.
+
+    Parameters
+    ----------
+    file : {str, Path}
+        Path to the data file.
+    fs : float
+        Sampling frequency of the data.
+    block_samples : int
+        Number of samples in each data block.
+    n_blocks : int
+        Number of data blocks in the file.
+    sequence : numpy.ndarray
+        Sequence number of each block. Data from a block starts at sample index
+        `sequence * block_samples` in a full read.
+    time : numpy.ndarray
+        Time of the first sample of each block. 0 for bad blocks.
+    count : numpy.ndarray
+        Number of samples in each block.
+    status : numpy.ndarray
+        Status of each block. 0 is good, non-zero is bad.
+    t_last : numpy.ndarray
+        End time of the last good block after each block, which the time of the next
+        block depends on. Only used for CWA files.
+    day_sec : numpy.ndarray
+        Time of day of each block, in whole seconds.
+    day_msec : numpy.ndarray
+        Milliseconds to add to `day_sec` for each block.
+    duration : numpy.ndarray
+        Time delta of each block used when finding windows.
+    file_size : int
+        Size of the data file, in bytes, when the index was built.
+    file_mtime : int
+        Modification time of the data file, in nanoseconds, when the index was built.
+    verified : bool, optional
+        If block checksums were verified when building the index, which decides which
+        blocks are bad. Default is True.
+
+    Examples
+    --------
+    >>> index = get_block_index("example.cwa")  # builds and saves the index
+    >>> index = get_block_index("example.cwa")  # loads the saved index
+    >>> index.day_ends(bases=[8], periods=[12])
+    {(8, 12): array([[...]])}
+    """
+
+    _arrays = (
+        "sequence",
+        "time",
+        "count",
+        "status",
+        "t_last",
+        "day_sec",
+        "day_msec",
+        "duration",
+    )
+
+    def __init__(
+        self,
+        file,
+        fs,
+        block_samples,
+        n_blocks,
+        sequence,
+        time,
+        count,
+        status,
+        t_last,
+        day_sec,
+        day_msec,
+        duration,
+        file_size,
+        file_mtime,
+        verified=True,
+    ):
+        self.file = Path(file)
+        self.fs = float(fs)
+        self.block_samples = int(block_samples)
+        self.n_blocks = int(n_blocks)
+        self.sequence = asarray(sequence)
+        self.time = asarray(time)
+        self.count = asarray(count)
+        self.status = asarray(status)
+        self.t_last = asarray(t_last)
+        self.day_sec = asarray(day_sec)
+        self.day_msec = asarray(day_msec)
+        self.duration = asarray(duration)
+        self.file_size = int(file_size)
+        self.file_mtime = int(file_mtime)
+        self.verified = bool(verified)
+
+    @staticmethod
+    def sidecar_path(file):
+        """
+        Path of the sidecar index file for a data file.
+        """
+        file = Path(file)
+        return file.with_name(file.name + INDEX_SUFFIX)
+
+    @property
+    def n_samples(self):
+        """
+        Number of samples in a full read of the file.
+        """
+        return self.n_blocks * self.block_samples
+
+    @property
+    def is_current(self):
+        """
+        If the data file still has the same size and modification time as when the
+        index was built.
+        """
+        try:
+            st = self.file.stat()
+        except OSError:
+            return False
+        return (st.st_size == self.file_size) and (st.st_mtime_ns == self.file_mtime)
+
+    @classmethod
+    def from_records(
+        cls, file, stat, fs, block_samples, records, n=None, verified=True
+    ):
+        """
+        Create the index from the block records of a reader.
+
+        Parameters
+        ----------
+        file : {str, Path}
+            Path to the data file.
+        stat : os.stat_result
+            Status of the data file from before it was read, so that a file modified
+            while reading makes a stale index.
+        fs : float
+            Sampling frequency of the data.
+        block_samples : int
+            Number of samples in each data block.
+        records : tuple
+            Arrays of the sequence, time, count, status, t_last, day_sec, day_msec,
+            and duration of each block, with one element for each block in the file.
+        n : int, optional
+            Number of blocks that were found, if fewer than in the file. Default is
+            None, which uses all the records.
+        verified : bool, optional
+            If block checksums were verified. Default is True.
+
+        Returns
+        -------
+        index : BlockIndex
+        """
+        n_blocks = records[0].size
+        if n is not None:
+            records = [r[:n] for r in records]
+
+        return cls(
+            file,
+            fs,
+            block_samples,
+            n_blocks,
+            *records,
+            stat.st_size,
+            stat.st_mtime_ns,
+            verified=verified,
+        )
+
+    @classmethod
+    def build(cls, file, verify=True):
+        """
+        Build the index by scanning the data file.
+
+        Parameters
+        ----------
+        file : {str, Path}
+            Path to the data file. Must be a ".cwa" or ".bin" file.
+        verify : bool, optional
+            Verify the checksum of each CWA data block, and mark blocks that fail
+            as bad. Default is True.
+
+        Returns
+        -------
+        index : BlockIndex
+        """
+        file = Path(file)
+        # stat before reading, so that a file modified during the scan is stale
+        st = file.stat()
+
+        if file.suffix == ".cwa":
+            fs, block_samples, records = read_axivity_index(str(file), verify)
+            return cls.from_records(
+                file, st, fs, block_samples, records, verified=verify
+            )
+        elif file.suffix == ".bin":
+            fs, n, records = read_geneactiv_index(str(file))
+            return cls.from_records(file, st, fs, 300, records, n=n)
+        else:
+            raise ValueError(
+                f"Cannot index files with extension {file.suffix}, expected [.cwa, .bin]"
+            )
+
+    @classmethod
+    def load(cls, file, verify=None):
+        """
+        Load the sidecar index of a data file.
+
+        Parameters
+        ----------
+        file : {str, Path}
+            Path to the data file (not the sidecar).
+        verify : {None, bool}, optional
+            Only load an index that was built with (True) or without (False) block
+            checksum verification. Default is None, which loads either.
+
+        Returns
+        -------
+        index : {BlockIndex, None}
+            The loaded index. None if there is no sidecar, it was written by a
+            different version, it is out of date with the data file, or it does not
+            match `verify`.
+        """
+        path = cls.sidecar_path(file)
+        if not path.is_file():
+            return None
+
+        try:
+            with load(path, allow_pickle=False) as data:
+                if int(data["version"]) != INDEX_VERSION:
+                    return None
+                index = cls(
+                    file,
+                    data["fs"],
+                    data["block_samples"],
+                    data["n_blocks"],
+                    *(data[k] for k in cls._arrays),
+                    data["file_size"],
+                    data["file_mtime"],
+                    verified=data["verified"],
+                )
+        except (OSError, ValueError, KeyError, BadZipFile, EOFError):
+            # a truncated or corrupt sidecar is the same as not having one
+            return None
+
+        if (verify is not None) and (index.verified != verify):
+            return None
+        return index if index.is_current else None
+
+    def save(self):
+        """
+        Save the index next to the data file. The sidecar is written to a temporary
+        file in the same directory, and then moved onto the sidecar path, so that an
+        interrupted save or a concurrent load never sees a partial sidecar. Failing
+        to write the sidecar (ie for a read-only directory) warns instead of raising.
+        """
+        path = self.sidecar_path(self.file)
+        tmp = None
+        try:
+            with NamedTemporaryFile(
+                "wb", dir=path.parent, prefix=path.name, suffix=".tmp", delete=False
+            ) as f:
+                tmp = f.name
+                savez(
+                    f,
+                    version=INDEX_VERSION,
+                    fs=self.fs,
+                    block_samples=self.block_samples,
+                    n_blocks=self.n_blocks,
+                    file_size=self.file_size,
+                    file_mtime=self.file_mtime,
+                    verified=self.verified,
+                    **{k: getattr(self, k) for k in self._arrays},
+                )
+            os.replace(tmp, path)
+        except OSError as e:
+            if tmp is not None:
+                with suppress(OSError):
+                    os.remove(tmp)
+            warn(f"Could not save block index for {self.file}: {e}", UserWarning)
+
+    def day_ends(self, bases, periods):
+        """
+        Compute window start and stop indices from the index, without reading the
+        data file. Matches the `day_ends` of a full read of the file.
+
+        Parameters
+        ----------
+        bases : {int, array-like}
+            Base hours [0, 23] in which to start windows.
+        periods : {int, array-like}
+            Lengths of the windows in hours, [1, 24].
+
+        Returns
+        -------
+        day_ends : dict
+            Dictionary of (M, 2) arrays of window start and stop indices, with
+            keys of `(base, period)`.
+        """
+        bases = asarray(bases, dtype=int_).ravel()
+        periods = asarray(periods, dtype=int_).ravel()
+
+        # GeneActiv files index windows from the highest page number so far
+        if self.file.suffix == ".bin":
+            block_n = maximum.accumulate(self.sequence)
+        else:
+            block_n = self.sequence
+
+        starts, stops = index_windows(
+            self.fs,
+            self.block_samples,
+            self.n_blocks,
+            block_n,
+            self.status,
+            self.day_sec,
+            self.day_msec,
+            self.duration,
+            bases,
+            periods,
+        )
+
+        day_ends = {}
+        for i, data in enumerate(zip(bases, periods)):
+            strt = starts[stops[:, i] != 0, i]
+            stp = stops[stops[:, i] != 0, i]
+
+            day_ends[(data[0], data[1])] = minimum(
+                vstack((strt, stp)).T, self.n_samples - 1
+            )
+
+        return day_ends
+
+    def find_blocks(self, start_time, stop_time):
+        """
+        Find the data blocks that overlap a time range, and the end time of the last
+        good block before them, without reading the data file. Good blocks are
+        assumed to be stored in time order.
+
+        Parameters
+        ----------
+        start_time : float
+            Start of the time range, in seconds since the epoch.
+        stop_time : float
+            End of the time range, in seconds since the epoch.
+
+        Returns
+        -------
+        block_start : int
+            The last good block that starts at or before `start_time`, or 0.
+        block_stop : int
+            The first good block that starts at or after `stop_time`, or the number
+            of blocks.
+        t_last : float
+            End time of the last good block before `block_start`, as when reading
+            the whole file. -1 if there is none.
+        """
+        good = nonzero(self.status == 0)[0]
+        t0 = self.time[good]
+
+        i = searchsorted(t0, start_time, side="right") - 1
+        j = searchsorted(t0, stop_time, side="left")
+        block_start = int(good[i]) if i >= 0 else 0
+        block_stop = int(good[j]) if j < good.size else self.n_blocks
+
+        t_last = float(self.t_last[block_start - 1]) if block_start > 0 else -1.0
+        return block_start, block_stop, t_last
+
+
+def get_block_index(file, write=True):
+    """
+    Get the block index for a CWA or GeneActiv file, loading it from the sidecar
+    file if it exists and is current, otherwise building it.
+
+    Parameters
+    ----------
+    file : {str, Path}
+        Path to the data file.
+    write : bool, optional
+        Save a newly built index as a sidecar next to the data file. Default is True.
+
+    Returns
+    -------
+    index : BlockIndex
+    """
+    index = BlockIndex.load(file)
+    if index is None:
+        index = BlockIndex.build(file)
+        if write:
+            index.save()
+    return index
@@ -0,0 +1,613 @@
+"""
+Columnar cache of decoded sensor data
+
+Lukas Adamowicz
+Copyright (c) 2021. Pfizer Inc. All rights reserved.
+"""
+from pathlib import Path
+import json
+import zlib
+
+from numpy import (
+    asarray,
+    ascontiguousarray,
+    atleast_2d,
+    memmap,
+    frombuffer,
+    empty,
+    concatenate,
+    searchsorted,
+    clip,
+    ceil,
+    ndarray,
+    float32,
+    float64,
+    int16,
+    int_,
+    uint8,
+    dtype as np_dtype,
+)
+
+from skdh.base import BaseProcess
+from skdh.io.base import check_input_file, handle_bases_periods
+from skdh.io.csv import handle_windows_seconds
+from skdh.io.utility import counts_to_values, trim_scale_runs
+from skdh.utility.time_anchors import TimeAnchors
+
+# File layout:
+#   header: MAGIC, footer offset (uint64), footer length (uint64), padded to ALIGN bytes
+#   time anchors: one blob per chunk, each starting on an ALIGN byte boundary
+#   column data: one blob per chunk and column. The chunks of a column follow each other,
+#       starting on an ALIGN byte boundary, so an uncompressed column is one contiguous array
+#   footer: JSON metadata, including the index of the blobs of every chunk
+MAGIC = b"SKDHCOL1"
+ALIGN = 64
+VERSION = 1
+SUFFIX = ".skdhcol"
+
+# sensor keys that are stored, if present
+_SENSORS = ["accel", "gyro", "magnet", "temperature", "light"]
+
+
+def _trim_anchors(anchors, i1, i2):
+    """
+    Anchors for the samples [i1, i2) of `anchors`, an (N, 3) array of [index, t0, fs].
+    """
+    index, t0, fs = anchors[:, 0].astype(int_), anchors[:, 1], anchors[:, 2]
+    k1 = searchsorted(index, i1, side="right") - 1
+    k2 = searchsorted(index, i2, side="left")
+
+    index, t0, fs = index[k1:k2].copy(), t0[k1:k2].copy(), fs[k1:k2]
+    # the first anchor moves to the first sample
+    t0[0] += (i1 - index[0]) / fs[0]
+    index[0] = i1
+
+    return TimeAnchors(index - i1, t0, fs, i2 - i1)
+
+
+def _search_anchors(anchors, n, t):
+    """
+    Index of the first of the `n` samples of `anchors`, an (N, 3) array of
+    [index, t0, fs], at or after time `t`. The same as `searchsorted(time, t)` on the
+    full timestamps, without computing them.
+    """
+    index, t0, fs = anchors[:, 0].astype(int_), anchors[:, 1], anchors[:, 2]
+    last = concatenate((index[1:], [n])) - 1
+    # first anchor whose last sample is at or after `t`
+    k = searchsorted(t0 + (last - index) / fs, t)
+    if k == index.size:
+        return n
+
+    j = index[k] + int(clip(ceil((t - t0[k]) * fs[k]), 0, last[k] - index[k]))
+    # make sure rounding gives the same result as comparing the timestamps
+    while (j > index[k]) and (t0[k] + (j - 1 - index[k]) / fs[k] >= t):
+        j -= 1
+    while t0[k] + (j - index[k]) / fs[k] < t:
+        j += 1
+    return j
+
+
+class WriteColumnar(BaseProcess):
+    """
+    Write decoded sensor data to a chunked columnar cache file, which can be read by
+    :class:`ReadColumnar` without decoding the device file again. The data is
+    passed through unchanged, so this can be added to a pipeline right after a
+    device reader (eg :class:`skdh.io.ReadCwa`).
+
+    Parameters
+    ----------
+    save_name : {None, str}, optional
+        File name to save to. Can be formatted with `{file}`, the name (without
+        extension) of the file that was read, eg "{file}_cache.skdhcol". Default is
+        None, which saves next to the file that was read, as `<file>.skdhcol`.
+    chunk_seconds : float, optional
+        Duration of each chunk of data, in seconds. Default is 3600.0 (1 hour).
+    dtype : {None, "float32", "int16"}, optional
+        Data type to store sensor data in. "int16" requires raw counts, eg from
+        `ReadCwa(dtype="int16")`, and stores the scale and offset as well. "float32"
+        converts raw counts to values. Default is None, which keeps raw counts as
+        "int16", and stores anything else as "float32". Temperature and light are
+        always stored as "float32".
+    compression : {None, "zlib"}, optional
+        Compress each column of each chunk. Compressed columns are decompressed
+        when read, and can not be memory mapped. Default is None.
+
+    Notes
+    -----
+    Per-axis sensor data is stored one column per axis, so reading one axis does not
+    touch the others. Timestamps are stored as time anchors for each chunk, see
+    :class:`skdh.utility.time_anchors.TimeAnchors`. A full timestamp array is
+    converted to anchors at the data blocks of the device file, given by the
+    `block_samples` and `block_offset` that the device readers return.
+
+    Window indices (`day_ends`) from the device reader are stored as well, so that
+    :class:`ReadColumnar` returns the same windows.
+    """
+
+    def __init__(
+        self,
+        save_name=None,
+        chunk_seconds=3600.0,
+        dtype=None,
+        compression=None,
+    ):
+        super().__init__(
+            save_name=save_name,
+            chunk_seconds=chunk_seconds,
+            dtype=dtype,
+            compression=compression,
+        )
+
+        if dtype not in [None, "float32", "int16"]:
+            raise ValueError("`dtype` must be one of None, 'float32', 'int16'.")
+        if compression not in [None, "zlib"]:
+            raise ValueError("`compression` must be one of None, 'zlib'.")
+        if chunk_seconds <= 0:
+            raise ValueError("`chunk_seconds` must be positive.")
+
+        self.save_name = save_name
+        self.chunk_seconds = chunk_seconds
+        self.dtype = dtype
+        self.compression = compression
+
+    def _columns(self, kwargs):
+        """
+        Get the sensor arrays to store, converted to the storage type, and their metadata.
+        """
+        arrays, meta = {}, {}
+        for key in _SENSORS:
+            if key not in kwargs:
+                continue
+            x = asarray(kwargs[key])
+            info = {"ndim": x.ndim, "ncols": 1 if x.ndim == 1 else x.shape[1]}
+
+            raw = x.dtype == int16
+            if (self.dtype == "int16") and x.ndim == 2 and not raw:
+                raise ValueError(f"`{key}` is not raw sensor counts, can not store as 'int16'.")
+
+            scale_index = kwargs.get(f"{key}_scale_index", [0])
+            if raw and (self.dtype != "float32"):
+                info["scale"] = atleast_2d(asarray(kwargs[f"{key}_scale"], dtype=float64)).tolist()
+                info["scale_index"] = asarray(scale_index, dtype=int_).tolist()
+                info["offset"] = asarray(kwargs[f"{key}_offset"], dtype=float64).tolist()
+            elif raw:
+                x = counts_to_values(
+                    x, kwargs[f"{key}_scale"], kwargs[f"{key}_offset"], scale_index
+                )
+                x = x.astype(float32)
+            else:
+                x = x.astype(float32, copy=False)
+
+            info["dtype"] = x.dtype.str
+            arrays[key] = x.reshape((-1, info["ncols"]))
+            meta[key] = info
+
+        return arrays, meta
+
+    def _day_ends(self, kwargs):
+        """
+        Window indices from the device reader, as [base, period, [[start, stop], ...]].
+        """
+        days = kwargs.get(self._days, None) or {}
+        return [
+            [int(k[0]), int(k[1]), asarray(v, dtype=int_).reshape((-1, 2)).tolist()]
+            for k, v in days.items()
+        ]
+
+    def _write_blob(self, f, x, align=True):
+        """
+        Write a column blob, at the next aligned position if `align`, returning its
+        index entry.
+        """
+        pos = f.tell()
+        pad = -pos % ALIGN if align else 0
+        f.write(b"\x00" * pad)
+        pos += pad
+
+        data = ascontiguousarray(x).tobytes()
+        raw_size = len(data)
+        if self.compression == "zlib":
+            data = zlib.compress(data, 1)
+        f.write(data)
+
+        return [pos, len(data), raw_size]
+
+    def predict(self, file=None, **kwargs):
+        """
+        predict(file=None, **kwargs)
+
+        Write the data to a columnar cache file.
+
+        Parameters
+        ----------
+        file : {str, Path}, optional
+            Path to the file that the data was read from. Required if `save_name`
+            is None, or contains `{file}`.
+        kwargs
+            Data to save. Requires `time` and `fs`, and `block_samples` if `time` is
+            a full timestamp array.
+
+        Returns
+        -------
+        data : dict
+            The input data, with the addition of `cache_file`, the file that was
+            written.
+
+        Raises
+        ------
+        ValueError
+            If `time` is a full timestamp array, and `block_samples` is not provided.
+        """
+        super().predict(expect_days=False, expect_wear=False, file=file, **kwargs)
+
+        if self.save_name is None:
+            if file is None:
+                raise ValueError("`file` must be provided if `save_name` is None.")
+            save_file = Path(file).with_name(Path(file).name + SUFFIX)
+        else:
+            save_file = Path(self.save_name.format(file=self._file_name))
+
+        fs = float(kwargs["fs"])
+        time = kwargs[self._time]
+        if isinstance(time, TimeAnchors):
+            time = time.seconds()
+        else:
+            # timestamps are only linear within the data blocks of the device file
+            if "block_samples" not in kwargs:
+                raise ValueError(
+                    f"`block_samples` is required to store a full `{self._time}` array."
+                )
+            time = asarray(time)
+            # int64 nanosecond timestamps, eg from `time_ns=True`
+            time = time / 1e9 if time.dtype.kind in "iu" else time
+            time = TimeAnchors.from_time(
+                time, kwargs["block_samples"], fs, offset=kwargs.get("block_offset", 0)
+            )
+        n = time.size
+        all_anchors = asarray([time.index, time.t0, time.fs], dtype=float64).T
+
+        arrays, meta = self._columns(kwargs)
+        for key, x in arrays.items():
+            if x.shape[0] != n:
+                raise ValueError(f"`{key}` is not the same length as `{self._time}`.")
+
+        n_chunk = max(int(round(self.chunk_seconds * fs)), 1)
+        chunks = []
+
+        with open(save_file, "wb") as f:
+            # header is written last, once the footer location is known
+            f.write(b"\x00" * ALIGN)
+
+            for i1 in range(0, n, n_chunk):
+                i2 = min(i1 + n_chunk, n)
+
+                # anchors of the chunk, relative to its first sample
+                anchors = _trim_anchors(all_anchors, i1, i2)
+                anchors = asarray([anchors.index, anchors.t0, anchors.fs], dtype=float64).T
+
+                chunks.append(
+                    {
+                        "start": i1,
+                        "n": i2 - i1,
+                        "n_anchors": anchors.shape[0],
+                        "t_start": float(time.at(i1)),
+                        "t_stop": float(time.at(i2 - 1)),
+                        "blobs": {"time": self._write_blob(f, anchors)},
+                    }
+                )
+
+            # the chunks of a column are written one after the other
+            for key, x in arrays.items():
+                for j in range(x.shape[1]):
+                    for k, c in enumerate(chunks):
+                        c["blobs"][f"{key}.{j}"] = self._write_blob(
+                            f, x[c["start"]:c["start"] + c["n"], j], align=k == 0
+                        )
+
+            footer = json.dumps(
+                {
+                    "version": VERSION,
+                    "fs": fs,
+                    "n": n,
+                    "compression": self.compression,
+                    "columns": meta,
+                    "chunks": chunks,
+                    "day_ends": self._day_ends(kwargs),
+                }
+            ).encode("utf-8")
+            footer_pos = f.tell()
+            f.write(footer)
+
+            f.seek(0)
+            f.write(MAGIC)
+            f.write(asarray([footer_pos, len(footer)], dtype="<u8").tobytes())
+
+        kwargs.update({"file": file, "cache_file": str(save_file)})
+
+        return (kwargs, None) if self._in_pipeline else kwargs
+
+
+class ReadColumnar(BaseProcess):
+    """
+    Read a columnar cache file written by :class:`WriteColumnar`. Returns the same
+    data as the device reader the cache was written from, without decoding the
+    device file.
+
+    Parameters
+    ----------
+    bases : {None, int, list-like}, optional
+        Base hours [0, 23] in which to start a window of time. Default is None,
+        which will not do any windowing. Both `base` and `period` must be defined
+        in order to window. Can use multiple, but the number of `bases` must match
+        the number of `periods`.
+    periods : {None, int, list-like}, optional
+        Periods for each window, in [1, 24]. Defines the number of hours per window.
+        Default is None, which will do no windowing. Both `period` and `base` must
+        be defined to window. Can use multiple but the number of `periods` must
+        match the number of `bases`.
+    ext_error : {"warn", "raise", "skip"}, optional
+        What to do if the file extension does not match the expected extension
+        (.skdhcol). Default is "warn". "raise" raises a ValueError. "skip" skips
+        the file reading altogether and attempts to continue with the pipeline.
+    mmap : bool, optional
+        Memory map the file, so that only the chunks that are used are read from
+        disk. Uncompressed sensor data is returned as (copy-on-write) views of the
+        mapped file instead of being copied. Default is True.
+    start_time : float, optional
+        Only read data from this time onwards, in seconds since the epoch. Only the
+        chunks that overlap the requested time range are read. Default is None,
+        which reads from the start of the file.
+    stop_time : float, optional
+        Only read data before this time, in seconds since the epoch. Default is None,
+        which reads to the end of the file.
+    time_anchors : bool, optional
+        Return `time` as :class:`skdh.utility.time_anchors.TimeAnchors` instead of a
+        full array with one timestamp per sample. Default is False.
+
+    Notes
+    -----
+    Sensor data stored as raw counts is returned as "int16" with its scale and
+    offset (eg `accel_scale`, `accel_offset`), as for `ReadCwa(dtype="int16")`.
+
+    Windows that were stored with the data are returned as the device reader
+    computed them. When reading a time range, they are cut off at the ends of the
+    range. Any other windows are computed from the timestamps.
+    """
+
+    def __init__(
+        self,
+        bases=None,
+        periods=None,
+        ext_error="warn",
+        mmap=True,
+        start_time=None,
+        stop_time=None,
+        time_anchors=False,
+    ):
+        super().__init__(
+            bases=bases,
+            periods=periods,
+            ext_error=ext_error,
+            mmap=mmap,
+            start_time=start_time,
+            stop_time=stop_time,
+            time_anchors=time_anchors,
+        )
+
+        self.mmap = mmap
+        self.time_anchors = time_anchors
+
+        if (
+            (start_time is not None)
+            and (stop_time is not None)
+            and (stop_time <= start_time)
+        ):
+            raise ValueError("`stop_time` must be after `start_time`.")
+        self.start_time = start_time
+        self.stop_time = stop_time
+
+        if ext_error.lower() in ["warn", "raise", "skip"]:
+            self.ext_error = ext_error.lower()
+        else:
+            raise ValueError("`ext_error` must be one of 'raise', 'warn', 'skip'.")
+
+        self.window, self.bases, self.periods = handle_bases_periods(bases, periods)
+
+    @staticmethod
+    def _read_meta(file):
+        """
+        Read and check the header, and read the footer metadata.
+        """
+        with open(file, "rb") as f:
+            header = f.read(ALIGN)
+            if (len(header) < ALIGN) or (header[:8] != MAGIC):
+                raise ValueError(f"{file} is not a columnar cache file.")
+            pos, size = frombuffer(header[8:24], dtype="<u8")
+            f.seek(int(pos))
+            meta = json.loads(f.read(int(size)).decode("utf-8"))
+
+        if meta["version"] > VERSION:
+            raise ValueError(f"Unsupported columnar cache version {meta['version']}.")
+        return meta
+
+    @staticmethod
+    def _blob(buf, f, entry, compression, dtype):
+        """
+        Get the array of a column blob, from the mapping `buf` or file `f`.
+        """
+        pos, size, _ = entry
+        if buf is not None:
+            data = buf[pos:pos + size]
+        else:
+            f.seek(pos)
+            data = f.read(size)
+
+        if compression == "zlib":
+            data = zlib.decompress(data)
+        return frombuffer(data, dtype=dtype)
+
+    def _column(self, buf, f, chunks, key, info, compression, n):
+        """
+        Get the (n, ncols) array of the `chunks` of a column. An uncompressed column of
+        a mapped file is a view of the mapping, if its chunks follow each other and
+        its per-axis columns are evenly spaced, as written by :class:`WriteColumnar`.
+        """
+        dtype, ncols = np_dtype(info["dtype"]), info["ncols"]
+        blobs = [[c["blobs"][f"{key}.{j}"] for c in chunks] for j in range(ncols)]
+
+        if (buf is not None) and (compression is None) and chunks:
+            pos = [b[0][0] for b in blobs]
+            stride = pos[1] - pos[0] if ncols > 1 else n * dtype.itemsize
+            contiguous = all(
+                b[k + 1][0] == b[k][0] + b[k][1] for b in blobs for k in range(len(b) - 1)
+            )
+            even = all(p2 - p1 == stride for p1, p2 in zip(pos[:-1], pos[1:]))
+            if contiguous and even and (stride % dtype.itemsize == 0):
+                return ndarray(
+                    (n, ncols),
+                    dtype=dtype,
+                    buffer=buf,
+                    offset=pos[0],
+                    strides=(dtype.itemsize, stride),
+                )
+
+        x = empty((n, ncols), dtype=dtype)
+        for j in range(ncols):
+            i = 0
+            for c, blob in zip(chunks, blobs[j]):
+                x[i:i + c["n"], j] = self._blob(buf, f, blob, compression, dtype)
+                i += c["n"]
+        return x
+
+    def _windows(self, meta, time, first, n):
+        """
+        Window indices for the `n` samples read, starting at sample `first`. Stored
+        windows are indices into all the stored data.
+        """
+        stored = {(b, p): e for b, p, e in meta.get("day_ends", [])}
+
+        day_ends, bases, periods = {}, [], []
+        for base, period in zip(self.bases, self.periods):
+            win = stored.get((int(base), int(period)), None)
+            if win is None:
+                bases.append(base)
+                periods.append(period)
+                continue
+            win = asarray(win, dtype=int_).reshape((-1, 2))
+            if (first, n) != (0, meta["n"]):
+                win = clip(win - first, 0, max(n - 1, 0))
+                win = win[win[:, 1] > win[:, 0]]
+            day_ends[(base, period)] = win
+
+        if bases:
+            day_ends.update(
+                handle_windows_seconds(asarray(time), bases, periods, n > 0)
+            )
+        # in the same order as `bases` and `periods`
+        return {k: day_ends[k] for k in zip(self.bases, self.periods) if k in day_ends}
+
+    @check_input_file(SUFFIX)
+    def predict(self, file=None, **kwargs):
+        """
+        predict(file)
+
+        Read the data from a columnar cache file.
+
+        Parameters
+        ----------
+        file : {str, Path}
+            Path to the file to read. Must either be a string, or be able to be
+            converted by `str(file)`.
+
+        Returns
+        -------
+        data : dict
+            Dictionary of the data contained in the file. Keys are the sensor data
+            that was stored (`accel`, `gyro`, `temperature`, etc), `time`, `fs`,
+            and `day_ends` if windowing.
+
+        Raises
+        ------
+        ValueError
+            If the file is not a columnar cache file.
+        """
+        super().predict(expect_days=False, expect_wear=False, file=file, **kwargs)
+
+        meta = self._read_meta(file)
+        comp = meta["compression"]
+        start = -float("inf") if self.start_time is None else float(self.start_time)
+        stop = float("inf") if self.stop_time is None else float(self.stop_time)
+
+        # only the chunks that overlap the time range, and the index of their first sample
+        chunks, first = [], None
+        i = 0
+        for c in meta["chunks"]:
+            if (c["t_stop"] >= start) and (c["t_start"] < stop):
+                first = i if first is None else first
+                chunks.append(c)
+            i += c["n"]
+        first = 0 if first is None else first
+        n = sum(c["n"] for c in chunks)
+
+        # copy-on-write, so that views of the mapping are writeable
+        buf = memmap(file, dtype=uint8, mode="c") if (self.mmap and chunks) else None
+        f = None if buf is not None else open(file, "rb")
+
+        try:
+            anchors, i = [], 0
+            for c in chunks:
+                a = self._blob(buf, f, c["blobs"]["time"], comp, float64).reshape((-1, 3))
+                # anchor indices are relative to the chunk, make them relative to the data
+                a = a.copy()
+                a[:, 0] += i
+                anchors.append(a)
+                i += c["n"]
+
+            results = {}
+            for key, info in meta["columns"].items():
+                x = self._column(buf, f, chunks, key, info, comp, n)
+                results[key] = x[:, 0] if info["ndim"] == 1 else x
+        finally:
+            if f is not None:
+                f.close()
+            del buf
+
+        anchors = concatenate(anchors) if anchors else empty((0, 3))
+        time = TimeAnchors(anchors[:, 0], anchors[:, 1], anchors[:, 2], n)
+
+        # trim to the requested time range, found from the anchors of the chunks
+        i1, i2 = 0, n
+        if n > 0:
+            i1, i2 = _search_anchors(anchors, n, start), _search_anchors(anchors, n, stop)
+        if (i1, i2) != (0, n):
+            time = _trim_anchors(anchors, i1, i2) if i2 > i1 else TimeAnchors([], [], [], 0)
+            for key in meta["columns"]:
+                results[key] = results[key][i1:i2]
+
+        # scale runs are indices into the full data
+        for key, info in meta["columns"].items():
+            if "scale" in info:
+                results[f"{key}_scale"], results[f"{key}_scale_index"] = trim_scale_runs(
+                    atleast_2d(info["scale"]),
+                    info.get("scale_index", [0]),
+                    first + i1,
+                    first + i2,
+                )
+                results[f"{key}_offset"] = asarray(info["offset"])
+
+        results.update(
+            {
+                self._time: time if self.time_anchors else asarray(time),
+                "file": file,
+                "fs": meta["fs"],
+            }
+        )
+
+        if self.window:
+            results[self._days] = self._windows(
+                meta, results[self._time], first + i1, i2 - i1
+            )
+
+        kwargs.update(results)
+
+        return (kwargs, None) if self._in_pipeline else kwargs
@@ -6,11 +6,18 @@ Copyright (c) 2023. Pfizer Inc. All rights reserved
 """
 from warnings import warn
 
-from numpy import tile, arange, mean, diff, asarray, argmin, abs, vstack, unique, all as npall, int_
+from csv import reader as csv_reader
+
+from numpy import tile, arange, mean, diff, asarray, argmin, abs, vstack, unique, all as npall, int_, searchsorted, clip
 from pandas import read_csv, to_datetime, to_timedelta, Timedelta
 
 from skdh.base import BaseProcess
-from skdh.io.base import check_input_file
+from skdh.io.base import check_input_file, handle_bases_periods
+from skdh.io._extensions import read_csv_numeric
+
+
+# seconds per unit for numeric timestamps read with the native engine
+_TIME_UNITS = {"s": 1.0, "ms": 1e-3, "us": 1e-6, "ns": 1e-9}
 
 
 def handle_timestamp_inconsistency(df, fill_gaps, accel_col_names, accel_in_g, g):
@@ -153,6 +160,69 @@ def handle_windows(time_dt, bases, periods, run_windowing):
     return days
 
 
+def handle_windows_seconds(time, bases, periods, run_windowing):
+    """
+    Handle computation of the indices for day windows, from unix timestamps. Equivalent
+    to :py:func:`handle_windows`.
+
+    Parameters
+    ----------
+    time : numpy.ndarray
+        Sorted array of unix timestamps, in seconds.
+    bases : list-like
+        List of base times at which windows start. 24hr format.
+    periods : list-like
+        List of window lengths for each `base` time.
+    run_windowing : bool
+        Compute day windows.
+
+    Returns
+    -------
+    day_windows : dict
+        Dictionary of numpy arrays containing the indices for the desired days.
+    """
+    if not run_windowing:
+        return {}
+
+    def nearest(t):
+        # index of the closest timestamp, the first one on ties like `argmin`
+        i = clip(searchsorted(time, t), 1, time.size - 1)
+        return i - ((t - time[i - 1]) <= (time[i] - t))
+
+    start_date = time[0]
+    end_date = time[-1]
+
+    days = {}
+    day_dt = 86400.0
+    day_start = start_date - start_date % day_dt
+
+    for base, period in zip(bases, periods):
+        starts, stops = [], []
+
+        period2 = (base + period) % 24
+
+        t_base = day_start + base * 3600.0 - day_dt
+        t_period = day_start + period2 * 3600.0 - day_dt
+
+        if t_period <= t_base:
+            t_period += day_dt
+        while t_period < start_date:  # make sure at least one of the indices is during recording
+            t_base += day_dt
+            t_period += day_dt
+
+        # iterate over the times
+        while t_base < end_date:
+            starts.append(nearest(t_base))
+            stops.append(nearest(t_period))
+
+            t_base += day_dt
+            t_period += day_dt
+
+        days[(base, period)] = vstack((starts, stops)).T
+
+    return days
+
+
 def handle_accel(df, accel_cols, acc_in_g, g):
     """
     Extract the acceleration columns from the dataframe.
@@ -216,6 +286,12 @@ class ReadCSV(BaseProcess):
         What to do if the file extension does not match the expected extension (.bin).
         Default is "warn". "raise" raises a ValueError. "skip" skips the file
         reading altogether and attempts to continue with the pipeline.
+    engine : {"pandas", "native"}, optional
+        Engine used to parse the file. Default is "pandas". "native" parses files with
+        a single header row and numeric timestamp and acceleration columns directly
+        into arrays, without creating a DataFrame. See Notes.
+    workers : int, optional
+        Number of threads the "native" engine parses the file with. Default is 1.
 
     Notes
     -----
@@ -225,6 +301,12 @@ class ReadCSV(BaseProcess):
     :py:class:`pandas.to_datetime`. To make sure this conversion applies correctly,
     specify whatever key-word arguments to `to_datetime_kwargs`. This includes specifying
     the unit (e.g. `s`, `ms`, `us`, `ns`, etc) if a unix timestamp integer is provided.
+
+    The "native" engine is much faster and uses less memory for large files, but only
+    handles the common layout of numeric unix timestamps and acceleration values. Only
+    the "unit" key of `to_datetime_kwargs` (default "ns", as for pandas), and the
+    "sep"/"delimiter" keys of `read_csv_kwargs` are supported. Timestamps that are only
+    down to the second are not supported, and will be detected as data gaps.
     """
     def __init__(
             self,
@@ -237,7 +319,9 @@ class ReadCSV(BaseProcess):
             read_csv_kwargs=None,
             bases=None,
             periods=None,
-            ext_error='warn'
+            ext_error='warn',
+            engine='pandas',
+            workers=1,
     ):
         if to_datetime_kwargs is None:
             to_datetime_kwargs = {}
@@ -255,6 +339,8 @@ class ReadCSV(BaseProcess):
             bases=bases,
             periods=periods,
             ext_error=ext_error,
+            engine=engine,
+            workers=workers,
         )
 
         self.time_col_name = time_col_name
@@ -264,39 +350,28 @@ class ReadCSV(BaseProcess):
         self.accel_in_g = accel_in_g
         self.g_value = g_value
         self.read_csv_kwargs = read_csv_kwargs
+        self.workers = workers
+
+        if engine.lower() not in ["pandas", "native"]:
+            raise ValueError("`engine` must be one of 'pandas', 'native'.")
+        self.engine = engine.lower()
+
+        if self.engine == "native":
+            if set(to_datetime_kwargs) - {"unit"}:
+                raise ValueError("The 'native' engine only supports the 'unit' of `to_datetime_kwargs`.")
+            if to_datetime_kwargs.get("unit", "ns") not in _TIME_UNITS:
+                raise ValueError(f"The 'native' engine timestamp unit must be one of {list(_TIME_UNITS)}.")
+            if set(read_csv_kwargs) - {"sep", "delimiter"}:
+                raise ValueError("The 'native' engine only supports the 'sep' or 'delimiter' of `read_csv_kwargs`.")
+            if len(read_csv_kwargs.get("sep", read_csv_kwargs.get("delimiter", ","))) != 1:
+                raise ValueError("The 'native' engine only supports single character delimiters.")
 
         if ext_error.lower() in ["warn", "raise", "skip"]:
             self.ext_error = ext_error.lower()
         else:
             raise ValueError("`ext_error` must be one of 'raise', 'warn', 'skip'.")
 
-        if (bases is None) and (periods is None):
-            self.window = False
-            self.bases = asarray([0])  # needs to be defined for passing to extensions
-            self.periods = asarray([12])
-        elif (bases is None) or (periods is None):
-            warn("One of base or period is None, not windowing", UserWarning)
-            self.window = False
-            self.bases = asarray([0])
-            self.periods = asarray([12])
-        else:
-            if isinstance(bases, int) and isinstance(periods, int):
-                bases = asarray([bases])
-                periods = asarray([periods])
-            else:
-                bases = asarray(bases, dtype=int_)
-                periods = asarray(periods, dtype=int_)
-
-            if ((0 <= bases) & (bases <= 23)).all() and (
-                (1 <= periods) & (periods <= 24)
-            ).all():
-                self.window = True
-                self.bases = bases
-                self.periods = periods
-            else:
-                raise ValueError(
-                    "Base must be in [0, 23] and period must be in [1, 23]"
-                )
+        self.window, self.bases, self.periods = handle_bases_periods(bases, periods)
 
     @check_input_file(".csv")
     def predict(self, file=None, **kwargs):
@@ -319,13 +394,70 @@ class ReadCSV(BaseProcess):
         Raises
         ------
         ValueError
-            If the file name is not provided.
+            If the file name is not provided, or the file has no data rows.
         """
 
         super().predict(expect_days=False, expect_wear=False, file=file, **kwargs)
 
+        if self.engine == "native":
+            time, accel, day_windows, fs = self._read_native(file)
+        else:
+            time, accel, day_windows, fs = self._read_pandas(file)
+
+        kwargs.update(
+            {
+                "file": file,
+                self._time: time,
+                self._acc: accel,
+                self._days: day_windows,
+                "fs": fs,
+            }
+        )
+
+        return (kwargs, None) if self._in_pipeline else kwargs
+
+    def _read_native(self, file):
+        """
+        Read the file with the native parser.
+        """
+        delimiter = self.read_csv_kwargs.get("sep", self.read_csv_kwargs.get("delimiter", ","))
+
+        # the header gives the column indices, and the offset of the data
+        with open(file, "rb") as f:
+            header = f.readline()
+        names = next(csv_reader([header.decode("utf-8-sig").rstrip("\r\n")], delimiter=delimiter))
+        names = [n.strip() for n in names]
+
+        try:
+            cols = tuple(names.index(c) for c in [self.time_col_name, *self.acc_col_names])
+        except ValueError:
+            raise ValueError(f"Columns {[self.time_col_name, *self.acc_col_names]} not all in the file header {names}.")
+
+        fs, time, accel = read_csv_numeric(
+            str(file),
+            len(header),
+            cols,
+            delimiter,
+            _TIME_UNITS[self.to_datetime_kw.get("unit", "ns")],
+            1.0 if self.accel_in_g else 1.0 / self.g_value,
+            self.fill_gaps,
+            self.workers,
+        )
+        if time.size == 0:
+            raise ValueError(f"No data rows in {file}, only a header.")
+
+        day_windows = handle_windows_seconds(time, self.bases, self.periods, self.window)
+
+        return time, accel, day_windows, fs
+
+    def _read_pandas(self, file):
+        """
+        Read the file with pandas.
+        """
         # load the file with pandas
         raw = read_csv(file, **self.read_csv_kwargs)
+        if raw.shape[0] == 0:
+            raise ValueError(f"No data rows in {file}, only a header.")
 
         # convert time column to a datetime column. Give a unique name so we shouldnt overwrite
         raw["_datetime_"] = to_datetime(raw[self.time_col_name], **self.to_datetime_kw)
@@ -342,14 +474,4 @@ class ReadCSV(BaseProcess):
         # get the acceleration values and convert if necessary
         accel = handle_accel(raw, self.acc_col_names, self.accel_in_g, self.g_value)
 
-        kwargs.update(
-            {
-                "file": file,
-                self._time: time,
-                self._acc: accel,
-                self._days: day_windows,
-                "fs": fs,
-            }
-        )
-
-        return (kwargs, None) if self._in_pipeline else kwargs
+        return time, accel, day_windows, fs
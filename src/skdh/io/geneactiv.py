@@ -4,14 +4,20 @@ GeneActiv reading process
 Lukas Adamowicz
 Copyright (c) 2021. Pfizer Inc. All rights reserved.
 """
-from warnings import warn
+from pathlib import Path
 
-from numpy import vstack, asarray, int_
+from numpy import vstack, asarray, zeros, int_
 
 from skdh.base import BaseProcess
-from skdh.io.base import check_input_file
+from skdh.utility.time_anchors import TimeAnchors
+from skdh.io.base import check_input_file, handle_bases_periods
+from skdh.io.block_index import BlockIndex
+from skdh.io.utility import ReadBuffers
 from skdh.io._extensions import read_geneactiv
 
+# samples in each data page
+GN_SAMPLES = 300
+
 
 class ReadBin(BaseProcess):
     """
@@ -35,6 +41,40 @@ class ReadBin(BaseProcess):
         What to do if the file extension does not match the expected extension (.bin).
         Default is "warn". "raise" raises a ValueError. "skip" skips the file
         reading altogether and attempts to continue with the pipeline.
+    use_mmap : bool, optional
+        Memory map the file and parse the data pages directly from the mapping, instead
+        of reading each page from the file separately. Default is True, so files
+        are memory mapped unless this is set to False, which reads the pages
+        with file reads as before, eg for file systems that do not support
+        memory mapping well.
+    workers : int, optional
+        Number of threads to parse the data pages with. If more than 1, the file
+        is always memory mapped. Default is 1.
+    dtype : {"float64", "float32", "int16"}, optional
+        Data type of the returned sensor data. "float32" halves the memory used.
+        "int16" returns the raw sensor counts, along with a scale and offset for
+        each sensor (eg `accel_scale`, `accel_offset`) such that
+        `value = (counts - offset) / scale`. Default is "float64".
+    time_ns : bool, optional
+        Return timestamps as int64 nanoseconds since the epoch, instead of float64
+        seconds. Default is False.
+    index : bool, optional
+        Use the block index saved next to the file (`<file>.skdhidx.npz`) for the
+        windows, instead of computing them while parsing the file. If there is not a
+        current index, it is recorded while parsing the file and saved. The index can
+        also be loaded with :func:`skdh.io.get_block_index` to compute windows for
+        other `bases` and `periods` without reading the file again. Default is False.
+    time_anchors : bool, optional
+        Return `time` as :class:`skdh.utility.time_anchors.TimeAnchors`, one anchor
+        per data page, instead of a full array with one timestamp per sample. The
+        anchors behave like a read-only array, and timestamps are only computed when
+        indexed, or when converted to a full array (eg `numpy.asarray(time)`).
+        Timestamps match the full array to within floating point rounding. Default
+        is False.
+    buffers : {None, skdh.io.ReadBuffers}, optional
+        Storage to parse the file into, re-used between files. The returned data
+        are views of the buffers, and are overwritten by the next file read with the
+        same buffers. Default is None, which allocates new arrays for each file.
 
     Examples
     ========
@@ -51,46 +91,52 @@ class ReadBin(BaseProcess):
     {'accel': ..., 'time': ..., 'day_ends': [130, 13951, ...]}
     """
 
-    def __init__(self, bases=None, periods=None, ext_error="warn"):
+    def __init__(
+        self,
+        bases=None,
+        periods=None,
+        ext_error="warn",
+        use_mmap=True,
+        workers=1,
+        dtype="float64",
+        time_ns=False,
+        index=False,
+        time_anchors=False,
+        buffers=None,
+    ):
         super().__init__(
             # kwargs
             bases=bases,
             periods=periods,
             ext_error=ext_error,
+            use_mmap=use_mmap,
+            workers=workers,
+            dtype=dtype,
+            time_ns=time_ns,
+            index=index,
+            time_anchors=time_anchors,
+            buffers=buffers,
         )
 
+        self.use_mmap = use_mmap
+        self.workers = max(int(workers), 1)
+
+        if dtype not in ["float64", "float32", "int16"]:
+            raise ValueError("`dtype` must be one of 'float64', 'float32', 'int16'.")
+        self.dtype = dtype
+        self.time_ns = time_ns
+        self.index = index
+        self.time_anchors = time_anchors
+        if (buffers is not None) and not isinstance(buffers, ReadBuffers):
+            raise ValueError("`buffers` must be a `skdh.io.ReadBuffers` instance.")
+        self.buffers = buffers
+
         if ext_error.lower() in ["warn", "raise", "skip"]:
             self.ext_error = ext_error.lower()
         else:
             raise ValueError("`ext_error` must be one of 'raise', 'warn', 'skip'.")
 
-        if (bases is None) and (periods is None):
-            self.window = False
-            self.bases = asarray([0])  # needs to be defined for passing to extensions
-            self.periods = asarray([12])
-        elif (bases is None) or (periods is None):
-            warn("One of base or period is None, not windowing", UserWarning)
-            self.window = False
-            self.bases = asarray([0])
-            self.periods = asarray([12])
-        else:
-            if isinstance(bases, int) and isinstance(periods, int):
-                bases = asarray([bases])
-                periods = asarray([periods])
-            else:
-                bases = asarray(bases, dtype=int_)
-                periods = asarray(periods, dtype=int_)
-
-            if ((0 <= bases) & (bases <= 23)).all() and (
-                (1 <= periods) & (periods <= 24)
-            ).all():
-                self.window = True
-                self.bases = bases
-                self.periods = periods
-            else:
-                raise ValueError(
-                    "Base must be in [0, 23] and period must be in [1, 23]"
-                )
+        self.window, self.bases, self.periods = handle_bases_periods(bases, periods)
 
     @check_input_file(".bin")
     def predict(self, file=None, **kwargs):
@@ -120,28 +166,76 @@ class ReadBin(BaseProcess):
         The keys in `data` depend on which data the file contained. Potential keys are:
 
         - `accel`: acceleration [g]
-        - `time`: timestamps [s]
+        - `time`: timestamps [s], or [ns] if `time_ns`
         - `light`: light values [unknown]
         - `temperature`: temperature [deg C]
         - `day_ends`: window indices
+        - `accel_scale`, `accel_offset`: scale and offset of the raw counts, if
+          `dtype` is "int16"
+        - `block_samples`: number of samples in each data page. Timestamps are
+          linear within each page.
+        - `block_offset`: index within its data page of the first sample, always 0
         """
         super().predict(expect_days=False, expect_wear=False, file=file, **kwargs)
 
+        index = BlockIndex.load(file) if self.index else None
+        # windows are computed from the index instead of while parsing
+        if index is None:
+            bases, periods = self.bases, self.periods
+        else:
+            bases, periods = zeros(0, dtype=int_), zeros(0, dtype=int_)
+        # stat before reading, so that a file modified while reading is stale
+        stat = Path(file).stat() if (self.index and index is None) else None
+
         # read the file
-        n_max, fs, acc, time, light, temp, starts, stops = read_geneactiv(
-            file, self.bases, self.periods
+        (
+            n_max,
+            fs,
+            acc,
+            time,
+            light,
+            temp,
+            starts,
+            stops,
+            scale,
+            offset,
+            records,
+        ) = read_geneactiv(
+            file,
+            bases,
+            periods,
+            self.dtype,
+            self.time_ns and not self.time_anchors,
+            self.use_mmap,
+            self.workers,
+            *self._output_buffers(file),
+            stat is not None,
         )
+        if records is not None:
+            n, records = records
+            BlockIndex.from_records(file, stat, fs, GN_SAMPLES, records, n=n).save()
+
+        time = time[:n_max]
+        if self.time_anchors:
+            time = TimeAnchors.from_time(time, GN_SAMPLES, fs, ns=self.time_ns)
 
         results = {
-            self._time: time[:n_max],
+            self._time: time,
             self._acc: acc[:n_max, :],
             self._temp: temp[:n_max],
             "light": light[:n_max],
             "fs": fs,
             "file": file,
+            "block_samples": GN_SAMPLES,
+            "block_offset": 0,
         }
+        if self.dtype == "int16":
+            results[f"{self._acc}_scale"] = scale
+            results[f"{self._acc}_offset"] = offset
 
-        if self.window:
+        if self.window and (index is not None):
+            results[self._days] = index.day_ends(self.bases, self.periods)
+        elif self.window:
             results[self._days] = {}
             for i, data in enumerate(zip(self.bases, self.periods)):
                 strt = starts[stops[:, i] != 0, i]
@@ -152,3 +246,32 @@ class ReadBin(BaseProcess):
         kwargs.update(results)
 
         return (kwargs, None) if self._in_pipeline else kwargs
+
+    def _output_buffers(self, file):
+        """
+        Storage to parse the file into, from the re-used buffers. The number of pages
+        is taken from the file header.
+        """
+        if self.buffers is None:
+            return None, None, None, None
+
+        npages = None
+        with open(file, "r", errors="ignore") as f:
+            for _, line in zip(range(100), f):
+                if line.startswith("Number of Pages:"):
+                    npages = int(line[16:].strip() or 0)
+                    break
+        # let the reader deal with bad headers
+        if not npages or npages < 0:
+            return None, None, None, None
+
+        n = npages * GN_SAMPLES
+        time_ns = self.time_ns and not self.time_anchors
+        other = "float64" if self.dtype == "float64" else "float32"
+
+        return (
+            self.buffers.get("accel", n * 3, self.dtype),
+            self.buffers.get("time", n, "int64" if time_ns else "float64"),
+            self.buffers.get("light", n, other),
+            self.buffers.get("temperature", n, other),
+        )
@@ -4,11 +4,75 @@ Read from a numpy compressed file.
 Lukas Adamowicz
 Copyright (c) 2021. Pfizer Inc. All rights reserved.
 """
-from numpy import load as np_load
+from pathlib import Path
+from struct import unpack
+from zipfile import ZipFile, ZIP_STORED
+
+from numpy import load as np_load, savez, memmap, asarray
+from numpy.lib import format as npformat
 
 from skdh.base import BaseProcess
 from skdh.io.base import check_input_file
 
+# prefix of the keys that day window indices are stored under, eg `day_ends_8_12`
+DAYS_PREFIX = "day_ends_"
+
+
+def _mmap_member(f, info):
+    """
+    Memory map an array stored uncompressed in a `.npz` file. Returns None for arrays
+    that can not be mapped (compressed, object, empty or 0-d arrays).
+    """
+    if info.compress_type != ZIP_STORED:
+        return None
+
+    # the local header has its own name and extra field lengths
+    f.seek(info.header_offset + 26)
+    n_name, n_extra = unpack("<HH", f.read(4))
+    f.seek(info.header_offset + 30 + n_name + n_extra)
+
+    version = npformat.read_magic(f)
+    if version == (1, 0):
+        shape, fortran, dtype = npformat.read_array_header_1_0(f)
+    elif version == (2, 0):
+        shape, fortran, dtype = npformat.read_array_header_2_0(f)
+    else:
+        shape, dtype = (), None
+
+    if (dtype is None) or dtype.hasobject or (shape == ()) or (0 in shape):
+        return None
+
+    return memmap(f.name, dtype=dtype, mode="r", offset=f.tell(), shape=shape, order="F" if fortran else "C")
+
+
+def _load_npz(file, allow_pickle, mmap):
+    """
+    Load the contents of a `.npz` file into a dictionary.
+    """
+    data = {}
+    with np_load(file, allow_pickle=allow_pickle) as npz:
+        if not mmap:
+            data.update(npz)  # pull everything in
+        else:
+            with ZipFile(file) as zf, open(file, "rb") as f:
+                for info in zf.infolist():
+                    key = info.filename[:-4] if info.filename.endswith(".npy") else info.filename
+                    arr = _mmap_member(f, info)
+                    # read the arrays that can not be mapped into memory
+                    data[key] = npz[key] if arr is None else arr
+    return data
+
+
+def _load_npy(file, allow_pickle, mmap):
+    """
+    Load a `.npy` file of a structured array into a dictionary, one key per field.
+    """
+    arr = np_load(file, mmap_mode="r" if mmap else None, allow_pickle=allow_pickle)
+    if arr.dtype.names is None:
+        raise ValueError("`.npy` files must contain a structured array with named fields.")
+
+    return {name: arr[name] for name in arr.dtype.names}
+
 
 class ReadNumpyFile(BaseProcess):
     """
@@ -17,6 +81,8 @@ class ReadNumpyFile(BaseProcess):
     unprocessed - ie acceleration is already assumed to be in units of
     'g' and time in units of seconds. No day windowing is performed. Expected
     keys are `time` and `accel`. If `fs` is present, it is used as well.
+    Day window indices are read from keys of the form `day_ends_<base>_<period>`,
+    as written by :class:`WriteNumpyFile`.
 
     Parameters
     ----------
@@ -24,22 +90,36 @@ class ReadNumpyFile(BaseProcess):
         Allow pickled objects in the NumPy file. Default is False, which is the safer option.
         For more information see :py:meth:`numpy.load`.
     ext_error : {"warn", "raise", "skip"}, optional
-        What to do if the file extension does not match the expected extension (.npz).
-        Default is "warn". "raise" raises a ValueError. "skip" skips the file
+        What to do if the file extension does not match the expected extensions
+        (.npz, .npy). Default is "warn". "raise" raises a ValueError. "skip" skips the file
         reading altogether and attempts to continue with the pipeline.
+    mmap : bool, optional
+        Memory map the arrays instead of reading them into memory, so that only the
+        parts of the data that are used are read from disk. Arrays in `.npz` files
+        have to be stored uncompressed (ie with `numpy.savez`, not
+        `numpy.savez_compressed`) to be mapped, others are read into memory.
+        Mapped arrays are read-only. Default is False.
+
+    Notes
+    -----
+    `.npy` files have to contain a structured array, and each field is returned
+    under its own key.
     """
 
-    def __init__(self, allow_pickle=False, ext_error="warn"):
-        super(ReadNumpyFile, self).__init__(allow_pickle=allow_pickle, ext_error=ext_error)
+    def __init__(self, allow_pickle=False, ext_error="warn", mmap=False):
+        super(ReadNumpyFile, self).__init__(
+            allow_pickle=allow_pickle, ext_error=ext_error, mmap=mmap
+        )
 
         self.allow_pickle = allow_pickle
+        self.mmap = mmap
 
         if ext_error.lower() in ["warn", "raise", "skip"]:
             self.ext_error = ext_error.lower()
         else:
             raise ValueError("`ext_error` must be one of 'raise', 'warn', 'skip'.")
 
-    @check_input_file(".npz", check_size=True)
+    @check_input_file((".npz", ".npy"), check_size=True)
     def predict(self, file=None, **kwargs):
         """
         predict(file)
@@ -69,14 +149,27 @@ class ReadNumpyFile(BaseProcess):
         - `accel`: acceleration [g]
         - `time`: timestamps [s]
         - `fs`: sampling frequency in Hz.
+        - `day_ends`: dictionary of day window indices.
         """
         super().predict(expect_days=False, expect_wear=False, file=file, **kwargs)
 
-        with np_load(file, allow_pickle=self.allow_pickle) as data:
-            kwargs.update(data)  # pull everything in
-            # make sure that fs is saved properly
-            if "fs" in data:
-                kwargs["fs"] = data["fs"][()]
+        if Path(file).suffix == ".npy":
+            data = _load_npy(file, self.allow_pickle, self.mmap)
+        else:
+            data = _load_npz(file, self.allow_pickle, self.mmap)
+
+        # day windows are stored flat, one key per window
+        day_keys = [k for k in data if k.startswith(DAYS_PREFIX)]
+        if day_keys:
+            data[self._days] = {}
+        for k in day_keys:
+            base, period = k[len(DAYS_PREFIX):].split("_")
+            data[self._days][(int(base), int(period))] = asarray(data.pop(k))
+
+        kwargs.update(data)
+        # make sure that fs is saved properly
+        if "fs" in data:
+            kwargs["fs"] = data["fs"][()]
 
         # check that time and accel are in the correct names
         if self._time not in kwargs or self._acc not in kwargs:
@@ -86,3 +179,81 @@ class ReadNumpyFile(BaseProcess):
         kwargs.update({'file': file})
 
         return (kwargs, None) if self._in_pipeline else kwargs
+
+
+class WriteNumpyFile(BaseProcess):
+    """
+    Write the data from a reader to an uncompressed numpy `.npz` file, which can be
+    read back memory mapped by :class:`ReadNumpyFile` with `mmap=True`. The data is
+    passed through unchanged, so this can be added to a pipeline right after a reader
+    to store the ingested data for later runs.
+
+    Parameters
+    ----------
+    save_name : {None, str}, optional
+        File name to save to. Can be formatted with `{file}`, the name (without
+        extension) of the file that was read, eg "{file}_ingested.npz". Default is
+        None, which saves next to the file that was read, as `<file>.skdh.npz`.
+    keys : {None, list-like}, optional
+        Keys of the data to save, if present. Default is None, which saves `time`,
+        `accel`, `gyro`, `temperature`, `fs`, and `day_ends`.
+
+    Notes
+    -----
+    Day window indices are saved under keys of the form `day_ends_<base>_<period>`.
+    """
+
+    def __init__(self, save_name=None, keys=None):
+        super().__init__(save_name=save_name, keys=keys)
+
+        self.save_name = save_name
+        if keys is None:
+            keys = [self._time, self._acc, self._gyro, self._temp, "fs", self._days]
+        self.keys = list(keys)
+
+    def predict(self, file=None, **kwargs):
+        """
+        predict(file=None, **kwargs)
+
+        Write the data to a numpy file.
+
+        Parameters
+        ----------
+        file : {str, Path}, optional
+            Path to the file that the data was read from. Required if `save_name`
+            is None, or contains `{file}`.
+        kwargs
+            Data to save.
+
+        Returns
+        -------
+        data : dict
+            The input data, with the addition of `numpy_file`, the file that was
+            written.
+        """
+        super().predict(expect_days=False, expect_wear=False, file=file, **kwargs)
+
+        if self.save_name is None:
+            if file is None:
+                raise ValueError("`file` must be provided if `save_name` is None.")
+            save_file = Path(file).with_name(Path(file).name + ".skdh.npz")
+        else:
+            save_file = Path(self.save_name.format(file=self._file_name))
+
+        data = {}
+        for k in self.keys:
+            if k not in kwargs:
+                continue
+            if k == self._days:
+                for (base, period), idx in kwargs[k].items():
+                    data[f"{DAYS_PREFIX}{base}_{period}"] = asarray(idx)
+            else:
+                # asarray also expands time anchors to the full timestamps
+                data[k] = asarray(kwargs[k])
+
+        # uncompressed, so the arrays can be memory mapped when read
+        savez(save_file, **data)
+
+        kwargs.update({"file": file, "numpy_file": str(save_file)})
+
+        return (kwargs, None) if self._in_pipeline else kwargs
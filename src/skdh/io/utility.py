@@ -1,2 +1,130 @@
+from numpy import asarray, atleast_2d, clip, diff, append, repeat, empty, dtype as np_dtype
+
+
 class FileSizeError(Exception):
     pass
+
+
+def counts_to_values(counts, scale, offset, scale_index=None):
+    """
+    counts_to_values(counts, scale, offset, scale_index=None)
+
+    Convert raw sensor counts (eg from a reader with `dtype="int16"`) to values,
+    `(counts - offset) / scale`.
+
+    Parameters
+    ----------
+    counts : numpy.ndarray
+        Raw sensor counts, shape (N, 3).
+    scale : numpy.ndarray
+        Counts per unit for each axis, shape (3,), or for each run of samples with
+        the same scale, shape (M, 3).
+    offset : numpy.ndarray
+        Offset of the counts for each axis, shape (3,).
+    scale_index : numpy.ndarray, optional
+        Index of the first sample of each run of samples in `scale`, shape (M,). Not
+        needed if there is only one scale.
+
+    Returns
+    -------
+    values : numpy.ndarray
+        Sensor values, shape (N, 3).
+
+    Examples
+    --------
+    >>> data = ReadCwa(dtype="int16").predict("example.cwa")
+    >>> accel = counts_to_values(
+    ...     data["accel"], data["accel_scale"], data["accel_offset"],
+    ...     data["accel_scale_index"]
+    ... )
+    """
+    scale = atleast_2d(asarray(scale, dtype="float64"))
+    if scale.shape[0] > 1:
+        if scale_index is None:
+            raise ValueError("`scale_index` is required for more than one scale.")
+        runs = diff(append(asarray(scale_index), counts.shape[0]))
+        scale = repeat(scale, runs, axis=0)
+
+    return (counts - asarray(offset)) / scale
+
+
+def trim_scale_runs(scale, scale_index, i1, i2):
+    """
+    Trim runs of samples with the same scale to the samples [i1, i2), keeping at
+    least one run.
+    """
+    scale_index = asarray(scale_index) - i1
+    # runs that end before the first sample, or start after the last, are dropped
+    keep = append(scale_index[1:] > 0, True) & (scale_index < max(i2 - i1, 1))
+    keep[0] |= not keep.any()
+    return asarray(scale)[keep], clip(scale_index[keep], 0, None)
+
+
+class ReadBuffers:
+    """
+    Re-usable output storage for device readers (:class:`skdh.io.ReadCwa`,
+    :class:`skdh.io.ReadBin`). Reading many files with the same buffers decodes
+    each file into the same memory, instead of allocating (and faulting in) new
+    arrays for every file. Buffers grow as needed, and are kept for the next file.
+
+    The data returned by a reader using buffers are views of the buffers, so are
+    overwritten by the next file read with the same buffers. Use one set of buffers
+    per thread, and copy any data that has to outlive the next read.
+
+    Parameters
+    ----------
+    headroom : float, optional
+        Fraction of extra space to allocate when a buffer has to grow, so that
+        slightly longer files do not need a new buffer. Default is 0.1.
+
+    Examples
+    --------
+    >>> buffers = ReadBuffers()
+    >>> reader = ReadCwa(buffers=buffers)
+    >>> for file in files:
+    ...     data = reader.predict(file)
+    ...     results.append(compute(data))
+    """
+
+    def __init__(self, headroom=0.1):
+        self.headroom = max(float(headroom), 0.0)
+        self._buffers = {}
+
+    def get(self, name, size, dtype):
+        """
+        get(name, size, dtype)
+
+        Get a buffer with room for at least `size` elements of `dtype`.
+
+        Parameters
+        ----------
+        name : str
+            Name of the buffer, eg "accel".
+        size : int
+            Minimum number of elements.
+        dtype : {str, numpy.dtype}
+            Data type of the buffer.
+
+        Returns
+        -------
+        buffer : numpy.ndarray
+            1D buffer, with at least `size` elements.
+        """
+        dtype = np_dtype(dtype)
+        buf = self._buffers.get(name)
+        if (buf is None) or (buf.dtype != dtype) or (buf.size < size):
+            buf = empty(int(size * (1.0 + self.headroom)) + 1, dtype=dtype)
+            self._buffers[name] = buf
+        return buf
+
+    @property
+    def nbytes(self):
+        return sum(b.nbytes for b in self._buffers.values())
+
+    def clear(self):
+        """
+        clear()
+
+        Release the memory of all the buffers.
+        """
+        self._buffers = {}
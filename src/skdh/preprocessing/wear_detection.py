@@ -30,7 +30,7 @@ from numpy.linalg import norm
 from scipy.signal import butter, sosfiltfilt
 
 from skdh.base import BaseProcess
-from skdh.utility import moving_mean, moving_sd, moving_max, moving_min
+from skdh.utility import moving_mean, moving_sd, moving_stats
 from skdh.utility.internal import rle, invert_indices
 from skdh.utility.activity_counts import get_activity_counts
 
@@ -259,8 +259,11 @@ class DETACH(BaseProcess):
         perc_under_sd_range_5min_bwd = perc_under_sd_range_5min_bwd[: temp_ds.size]
 
         # Get the maximum & minimum temperature in 5 minute windows
-        max_temp_5min = moving_max(temp_f, wlen_ds_5min, 1, trim=False)
-        min_temp_5min = moving_min(temp_f, wlen_ds_5min, 1, trim=False)
+        temp_stats_5min = moving_stats(
+            temp_f, wlen_ds_5min, 1, stats=["max", "min"], trim=False
+        )
+        max_temp_5min = temp_stats_5min["max"]
+        min_temp_5min = temp_stats_5min["min"]
 
         # get the average temperature change in the next 5 minutes
         avg_temp_delta_5min = moving_mean(delta_temp_f, wlen_ds_5min, 1, trim=False)
@@ -835,12 +838,10 @@ class AccelThresholdWearDetection(BaseProcess):
         # note that while this block starts at 0, the method uses centered blocks, which
         # means that the first block actually corresponds to a block starting
         # 22.5 minutes into the recording
-        acc_rsd = moving_sd(accel, n_wlen, n_wskip, axis=0, return_previous=False)
-
-        # get the accelerometer range in each 60min window
-        acc_w_range = moving_max(accel, n_wlen, n_wskip, axis=0) - moving_min(
-            accel, n_wlen, n_wskip, axis=0
-        )
+        # get the accelerometer sd and range in each 60min window
+        acc_stats = moving_stats(accel, n_wlen, n_wskip, ["sd", "range"], axis=0)
+        acc_rsd = acc_stats["sd"]
+        acc_w_range = acc_stats["range"]
 
         nonwear = (
             sum((acc_rsd < self.sd_crit) & (acc_w_range < self.range_crit), axis=1) >= 2
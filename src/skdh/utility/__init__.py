@@ -27,6 +27,8 @@ Misc. Math Functions
     math.moving_skewness
     math.moving_kurtosis
     math.moving_median
+    math.moving_stats
+    math.MovingStatsAccumulator
 
 Orientation Functions
 ---------------------
@@ -36,6 +38,14 @@ Orientation Functions
 
     orientation.correct_accelerometer_orientation
 
+Time Anchors
+------------
+
+.. autosummary::
+    :toctree: generated/
+
+    time_anchors.TimeAnchors
+    time_anchors.interp_anchors
 
 Windowing Functions
 -------------------
@@ -53,6 +63,8 @@ from skdh.utility.math import *
 from skdh.utility import math
 from skdh.utility.orientation import correct_accelerometer_orientation
 from skdh.utility import orientation
+from skdh.utility.time_anchors import TimeAnchors, interp_anchors
+from skdh.utility import time_anchors
 from skdh.utility.windowing import compute_window_samples, get_windowed_view
 from skdh.utility import windowing
 from skdh.utility import activity_counts
@@ -60,10 +72,11 @@ from skdh.utility.activity_counts import *
 
 
 __all__ = (
-    ["math", "windowing", "orientation", "fragmentation_endpoints"]
+    ["math", "windowing", "orientation", "fragmentation_endpoints", "time_anchors"]
     + fragmentation_endpoints.__all__
     + math.__all__
     + windowing.__all__
     + orientation.__all__
+    + time_anchors.__all__
     + activity_counts.__all__
 )
@@ -6,6 +6,7 @@ from .moving_statistics import (
     moving_median,
     moving_max,
     moving_min,
+    moving_stats,
 )
 
 __all__ = [
@@ -16,4 +17,5 @@ __all__ = [
     "moving_median",
     "moving_max",
     "moving_min",
+    "moving_stats",
 ]
@@ -6,7 +6,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <pthread.h>
 
 /* moving max/min */
 #include "moving_extrema.h"
@@ -18,201 +20,580 @@ extern void mov_moments_2(long *, double *, long *, long *, double *, double *);
 extern void moving_moments_2(long *, double *, long *, long *, double *, double *);
 extern void moving_moments_3(long *, double *, long *, long *, double *, double *, double *);
 extern void moving_moments_4(long *, double *, long *, long *, double *, double *, double *, double *);
-/* moving median */
-extern void fmoving_median(int *, double *, int *, int *, double *);
+extern void moving_moments_stream(long *, double *, long *, long *, long *, long *, long *, long *,
+    long *, double *, double *, double *, double *, double *, double *);
+/* moving median. Reentrant, each call allocates its own heap workspace */
+extern void fmoving_median(long *, double *, long *, long *, double *);
+/* streaming moving median, with the heap workspace kept between calls */
+extern void *fmedian_stream_new(long *);
+extern void fmedian_stream_init(void *, double *);
+extern void fmedian_stream_insert(void *, double *);
+extern double fmedian_stream_get(void *);
+extern void fmedian_stream_free(void *);
+
+
+/* statistics computed per row by the moving kernels */
+typedef enum {
+    MOVSTAT_MEAN = 0,
+    MOVSTAT_SD,
+    MOVSTAT_SKEW,
+    MOVSTAT_KURT,
+    MOVSTAT_MEDIAN,
+    MOVSTAT_MAX,
+    MOVSTAT_MIN,
+    MOVSTAT_RANGE,
+    MOVSTAT_N  /* number of statistics */
+} MovStat_t;
+
+/* names of the statistics, as used by `moving_stats` */
+static const char *movstat_names[MOVSTAT_N] = {
+    "mean", "sd", "skewness", "kurtosis", "median", "max", "min", "range"
+};
 
+#define MOVSTAT_BIT(s) (1u << (s))
+#define MOVSTAT_MOMENTS (MOVSTAT_BIT(MOVSTAT_MEAN) | MOVSTAT_BIT(MOVSTAT_SD) \
+    | MOVSTAT_BIT(MOVSTAT_SKEW) | MOVSTAT_BIT(MOVSTAT_KURT))
+
+#define MOVSTAT_STREAM_NAME "skdh.utility.moving_stats_stream"
+
+/* state of a streaming computation, carried between the chunks of a series. The position in the
+ * series is shared by all the rows, the kernel state is kept per row. Each of the kernels only
+ * does work for the new samples of a chunk */
+typedef struct {
+    unsigned int stats;  /* bit mask of the requested statistics */
+    unsigned int needed;  /* bit mask of the statistics that are computed */
+    MovStat_t order[MOVSTAT_N];  /* statistics to return, in the order to return them */
+    int nout;  /* number of statistics in `order` */
+    long wlen;
+    long skip;
+    long nrows;  /* rows of every chunk */
+    long cnt;  /* samples of the series so far */
+    long nwin;  /* windows completed so far */
+    long morder;  /* highest moment computed, 0 if none */
+    long nq;  /* capacity of the window start queues */
+    long qhead;  /* oldest window start in the queues */
+    long qlen;  /* number of window starts in the queues */
+    long nfill;  /* samples collected to fill the median heaps */
+    int heap_live;  /* if the median heaps hold the current window */
+    int busy;  /* if an update is in progress, only changed while holding the GIL */
+    int failed;  /* if an update failed part way, and left the row state inconsistent */
+    double *m;  /* running sums for the moments, 4 per row */
+    double *q;  /* running sums at the window starts, 4 * nq per row */
+    void **heap;  /* median heap workspace per row */
+    double *fill;  /* samples to fill the median heaps, wlen per row */
+    double *ext_val[2];  /* max and min monotonic queue values, wlen per row */
+    long *ext_idx[2];  /* position in the series of each queue value */
+    long *ext_head[2];  /* oldest value in each queue */
+    long *ext_len[2];  /* number of values in each queue */
+} MovStat_Stream_t;
+
+/* work for a single thread, a contiguous range of rows. A row is every sample along the moving
+ * axis for one index of all the other axes. Neither the input nor the results need to be
+ * contiguous along the moving axis */
+typedef struct {
+    unsigned int stats;  /* bit mask of the requested statistics */
+    char *x;  /* start of the input data */
+    double *res[MOVSTAT_N];  /* start of each requested result, indexed by MovStat_t */
+    long npts;  /* samples along the moving axis of the input */
+    long wlen;
+    long skip;
+    long trim_pts;  /* windows that can be computed in each row */
+    long res_len;  /* samples along the moving axis of the results */
+    npy_intp x_stride;  /* input stride (bytes) along the moving axis */
+    npy_intp res_stride;  /* result stride (elements) along the moving axis */
+    int row_ndim;  /* number of axes other than the moving axis */
+    npy_intp row_dims[NPY_MAXDIMS];  /* shape of the other axes */
+    npy_intp x_row_strides[NPY_MAXDIMS];  /* input strides (bytes) of the other axes */
+    npy_intp res_row_strides[NPY_MAXDIMS];  /* result strides (elements) of the other axes */
+    long start;  /* first row to compute */
+    long stop;  /* last row (+1) to compute */
+    MovStat_Stream_t *stream;  /* carried state, only for streaming computations */
+    int status;  /* 0 if successful, -1 if scratch storage could not be allocated */
+} MovStat_Thread_t;
+
+
+/**
+ * Get the statistics that have to be computed to get the requested ones. The moment kernels
+ * compute every lower moment as well, and the range needs the max and min.
+ *
+ * @param stats Bit mask of the requested statistics
+ *
+ * @result Bit mask of the statistics that are computed
+ */
+static unsigned int movstat_needed(unsigned int stats)
+{
+    unsigned int needed = stats;
 
-PyObject * moving_mean(PyObject *NPY_UNUSED(self), PyObject *args){
-    PyObject *x_;
-    long wlen, skip;
-    int trim;
+    for (int s = MOVSTAT_KURT; s > MOVSTAT_MEAN; --s)
+    {
+        if (needed & MOVSTAT_BIT(s))
+            needed |= MOVSTAT_BIT(s - 1);
+    }
+    if (stats & MOVSTAT_BIT(MOVSTAT_RANGE))
+        needed |= MOVSTAT_BIT(MOVSTAT_MAX) | MOVSTAT_BIT(MOVSTAT_MIN);
 
-    if (!PyArg_ParseTuple(args, "Ollp:moving_mean", &x_, &wlen, &skip, &trim))
-        return NULL;
+    return needed;
+}
 
-    PyArrayObject *data = (PyArrayObject *)PyArray_FromAny(
-        x_,
-        PyArray_DescrFromType(NPY_DOUBLE),
-        1,
-        0,
-        NPY_ARRAY_ENSUREARRAY | NPY_ARRAY_CARRAY_RO,
-        NULL
-    );
-    if (!data)
-        return NULL;
+/**
+ * Get the offsets of the start of a row in the input and the results.
+ *
+ * @param t       Work definition
+ * @param i       Row number, with the last of the other axes changing fastest
+ * @param x_off   Offset (bytes) of the row in the input
+ * @param res_off Offset (elements) of the row in the results
+ */
+static void movstat_row_offsets(const MovStat_Thread_t *t, long i, npy_intp *x_off, npy_intp *res_off)
+{
+    npy_intp idx;
+    long row = i;
 
-    // get the number of dimensions, and the shape
-    int ndim = PyArray_NDIM(data);
-    const npy_intp *ddims = PyArray_DIMS(data);
-    long npts = ddims[ndim - 1];
-    long trim_pts = (npts - wlen) / skip + 1;
-    npy_intp *rdims = (npy_intp *)malloc(ndim * sizeof(npy_intp));
-    if (!rdims)
-    {
-        Py_XDECREF(data);
-        return NULL;
-    }
-    // create return shape
-    for (int i = 0; i < (ndim - 1); ++i)
+    *x_off = 0;
+    *res_off = 0;
+    for (int d = t->row_ndim - 1; d >= 0; --d)
     {
-        rdims[i] = ddims[i];
-    }
-    // dimension of the roll
-    if (trim)
-    {
-        rdims[ndim - 1] = trim_pts;
-    } else {
-        rdims[ndim - 1] = (npts - 1) / skip + 1;
+        idx = row % t->row_dims[d];
+        row /= t->row_dims[d];
+        *x_off += idx * t->x_row_strides[d];
+        *res_off += idx * t->res_row_strides[d];
     }
+}
 
-    PyArrayObject *rmean = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    free(rdims);
+/**
+ * Compute the moving statistics for a contiguous range of rows. Run by each of the worker
+ * threads. Each row is read once into the kernels, and all the requested statistics are
+ * computed from it before moving to the next row, so the moments are computed by a single kernel
+ * call, and the range comes from the max and min.
+ *
+ * Strided rows are gathered into a scratch row before computing. Strided results, and results
+ * that are only needed as an intermediate, are computed into scratch rows, so only one row is
+ * ever copied at a time.
+ *
+ * @param arg Pointer to the MovStat_Thread_t work definition for this thread
+ */
+static void *movstat_rows(void *arg)
+{
+    MovStat_Thread_t *t = (MovStat_Thread_t *)arg;
+    unsigned int needed = movstat_needed(t->stats);
+    int x_contig = t->x_stride == (npy_intp)sizeof(double);
+    int res_contig = t->res_stride == 1;
+    int use_rbuf = !res_contig || (needed != t->stats);
+    double *r[MOVSTAT_N] = {NULL};
+    double *xbuf = NULL, *rbuf = NULL, *x;
+    npy_intp x_off, res_off;
+
+    t->status = 0;
+    if (t->start >= t->stop)
+        return NULL;
 
-    if (!rmean)
+    if (!x_contig)
+        xbuf = (double *)malloc(t->npts * sizeof(double));
+    if (use_rbuf)
+        rbuf = (double *)malloc(MOVSTAT_N * t->res_len * sizeof(double));
+    if ((!x_contig && !xbuf) || (use_rbuf && !rbuf))
     {
-        Py_XDECREF(data);
-        Py_XDECREF(rmean);
+        free(xbuf);
+        free(rbuf);
+        t->status = -1;
         return NULL;
     }
 
-    // data pointers
-    double *dptr = (double *)PyArray_DATA(data);
-    double *rmean_ptr = (double *)PyArray_DATA(rmean);
-    // for iterating over the data
-    long res_stride = PyArray_DIM(rmean, ndim - 1);  // stride to get to the next results "column"
-    int nrepeats = PyArray_SIZE(data) / npts;  // number of repetitions to cover all the data
-
-    for (int i = 0; i < nrepeats; ++i)
+    for (long i = t->start; i < t->stop; ++i)
     {
-        for (int j = trim_pts; j < res_stride; ++j)
+        movstat_row_offsets(t, i, &x_off, &res_off);
+
+        if (x_contig)
+            x = (double *)(t->x + x_off);
+        else
+        {
+            for (long j = 0; j < t->npts; ++j)
+                xbuf[j] = *(double *)(t->x + x_off + j * t->x_stride);
+            x = xbuf;
+        }
+
+        for (int s = 0; s < MOVSTAT_N; ++s)
+        {
+            if (!(needed & MOVSTAT_BIT(s)))
+                continue;
+            if (res_contig && (t->stats & MOVSTAT_BIT(s)))
+                r[s] = t->res[s] + res_off;
+            else
+                r[s] = rbuf + s * t->res_len;
+            // windows past the end of the data, if not trimming
+            for (long j = t->trim_pts; j < t->res_len; ++j)
+                r[s][j] = NPY_NAN;
+        }
+
+        // highest moment needed gives all the lower moments in the same pass
+        if (needed & MOVSTAT_BIT(MOVSTAT_KURT))
+            moving_moments_4(&t->npts, x, &t->wlen, &t->skip, r[MOVSTAT_MEAN], r[MOVSTAT_SD],
+                r[MOVSTAT_SKEW], r[MOVSTAT_KURT]);
+        else if (needed & MOVSTAT_BIT(MOVSTAT_SKEW))
+            moving_moments_3(&t->npts, x, &t->wlen, &t->skip, r[MOVSTAT_MEAN], r[MOVSTAT_SD],
+                r[MOVSTAT_SKEW]);
+        else if (needed & MOVSTAT_BIT(MOVSTAT_SD))
+            mov_moments_2(&t->npts, x, &t->wlen, &t->skip, r[MOVSTAT_MEAN], r[MOVSTAT_SD]);
+        else if (needed & MOVSTAT_BIT(MOVSTAT_MEAN))
+            mov_moments_1(&t->npts, x, &t->wlen, &t->skip, r[MOVSTAT_MEAN]);
+
+        if (needed & MOVSTAT_BIT(MOVSTAT_MEDIAN))
+            fmoving_median(&t->npts, x, &t->wlen, &t->skip, r[MOVSTAT_MEDIAN]);
+        if (needed & MOVSTAT_BIT(MOVSTAT_MAX))
+            moving_max_c(&t->npts, x, &t->wlen, &t->skip, r[MOVSTAT_MAX]);
+        if (needed & MOVSTAT_BIT(MOVSTAT_MIN))
+            moving_min_c(&t->npts, x, &t->wlen, &t->skip, r[MOVSTAT_MIN]);
+        if (needed & MOVSTAT_BIT(MOVSTAT_RANGE))
+        {
+            for (long j = 0; j < t->trim_pts; ++j)
+                r[MOVSTAT_RANGE][j] = r[MOVSTAT_MAX][j] - r[MOVSTAT_MIN][j];
+        }
+
+        if (!res_contig)
         {
-            rmean_ptr[j] = NPY_NAN;
+            for (int s = 0; s < MOVSTAT_N; ++s)
+            {
+                if (!(t->stats & MOVSTAT_BIT(s)))
+                    continue;
+                for (long j = 0; j < t->res_len; ++j)
+                    t->res[s][res_off + j * t->res_stride] = r[s][j];
+            }
         }
-        mov_moments_1(&npts, dptr, &wlen, &skip, rmean_ptr);
-        dptr += npts;  // increment by number of points in last dimension
-        rmean_ptr += res_stride;
     }
 
-    Py_XDECREF(data);
+    free(xbuf);
+    free(rbuf);
 
-    return (PyObject *)rmean;
+    return NULL;
 }
 
+/* if the sample at position `g` of the series is in a window */
+static inline int movstream_in_window(const MovStat_Stream_t *s, long g)
+{
+    return (g % s->skip) < s->wlen;
+}
 
-PyObject * moving_sd(PyObject *NPY_UNUSED(self), PyObject *args){
-    PyObject *x_;
-    long wlen, skip;
-    int trim, return_others;
-
-    if (!PyArg_ParseTuple(args, "Ollpp:moving_sd", &x_, &wlen, &skip, &trim, &return_others))
-        return NULL;
+/* if the sample at position `g` of the series is the last sample of a window */
+static inline int movstream_window_end(const MovStat_Stream_t *s, long g)
+{
+    return ((g + 1) >= s->wlen) && (((g + 1 - s->wlen) % s->skip) == 0);
+}
 
-    PyArrayObject *data = (PyArrayObject *)PyArray_FromAny(
-        x_,
-        PyArray_DescrFromType(NPY_DOUBLE),
-        1,
-        0,
-        NPY_ARRAY_ENSUREARRAY | NPY_ARRAY_CARRAY_RO,
-        NULL
-    );
-    if (!data)
-        return NULL;
+/**
+ * Add the next sample of a row to a monotonic queue for the moving max or min. Samples that are
+ * not in a window with the new sample, and samples that can no longer be the extreme value, are
+ * dropped, so the oldest value is always the extreme of the current window.
+ *
+ * @param val    Queue values, `cap` long
+ * @param idx    Position in the series of the queue values
+ * @param head   Oldest value in the queue
+ * @param len    Number of values in the queue
+ * @param cap    Capacity of the queue, the window length
+ * @param v      Sample to add
+ * @param g      Position of the sample in the series
+ * @param is_max Computing the moving max (1) or min (0)
+ */
+static void movstream_push_extreme(double *val, long *idx, long *head, long *len, long cap,
+    double v, long g, int is_max)
+{
+    long k;
 
-    // get the number of dimensions, and the shape
-    int ndim = PyArray_NDIM(data);
-    npy_intp *ddims = PyArray_DIMS(data);
-    npy_intp *rdims = (npy_intp *)malloc(ndim * sizeof(ddims));
-    long npts = ddims[ndim - 1];
-    long trim_pts = (npts - wlen) / skip + 1;
-    if (!rdims)
+    while ((*len > 0) && (idx[*head] <= g - cap))
     {
-        Py_XDECREF(data);
-        return NULL;
+        *head = (*head + 1) % cap;
+        (*len)--;
     }
-    // create return shape
-    for (int i = 0; i < (ndim - 1); ++i)
+    while (*len > 0)
     {
-        rdims[i] = ddims[i];
+        k = (*head + *len - 1) % cap;
+        if (is_max ? (val[k] > v) : (val[k] < v))
+            break;
+        (*len)--;
     }
-    // dimension of the roll
-    if (trim)
+    k = (*head + *len) % cap;
+    val[k] = v;
+    idx[k] = g;
+    (*len)++;
+}
+
+/**
+ * Compute the windows completed by the next samples of a single row, updating the row's kernel
+ * state. Only the new samples are passed through the kernels.
+ *
+ * @param s   Stream state. The position in the series is not updated, see `movstream_advance`
+ * @param row Row number
+ * @param x   Next samples of the row
+ * @param n   Number of samples in `x`
+ * @param r   Results for each statistic, all of at least the number of windows completed
+ */
+static void movstream_row(MovStat_Stream_t *s, long row, double *x, long n, double *r[MOVSTAT_N])
+{
+    long g, j;
+
+    if (s->morder > 0)
+        moving_moments_stream(&n, x, &s->wlen, &s->skip, &s->morder, &s->cnt, &s->nq, &s->qhead,
+            &s->qlen, s->m + 4 * row, s->q + 4 * s->nq * row, r[MOVSTAT_MEAN], r[MOVSTAT_SD],
+            r[MOVSTAT_SKEW], r[MOVSTAT_KURT]);
+
+    if (s->needed & MOVSTAT_BIT(MOVSTAT_MEDIAN))
     {
-        rdims[ndim - 1] = trim_pts;
-    } else {
-        rdims[ndim - 1] = (npts - 1) / skip + 1;
+        double *fill = s->fill + s->wlen * row;
+        long nfill = s->nfill;
+        int live = s->heap_live;
+
+        j = 0;
+        for (long k = 0; k < n; ++k)
+        {
+            g = s->cnt + k;
+            if (movstream_in_window(s, g))
+            {
+                if (live)
+                    fmedian_stream_insert(s->heap[row], &x[k]);
+                else
+                {
+                    // a new window without any overlap. Build the heap once it is full
+                    fill[nfill++] = x[k];
+                    if (nfill == s->wlen)
+                    {
+                        fmedian_stream_init(s->heap[row], fill);
+                        live = 1;
+                        nfill = 0;
+                    }
+                }
+            }
+            if (movstream_window_end(s, g))
+            {
+                r[MOVSTAT_MEDIAN][j++] = fmedian_stream_get(s->heap[row]);
+                live = s->skip < s->wlen;
+            }
+        }
     }
 
-    PyArrayObject *rsd   = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    PyArrayObject *rmean = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
+    for (int e = 0; e < 2; ++e)
+    {
+        MovStat_t stat = e == 0 ? MOVSTAT_MAX : MOVSTAT_MIN;
+        if (!(s->needed & MOVSTAT_BIT(stat)))
+            continue;
+
+        double *val = s->ext_val[e] + s->wlen * row;
+        long *idx = s->ext_idx[e] + s->wlen * row;
+        long *head = s->ext_head[e] + row;
+        long *len = s->ext_len[e] + row;
+
+        j = 0;
+        for (long k = 0; k < n; ++k)
+        {
+            g = s->cnt + k;
+            if (movstream_in_window(s, g))
+                movstream_push_extreme(val, idx, head, len, s->wlen, x[k], g, e == 0);
+            if (movstream_window_end(s, g))
+            {
+                r[stat][j++] = val[*head];
+                if (s->skip >= s->wlen)
+                    *len = 0;
+            }
+        }
+    }
 
-    if ((!rmean) || (!rsd))
+    if (s->needed & MOVSTAT_BIT(MOVSTAT_RANGE))
     {
-        free(rdims);  /* make sure it gets freed */
-        Py_XDECREF(data);
-        Py_XDECREF(rmean);
-        Py_XDECREF(rsd);
-        return NULL;
+        long nres = s->cnt + n >= s->wlen ? (s->cnt + n - s->wlen) / s->skip + 1 - s->nwin : 0;
+        for (j = 0; j < nres; ++j)
+            r[MOVSTAT_RANGE][j] = r[MOVSTAT_MAX][j] - r[MOVSTAT_MIN][j];
     }
+}
 
-    // data pointers
-    double *dptr      = (double *)PyArray_DATA(data);
-    double *rmean_ptr = (double *)PyArray_DATA(rmean);
-    double *rsd_ptr   = (double *)PyArray_DATA(rsd);
-    // for iterating over the data
-    long stride = ddims[ndim-1];  // stride to get to the next computation "column"
-    long res_stride = rdims[ndim-1];  // stride to get to the next results "column"
-    int nrepeats = PyArray_SIZE(data) / stride;  // number of repetitions to cover all the data
-    // has to be freed down here since its used by res_stride
-    free(rdims);
+/**
+ * Move the position in the series past the next `n` samples, after every row has been computed.
+ * Follows the same window bookkeeping as the kernels in `movstream_row`.
+ *
+ * @param s Stream state
+ * @param n Number of new samples
+ */
+static void movstream_advance(MovStat_Stream_t *s, long n)
+{
+    long g;
 
-    for (int i = 0; i < nrepeats; ++i)
+    for (long k = 0; k < n; ++k)
     {
-        for (int j = trim_pts; j < res_stride; ++j)
+        g = s->cnt + k;
+        if (movstream_in_window(s, g) && !s->heap_live && (++s->nfill == s->wlen))
         {
-            rmean_ptr[j] = NPY_NAN;
+            s->heap_live = 1;
+            s->nfill = 0;
         }
-        for (int j = trim_pts; j < res_stride; ++j)
+        if (movstream_window_end(s, g))
         {
-            rsd_ptr[j] = NPY_NAN;
+            // the first window starts at the start of the series, and is not in the queue
+            if (g + 1 > s->wlen)
+            {
+                s->qhead = (s->qhead + 1) % s->nq;
+                s->qlen--;
+            }
+            s->heap_live = s->skip < s->wlen;
+            s->nwin++;
         }
-        mov_moments_2(&stride, dptr, &wlen, &skip, rmean_ptr, rsd_ptr);
-        dptr += stride;
-        rmean_ptr += res_stride;
-        rsd_ptr += res_stride;
+        if (((g + 1) % s->skip) == 0)
+            s->qlen++;
     }
-    
-    Py_XDECREF(data);
+    s->cnt += n;
+}
+
+/**
+ * Compute the windows completed by the next chunk of a series, for a contiguous range of rows.
+ * Run by each of the worker threads. Each row only touches its own kernel state.
+ *
+ * @param arg Pointer to the MovStat_Thread_t work definition for this thread
+ */
+static void *movstream_rows(void *arg)
+{
+    MovStat_Thread_t *t = (MovStat_Thread_t *)arg;
+    int x_contig = t->x_stride == (npy_intp)sizeof(double);
+    long len = t->res_len > 0 ? t->res_len : 1;
+    double *r[MOVSTAT_N];
+    double *xbuf = NULL, *rbuf = NULL, *x;
+    npy_intp x_off, res_off;
+
+    t->status = 0;
+    if (t->start >= t->stop)
+        return NULL;
 
-    if (return_others)
+    if (!x_contig)
+        xbuf = (double *)malloc(t->npts * sizeof(double));
+    // the kernels always write every moment up to the highest, so results go to scratch rows
+    rbuf = (double *)malloc(MOVSTAT_N * len * sizeof(double));
+    if ((!x_contig && !xbuf) || !rbuf)
     {
-        return Py_BuildValue(
-            "NN",  /* dont want to increase ref count */
-            (PyObject *)rsd,
-            (PyObject *)rmean
-        );
+        free(xbuf);
+        free(rbuf);
+        t->status = -1;
+        return NULL;
     }
-    else
+    for (int s = 0; s < MOVSTAT_N; ++s)
+        r[s] = rbuf + s * len;
+
+    for (long i = t->start; i < t->stop; ++i)
     {
-        Py_XDECREF(rmean);
-        return (PyObject *)rsd;
+        movstat_row_offsets(t, i, &x_off, &res_off);
+
+        if (x_contig)
+            x = (double *)(t->x + x_off);
+        else
+        {
+            for (long j = 0; j < t->npts; ++j)
+                xbuf[j] = *(double *)(t->x + x_off + j * t->x_stride);
+            x = xbuf;
+        }
+
+        movstream_row(t->stream, i, x, t->npts, r);
+
+        for (int s = 0; s < MOVSTAT_N; ++s)
+        {
+            if (!(t->stats & MOVSTAT_BIT(s)))
+                continue;
+            for (long j = 0; j < t->res_len; ++j)
+                t->res[s][res_off + j * t->res_stride] = r[s][j];
+        }
     }
+
+    free(xbuf);
+    free(rbuf);
+
+    return NULL;
 }
 
+/**
+ * Compute the moving statistics for all the rows, split across `workers` threads. All the kernels
+ * only use per-call or per-row storage, so no locking is required. Must not touch any Python
+ * objects, as this is called with the GIL released.
+ *
+ * @param base    Work definition for all the rows. `start` and `stop` are set per thread
+ * @param nrows   Number of rows to compute
+ * @param workers Number of threads to use
+ * @param rows    Function computing a range of rows, `movstat_rows` or `movstream_rows`
+ *
+ * @result 0 if successful, -1 if scratch storage could not be allocated
+ */
+static int movstat_run(const MovStat_Thread_t *base, long nrows, int workers, void *(*rows)(void *))
+{
+    int ierr = 0;
 
-PyObject * moving_skewness(PyObject *NPY_UNUSED(self), PyObject *args){
-    PyObject *x_;
-    long wlen, skip;
-    int trim, return_others;
+    if (workers > nrows)
+        workers = (int)nrows;
+    if (workers < 1)
+        workers = 1;
 
-    if (!PyArg_ParseTuple(args, "Ollpp:moving_skewness", &x_, &wlen, &skip, &trim, &return_others))
-        return NULL;
+    MovStat_Thread_t *work = (MovStat_Thread_t *)malloc(workers * sizeof(MovStat_Thread_t));
+    pthread_t *threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    int *started = (int *)calloc(workers, sizeof(int));
+
+    if ((workers == 1) || !work || !threads || !started)
+    {
+        // run everything on the calling thread
+        MovStat_Thread_t all = *base;
+        all.start = 0;
+        all.stop = nrows;
+        rows(&all);
+
+        free(work); free(threads); free(started);
+        return all.status;
+    }
+
+    long chunk = (nrows + workers - 1) / workers;
 
+    for (int k = 0; k < workers; ++k)
+    {
+        work[k] = *base;
+        work[k].start = k * chunk < nrows ? k * chunk : nrows;
+        work[k].stop = (k + 1) * chunk < nrows ? (k + 1) * chunk : nrows;
+
+        /* if a thread cannot be started, compute its rows after the others are started */
+        started[k] = pthread_create(&threads[k], NULL, rows, &work[k]) == 0;
+    }
+
+    for (int k = 0; k < workers; ++k)
+    {
+        if (started[k])
+            pthread_join(threads[k], NULL);
+        else
+            rows(&work[k]);
+
+        if (work[k].status != 0)
+            ierr = work[k].status;
+    }
+
+    free(work);
+    free(threads);
+    free(started);
+
+    return ierr;
+}
+
+/**
+ * Compute moving statistics along any axis of an array, without moving the axis or making
+ * a contiguous copy of the input. The results have the same layout as the input, with the
+ * moving axis shortened to the number of windows.
+ *
+ * @param x_        Input data, converted to double if necessary
+ * @param order     Statistics to return, in the order to return them. Must not repeat
+ * @param nout      Number of statistics in `order`
+ * @param wlen      Window length in samples
+ * @param skip      Samples between window starts
+ * @param trim      Trim the windows that cannot be computed, instead of filling with NaN
+ * @param as_tuple  Return a tuple of the results, even if there is only one
+ * @param workers   Number of threads to split the rows across
+ * @param axis      Moving axis. Negative values count from the last axis
+ *
+ * @result The result, or a tuple of the results in `order`
+ */
+static PyObject *movstat_compute(PyObject *x_, const MovStat_t *order, int nout, long wlen,
+    long skip, int trim, int as_tuple, int workers, int axis)
+{
     PyArrayObject *data = (PyArrayObject *)PyArray_FromAny(
         x_,
         PyArray_DescrFromType(NPY_DOUBLE),
         1,
         0,
-        NPY_ARRAY_ENSUREARRAY | NPY_ARRAY_CARRAY_RO,
+        NPY_ARRAY_ALIGNED,
         NULL
     );
     if (!data)
@@ -220,197 +601,182 @@ PyObject * moving_skewness(PyObject *NPY_UNUSED(self), PyObject *args){
 
     // get the number of dimensions, and the shape
     int ndim = PyArray_NDIM(data);
-    npy_intp *ddims = PyArray_DIMS(data);
-    npy_intp *rdims = (npy_intp *)malloc(ndim * sizeof(ddims));
-    long npts = ddims[ndim - 1];
-    long trim_pts = (npts - wlen) / skip + 1;
-    if (!rdims)
+    const npy_intp *ddims = PyArray_DIMS(data);
+    const npy_intp *dstrides = PyArray_STRIDES(data);
+
+    if (axis < 0)
+        axis += ndim;
+    if ((axis < 0) || (axis >= ndim))
+    {
+        PyErr_SetString(PyExc_ValueError, "`axis` is out of bounds for the input array.");
+        Py_XDECREF(data);
+        return NULL;
+    }
+
+    long npts = ddims[axis];
+    if ((wlen <= 0) || (skip <= 0))
+    {
+        PyErr_SetString(PyExc_ValueError, "`wlen` and `skip` cannot be less than or equal to 0.");
+        Py_XDECREF(data);
+        return NULL;
+    }
+    if (wlen > npts)
     {
+        PyErr_SetString(PyExc_ValueError, "Window length is larger than the computation axis.");
         Py_XDECREF(data);
         return NULL;
     }
+    long trim_pts = (npts - wlen) / skip + 1;
+
+    npy_intp rdims[NPY_MAXDIMS];
     // create return shape
-    for (int i = 0; i < (ndim - 1); ++i)
+    for (int i = 0; i < ndim; ++i)
     {
         rdims[i] = ddims[i];
     }
     // dimension of the roll
     if (trim)
     {
-        rdims[ndim - 1] = trim_pts;
+        rdims[axis] = trim_pts;
     } else {
-        rdims[ndim - 1] = (npts - 1) / skip + 1;
+        rdims[axis] = (npts - 1) / skip + 1;
     }
 
-    PyArrayObject *rsd   = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    PyArrayObject *rmean = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    PyArrayObject *rskew = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
+    PyArrayObject *res[MOVSTAT_N] = {NULL};
+    int fail = 0;
+    for (int k = 0; k < nout; ++k)
+    {
+        res[k] = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
+        fail |= (res[k] == NULL);
+    }
 
-    if ((!rmean) || (!rsd) || (!rskew))
+    if (fail)
     {
-        free(rdims);  /* make sure it gets freed */
         Py_XDECREF(data);
-        Py_XDECREF(rskew);
-        Py_XDECREF(rsd);
-        Py_XDECREF(rmean);
+        for (int k = 0; k < nout; ++k)
+            Py_XDECREF(res[k]);
         return NULL;
     }
 
-    // data pointers
-    double *dptr      = (double *)PyArray_DATA(data);
-    double *rmean_ptr = (double *)PyArray_DATA(rmean);
-    double *rsd_ptr   = (double *)PyArray_DATA(rsd);
-    double *rskew_ptr = (double *)PyArray_DATA(rskew);
-    // for iterating over the data
-    long stride = ddims[ndim-1];  // stride to get to the next computation "column"
-    long res_stride = rdims[ndim-1];  // stride to get to the next results "column"
-    int nrepeats = PyArray_SIZE(data) / stride;  // number of repetitions to cover all the data
-    // has to be freed down here since its used by res_stride
-    free(rdims);
+    // all results have the same (C-contiguous) strides
+    const npy_intp *rstrides = PyArray_STRIDES(res[0]);
+
+    MovStat_Thread_t work = {
+        .stats = 0,
+        .x = (char *)PyArray_DATA(data),
+        .npts = npts,
+        .wlen = wlen,
+        .skip = skip,
+        .trim_pts = trim_pts,
+        .res_len = rdims[axis],
+        .x_stride = dstrides[axis],
+        .res_stride = rstrides[axis] / (npy_intp)sizeof(double),
+        .row_ndim = 0,
+    };
+    long nrows = 1;
+
+    for (int k = 0; k < nout; ++k)
+    {
+        work.stats |= MOVSTAT_BIT(order[k]);
+        work.res[order[k]] = (double *)PyArray_DATA(res[k]);
+    }
 
-    for (int i = 0; i < nrepeats; ++i)
+    for (int i = 0; i < ndim; ++i)
     {
-        // splitting up so we are accessing contiguous memory each time
-        for (int j = trim_pts; j < res_stride; ++j)
-        {
-            rmean_ptr[j] = NPY_NAN;
-            rsd_ptr[j] = NPY_NAN;
-            rskew_ptr[j] = NPY_NAN;
-        }
-        moving_moments_3(&stride, dptr, &wlen, &skip, rmean_ptr, rsd_ptr, rskew_ptr);
-        dptr += stride;
-        rmean_ptr += res_stride;
-        rsd_ptr += res_stride;
-        rskew_ptr += res_stride;
+        if (i == axis)
+            continue;
+        work.row_dims[work.row_ndim] = ddims[i];
+        work.x_row_strides[work.row_ndim] = dstrides[i];
+        work.res_row_strides[work.row_ndim] = rstrides[i] / (npy_intp)sizeof(double);
+        work.row_ndim++;
+        nrows *= ddims[i];
     }
-    
+
+    int ierr;
+    // the kernels dont touch any Python objects, so other threads can run
+    Py_BEGIN_ALLOW_THREADS
+    ierr = movstat_run(&work, nrows, workers, movstat_rows);
+    Py_END_ALLOW_THREADS
+
     Py_XDECREF(data);
 
-    if (return_others)
+    if (ierr != 0)
     {
-        return Py_BuildValue(
-            "NNN",  /* dont want to increase ref count */
-            (PyObject *)rskew,
-            (PyObject *)rsd,
-            (PyObject *)rmean
-        );
+        for (int k = 0; k < nout; ++k)
+            Py_XDECREF(res[k]);
+        return PyErr_NoMemory();
     }
-    else
+
+    if ((nout == 1) && !as_tuple)
+        return (PyObject *)res[0];
+
+    PyObject *out = PyTuple_New(nout);
+    if (!out)
     {
-        Py_XDECREF(rmean);
-        Py_XDECREF(rsd);
-        return (PyObject *)rskew;
+        for (int k = 0; k < nout; ++k)
+            Py_XDECREF(res[k]);
+        return NULL;
     }
+    for (int k = 0; k < nout; ++k)
+        PyTuple_SET_ITEM(out, k, (PyObject *)res[k]);  /* steals the reference */
+
+    return out;
 }
 
 
-PyObject * moving_kurtosis(PyObject *NPY_UNUSED(self), PyObject *args){
+PyObject * moving_mean(PyObject *NPY_UNUSED(self), PyObject *args){
     PyObject *x_;
     long wlen, skip;
-    int trim, return_others;
+    int trim;
+    int workers = 1, axis = -1;
 
-    if (!PyArg_ParseTuple(args, "Ollpp:moving_kurtosis", &x_, &wlen, &skip, &trim, &return_others))
+    if (!PyArg_ParseTuple(args, "Ollp|ii:moving_mean", &x_, &wlen, &skip, &trim, &workers, &axis))
         return NULL;
 
-    PyArrayObject *data = (PyArrayObject *)PyArray_FromAny(
-        x_,
-        PyArray_DescrFromType(NPY_DOUBLE),
-        1,
-        0,
-        NPY_ARRAY_ENSUREARRAY | NPY_ARRAY_CARRAY_RO,
-        NULL
-    );
-    if (!data) return NULL;
+    const MovStat_t order[] = {MOVSTAT_MEAN};
+    return movstat_compute(x_, order, 1, wlen, skip, trim, 0, workers, axis);
+}
 
-    // get the number of dimensions, and the shape
-    int ndim = PyArray_NDIM(data);
-    npy_intp *ddims = PyArray_DIMS(data);
-    npy_intp *rdims = (npy_intp *)malloc(ndim * sizeof(ddims));
-    long npts = ddims[ndim - 1];
-    long trim_pts = (npts - wlen) / skip + 1;
-    if (!rdims)
-    {
-        Py_XDECREF(data);
+
+PyObject * moving_sd(PyObject *NPY_UNUSED(self), PyObject *args){
+    PyObject *x_;
+    long wlen, skip;
+    int trim, return_others;
+    int workers = 1, axis = -1;
+
+    if (!PyArg_ParseTuple(args, "Ollpp|ii:moving_sd", &x_, &wlen, &skip, &trim, &return_others, &workers, &axis))
         return NULL;
-    }
-    // create return shape
-    for (int i = 0; i < (ndim - 1); ++i)
-    {
-        rdims[i] = ddims[i];
-    }
-    // dimension of the roll
-    if (trim)
-    {
-        rdims[ndim - 1] = trim_pts;
-    } else {
-        rdims[ndim - 1] = (npts - 1) / skip + 1;
-    }
 
-    PyArrayObject *rsd   = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    PyArrayObject *rmean = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    PyArrayObject *rskew = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    PyArrayObject *rkurt = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
+    const MovStat_t order[] = {MOVSTAT_SD, MOVSTAT_MEAN};
+    return movstat_compute(x_, order, return_others ? 2 : 1, wlen, skip, trim, 0, workers, axis);
+}
 
-    if (!rmean || !rsd || !rskew || !rkurt)
-    {
-        free(rdims);  /* make sure it gets freed */
-        Py_XDECREF(data);
-        Py_XDECREF(rkurt);
-        Py_XDECREF(rskew);
-        Py_XDECREF(rsd);
-        Py_XDECREF(rmean);
+
+PyObject * moving_skewness(PyObject *NPY_UNUSED(self), PyObject *args){
+    PyObject *x_;
+    long wlen, skip;
+    int trim, return_others;
+    int workers = 1, axis = -1;
+
+    if (!PyArg_ParseTuple(args, "Ollpp|ii:moving_skewness", &x_, &wlen, &skip, &trim, &return_others, &workers, &axis))
         return NULL;
-    }
 
-    // data pointers
-    double *dptr      = (double *)PyArray_DATA(data);
-    double *rmean_ptr = (double *)PyArray_DATA(rmean);
-    double *rsd_ptr   = (double *)PyArray_DATA(rsd);
-    double *rskew_ptr = (double *)PyArray_DATA(rskew);
-    double *rkurt_ptr = (double *)PyArray_DATA(rkurt);
-    // for iterating over the data
-    long stride = ddims[ndim-1];  // stride to get to the next computation "column"
-    long res_stride = rdims[ndim-1];  // stride to get to the next results "column"
-    int nrepeats = PyArray_SIZE(data) / stride;  // number of repetitions to cover all the data
-    // has to be freed down here since its used by res_stride
-    free(rdims);
+    const MovStat_t order[] = {MOVSTAT_SKEW, MOVSTAT_SD, MOVSTAT_MEAN};
+    return movstat_compute(x_, order, return_others ? 3 : 1, wlen, skip, trim, 0, workers, axis);
+}
 
-    for (int i = 0; i < nrepeats; ++i)
-    {
-        for (int j = trim_pts; j < res_stride; ++j)
-        {
-            rmean_ptr[j] = NPY_NAN;
-            rsd_ptr[j] = NPY_NAN;
-            rskew_ptr[j] = NPY_NAN;
-            rkurt_ptr[j] = NPY_NAN;
-        }
-        moving_moments_4(&stride, dptr, &wlen, &skip, rmean_ptr, rsd_ptr, rskew_ptr, rkurt_ptr);
-        dptr += stride;
-        rmean_ptr += res_stride;
-        rsd_ptr += res_stride;
-        rskew_ptr += res_stride;
-        rkurt_ptr += res_stride;
-    }
-    
-    Py_XDECREF(data);
 
-    if (return_others)
-    {
-        return Py_BuildValue(
-            "NNNN",  /* dont want to increase ref count */
-            (PyObject *)rkurt,
-            (PyObject *)rskew,
-            (PyObject *)rsd,
-            (PyObject *)rmean
-        );
-    }
-    else
-    {
-        Py_XDECREF(rmean);
-        Py_XDECREF(rsd);
-        Py_XDECREF(rskew);
-        return (PyObject *)rkurt;
-    }
+PyObject * moving_kurtosis(PyObject *NPY_UNUSED(self), PyObject *args){
+    PyObject *x_;
+    long wlen, skip;
+    int trim, return_others;
+    int workers = 1, axis = -1;
+
+    if (!PyArg_ParseTuple(args, "Ollpp|ii:moving_kurtosis", &x_, &wlen, &skip, &trim, &return_others, &workers, &axis))
+        return NULL;
+
+    const MovStat_t order[] = {MOVSTAT_KURT, MOVSTAT_SKEW, MOVSTAT_SD, MOVSTAT_MEAN};
+    return movstat_compute(x_, order, return_others ? 4 : 1, wlen, skip, trim, 0, workers, axis);
 }
 
 
@@ -419,227 +785,401 @@ PyObject * moving_median(PyObject *NPY_UNUSED(self), PyObject *args)
     PyObject *x_;
     long wlen, skip;
     int trim;
+    int workers = 1, axis = -1;
 
-    if (!PyArg_ParseTuple(args, "Ollp:moving_median", &x_, &wlen, &skip, &trim)) return NULL;
+    if (!PyArg_ParseTuple(args, "Ollp|ii:moving_median", &x_, &wlen, &skip, &trim, &workers, &axis)) return NULL;
 
-    PyArrayObject *data = (PyArrayObject *)PyArray_FromAny(
-      x_,
-      PyArray_DescrFromType(NPY_DOUBLE),
-      1,
-      0,
-      NPY_ARRAY_ENSUREARRAY | NPY_ARRAY_CARRAY_RO,
-      NULL
-    );
-    if (!data) return NULL;
+    const MovStat_t order[] = {MOVSTAT_MEDIAN};
+    return movstat_compute(x_, order, 1, wlen, skip, trim, 0, workers, axis);
+}
 
-    // get the number of dimensions and the shape
-    int ndim = PyArray_NDIM(data);
-    const npy_intp *ddims = PyArray_DIMS(data);
-    npy_intp *rdims = (npy_intp *)malloc(ndim * sizeof(npy_intp));
-    long npts = ddims[ndim - 1];
-    long trim_pts = (npts - wlen) / skip + 1;
 
-    // create the return shape
-    for (int i = 0; i < (ndim - 1); ++i)
-    {
-        rdims[i] = ddims[i];
-    }
-    // dimension of the roll
-    if (trim)
-    {
-        rdims[ndim - 1] = trim_pts;
-    } else {
-        rdims[ndim - 1] = (npts - 1) / skip + 1;
-    }
+PyObject * moving_max(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    PyObject *x_;
+    long wlen, skip;
+    int trim;
+    int workers = 1, axis = -1;
 
-    // allocate the return
-    PyArrayObject *rmed = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    free(rdims);  // free the return dimensions array
-    if (!rmed)
-    {
-        Py_XDECREF(data);
-        Py_XDECREF(rmed);
+    if (!PyArg_ParseTuple(args, "Ollp|ii:moving_max", &x_, &wlen, &skip, &trim, &workers, &axis))
         return NULL;
-    }
 
-    // data pointers
-    double *dptr = (double *)PyArray_DATA(data);
-    double *rptr = (double *)PyArray_DATA(rmed);
-    // for iterating over the data
-    long res_stride = PyArray_DIM(rmed, ndim - 1);  // stride to get to the next results column
-    int nrepeats = PyArray_SIZE(data) / npts;  // number of "columns"
+    const MovStat_t order[] = {MOVSTAT_MAX};
+    return movstat_compute(x_, order, 1, wlen, skip, trim, 0, workers, axis);
+}
+
 
-    // iterate
-    for (int i = 0; i < nrepeats; ++i)
+PyObject * moving_min(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    PyObject *x_;
+    long wlen, skip;
+    int trim;
+    int workers = 1, axis = -1;
+
+    if (!PyArg_ParseTuple(args, "Ollp|ii:moving_min", &x_, &wlen, &skip, &trim, &workers, &axis))
+        return NULL;
+
+    const MovStat_t order[] = {MOVSTAT_MIN};
+    return movstat_compute(x_, order, 1, wlen, skip, trim, 0, workers, axis);
+}
+
+
+/**
+ * Get the statistics from a sequence of statistic names.
+ *
+ * @param stats_ Sequence of the names of the statistics
+ * @param order  Statistics, in the order of `stats_`. Must have space for MOVSTAT_N
+ * @param nout   Number of statistics
+ *
+ * @result 0 if successful, -1 with an exception set if the names are not valid
+ */
+static int movstat_parse_stats(PyObject *stats_, MovStat_t *order, int *nout)
+{
+    PyObject *seq, *item;
+    unsigned int seen = 0;
+    int s;
+
+    seq = PySequence_Fast(stats_, "`stats` must be a sequence of statistic names.");
+    if (!seq)
+        return -1;
+
+    *nout = (int)PySequence_Fast_GET_SIZE(seq);
+    if ((*nout < 1) || (*nout > MOVSTAT_N))
     {
-        for (int j = trim_pts; j < res_stride; ++j)
+        PyErr_SetString(PyExc_ValueError, "`stats` must contain between 1 and 8 unique statistics.");
+        Py_DECREF(seq);
+        return -1;
+    }
+
+    for (int k = 0; k < *nout; ++k)
+    {
+        item = PySequence_Fast_GET_ITEM(seq, k);  /* borrowed */
+        const char *name = PyUnicode_Check(item) ? PyUnicode_AsUTF8(item) : NULL;
+
+        for (s = 0; name && (s < MOVSTAT_N); ++s)
+        {
+            if (strcmp(name, movstat_names[s]) == 0)
+                break;
+        }
+        if (!name || (s == MOVSTAT_N) || (seen & MOVSTAT_BIT(s)))
         {
-            rptr[j] = NPY_NAN;
+            PyErr_Clear();
+            PyErr_Format(PyExc_ValueError, "Statistic %R is not valid, or is repeated.", item);
+            Py_DECREF(seq);
+            return -1;
         }
-        fmoving_median(&npts, dptr, &wlen, &skip, rptr);
-        dptr += npts;  // increment by number of points in the last dimension
-        rptr += res_stride;
+        seen |= MOVSTAT_BIT(s);
+        order[k] = (MovStat_t)s;
     }
+    Py_DECREF(seq);
 
-    Py_XDECREF(data);
-
-    return (PyObject *)rmed;
+    return 0;
 }
 
 
-PyObject * moving_max(PyObject *NPY_UNUSED(self), PyObject *args)
+PyObject * moving_stats(PyObject *NPY_UNUSED(self), PyObject *args)
 {
-    PyObject *x_;
+    PyObject *x_, *stats_;
     long wlen, skip;
     int trim;
+    int workers = 1, axis = -1;
+    MovStat_t order[MOVSTAT_N];
+    int nout;
 
-    if (!PyArg_ParseTuple(args, "Ollp:moving_max", &x_, &wlen, &skip, &trim))
+    if (!PyArg_ParseTuple(args, "OllpO|ii:moving_stats", &x_, &wlen, &skip, &trim, &stats_, &workers, &axis))
         return NULL;
 
-    PyArrayObject *data = (PyArrayObject *)PyArray_FromAny(
-        x_,
-        PyArray_DescrFromType(NPY_DOUBLE),
-        1,
-        0,
-        NPY_ARRAY_ENSUREARRAY | NPY_ARRAY_CARRAY_RO,
-        NULL
-    );
-    if (!data)
+    if (movstat_parse_stats(stats_, order, &nout) != 0)
         return NULL;
 
-    // get the number of dimensions, and the shape
-    int ndim = PyArray_NDIM(data);
-    const npy_intp *ddims = PyArray_DIMS(data);
-    long npts = ddims[ndim - 1];
-    long trim_pts = (npts - wlen) / skip + 1;
-    npy_intp *rdims = (npy_intp *)malloc(ndim * sizeof(npy_intp));
-    if (!rdims)
+    return movstat_compute(x_, order, nout, wlen, skip, trim, 1, workers, axis);
+}
+
+
+/* free a stream state, and all of its kernel state. Also the capsule destructor */
+static void movstream_free(MovStat_Stream_t *st)
+{
+    if (!st)
+        return;
+
+    if (st->heap)
     {
-        Py_XDECREF(data);
-        return NULL;
+        for (long i = 0; i < st->nrows; ++i)
+        {
+            if (st->heap[i])
+                fmedian_stream_free(st->heap[i]);
+        }
     }
-    // create return shape
-    for (int i = 0; i < (ndim - 1); ++i)
+    free(st->heap);
+    free(st->fill);
+    free(st->m);
+    free(st->q);
+    for (int e = 0; e < 2; ++e)
     {
-        rdims[i] = ddims[i];
+        free(st->ext_val[e]);
+        free(st->ext_idx[e]);
+        free(st->ext_head[e]);
+        free(st->ext_len[e]);
     }
-    // dimension of the roll
-    if (trim)
+    free(st);
+}
+
+static void movstream_destructor(PyObject *capsule)
+{
+    movstream_free((MovStat_Stream_t *)PyCapsule_GetPointer(capsule, MOVSTAT_STREAM_NAME));
+}
+
+
+PyObject * moving_stats_stream(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    PyObject *stats_, *capsule;
+    long wlen, skip, nrows;
+    MovStat_Stream_t *st;
+    int fail = 0;
+
+    if (!PyArg_ParseTuple(args, "llOl:moving_stats_stream", &wlen, &skip, &stats_, &nrows))
+        return NULL;
+
+    if ((wlen <= 0) || (skip <= 0))
     {
-        rdims[ndim - 1] = trim_pts;
-    } else {
-        rdims[ndim - 1] = (npts - 1) / skip + 1;
+        PyErr_SetString(PyExc_ValueError, "`wlen` and `skip` cannot be less than or equal to 0.");
+        return NULL;
+    }
+    if (nrows < 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "`nrows` cannot be negative.");
+        return NULL;
     }
 
-    PyArrayObject *rmax = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    free(rdims);
+    st = (MovStat_Stream_t *)calloc(1, sizeof(MovStat_Stream_t));
+    if (!st)
+        return PyErr_NoMemory();
 
-    if (!rmax)
+    if (movstat_parse_stats(stats_, st->order, &st->nout) != 0)
     {
-        Py_XDECREF(data);
-        Py_XDECREF(rmax);
+        free(st);
         return NULL;
     }
+    for (int k = 0; k < st->nout; ++k)
+        st->stats |= MOVSTAT_BIT(st->order[k]);
+    st->needed = movstat_needed(st->stats);
 
-    // data pointers
-    double *dptr = (double *)PyArray_DATA(data);
-    double *rmax_ptr = (double *)PyArray_DATA(rmax);
-    // for iterating over the data
-    long res_stride = PyArray_DIM(rmax, ndim - 1);  // stride to get to the next results column
-    int nrepeats = PyArray_SIZE(data) / npts;  // # of repetitions to cover all the data
+    st->wlen = wlen;
+    st->skip = skip;
+    st->nrows = nrows;
+    // at most one window start per `skip` samples is waiting for its window to end
+    st->nq = wlen / skip + 1;
 
-    for (int i = 0; i < nrepeats; ++i)
+    for (int s = MOVSTAT_KURT; s >= MOVSTAT_MEAN; --s)
     {
-        for (int j = trim_pts; j < res_stride; ++j)
+        if (st->needed & MOVSTAT_BIT(s))
         {
-            rmax_ptr[j] = NPY_NAN;
+            st->morder = s - MOVSTAT_MEAN + 1;
+            break;
         }
-        moving_max_c(&npts, dptr, &wlen, &skip, rmax_ptr);
-        dptr += npts; // increment by number of points in last dimension
-        rmax_ptr += res_stride;
     }
 
-    Py_XDECREF(data);
+    // dont allocate 0 bytes if there are no rows
+    long nalloc = nrows > 0 ? nrows : 1;
 
-    return (PyObject *)rmax;
-}
+    if (st->morder > 0)
+    {
+        st->m = (double *)calloc(4 * nalloc, sizeof(double));
+        st->q = (double *)calloc(4 * st->nq * nalloc, sizeof(double));
+        fail |= !st->m || !st->q;
+    }
+    if (st->needed & MOVSTAT_BIT(MOVSTAT_MEDIAN))
+    {
+        st->fill = (double *)malloc(wlen * nalloc * sizeof(double));
+        st->heap = (void **)calloc(nalloc, sizeof(void *));
+        fail |= !st->fill || !st->heap;
+        for (long i = 0; !fail && (i < nrows); ++i)
+            st->heap[i] = fmedian_stream_new(&wlen);
+    }
+    for (int e = 0; e < 2; ++e)
+    {
+        if (!(st->needed & MOVSTAT_BIT(e == 0 ? MOVSTAT_MAX : MOVSTAT_MIN)))
+            continue;
+        st->ext_val[e] = (double *)malloc(wlen * nalloc * sizeof(double));
+        st->ext_idx[e] = (long *)malloc(wlen * nalloc * sizeof(long));
+        st->ext_head[e] = (long *)calloc(nalloc, sizeof(long));
+        st->ext_len[e] = (long *)calloc(nalloc, sizeof(long));
+        fail |= !st->ext_val[e] || !st->ext_idx[e] || !st->ext_head[e] || !st->ext_len[e];
+    }
 
+    if (fail)
+    {
+        movstream_free(st);
+        return PyErr_NoMemory();
+    }
 
-PyObject * moving_min(PyObject *NPY_UNUSED(self), PyObject *args)
-{
-    PyObject *x_;
-    long wlen, skip;
-    int trim;
+    capsule = PyCapsule_New(st, MOVSTAT_STREAM_NAME, movstream_destructor);
+    if (!capsule)
+        movstream_free(st);
+
+    return capsule;
+}
 
-    if (!PyArg_ParseTuple(args, "Ollp:moving_min", &x_, &wlen, &skip, &trim))
-        return NULL;
 
+/* add a chunk to a stream that is marked as busy, see `moving_stats_stream_update` */
+static PyObject *movstream_update(MovStat_Stream_t *st, PyObject *x_, int workers, int axis)
+{
     PyArrayObject *data = (PyArrayObject *)PyArray_FromAny(
         x_,
         PyArray_DescrFromType(NPY_DOUBLE),
         1,
         0,
-        NPY_ARRAY_ENSUREARRAY | NPY_ARRAY_CARRAY_RO,
+        NPY_ARRAY_ALIGNED,
         NULL
     );
     if (!data)
         return NULL;
 
-    // get the number of dimensions, and the shape
     int ndim = PyArray_NDIM(data);
     const npy_intp *ddims = PyArray_DIMS(data);
-    long npts = ddims[ndim - 1];
-    long trim_pts = (npts - wlen) / skip + 1;
-    npy_intp *rdims = (npy_intp *)malloc(ndim * sizeof(npy_intp));
-    if (!rdims)
+    const npy_intp *dstrides = PyArray_STRIDES(data);
+
+    if (axis < 0)
+        axis += ndim;
+    if ((axis < 0) || (axis >= ndim))
     {
+        PyErr_SetString(PyExc_ValueError, "`axis` is out of bounds for the input array.");
         Py_XDECREF(data);
         return NULL;
     }
-    // create return shape
-    for (int i = 0; i < (ndim - 1); ++i)
+
+    long npts = ddims[axis];
+    long nrows = 1;
+    for (int i = 0; i < ndim; ++i)
     {
-        rdims[i] = ddims[i];
+        if (i != axis)
+            nrows *= ddims[i];
     }
-    // dimension of the roll
-    if (trim)
+    if (nrows != st->nrows)
     {
-        rdims[ndim - 1] = trim_pts;
-    } else {
-        rdims[ndim - 1] = (npts - 1) / skip + 1;
+        PyErr_SetString(PyExc_ValueError, "Chunk does not have the same number of rows as the series.");
+        Py_XDECREF(data);
+        return NULL;
     }
 
-    PyArrayObject *rmin = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
-    free(rdims);
+    // windows completed by this chunk
+    long nres = st->cnt + npts >= st->wlen ? (st->cnt + npts - st->wlen) / st->skip + 1 - st->nwin : 0;
+
+    npy_intp rdims[NPY_MAXDIMS];
+    for (int i = 0; i < ndim; ++i)
+        rdims[i] = ddims[i];
+    rdims[axis] = nres;
 
-    if (!rmin)
+    PyArrayObject *res[MOVSTAT_N] = {NULL};
+    int fail = 0;
+    for (int k = 0; k < st->nout; ++k)
+    {
+        res[k] = (PyArrayObject *)PyArray_EMPTY(ndim, rdims, NPY_DOUBLE, 0);
+        fail |= (res[k] == NULL);
+    }
+    if (fail)
     {
         Py_XDECREF(data);
-        Py_XDECREF(rmin);
+        for (int k = 0; k < st->nout; ++k)
+            Py_XDECREF(res[k]);
         return NULL;
     }
 
-    // data pointers
-    double *dptr = (double *)PyArray_DATA(data);
-    double *rmin_ptr = (double *)PyArray_DATA(rmin);
-    // for iterating over the data
-    long res_stride = PyArray_DIM(rmin, ndim - 1);  // stride to get to the next results column
-    int nrepeats = PyArray_SIZE(data) / npts;  // # of repetitions to cover all the data
+    const npy_intp *rstrides = PyArray_STRIDES(res[0]);
+
+    MovStat_Thread_t work = {
+        .stats = st->stats,
+        .x = (char *)PyArray_DATA(data),
+        .npts = npts,
+        .wlen = st->wlen,
+        .skip = st->skip,
+        .trim_pts = nres,
+        .res_len = nres,
+        .x_stride = dstrides[axis],
+        .res_stride = rstrides[axis] / (npy_intp)sizeof(double),
+        .row_ndim = 0,
+        .stream = st,
+    };
+    for (int k = 0; k < st->nout; ++k)
+        work.res[st->order[k]] = (double *)PyArray_DATA(res[k]);
+
+    for (int i = 0; i < ndim; ++i)
+    {
+        if (i == axis)
+            continue;
+        work.row_dims[work.row_ndim] = ddims[i];
+        work.x_row_strides[work.row_ndim] = dstrides[i];
+        work.res_row_strides[work.row_ndim] = rstrides[i] / (npy_intp)sizeof(double);
+        work.row_ndim++;
+    }
 
-    for (int i = 0; i < nrepeats; ++i)
+    int ierr = 0;
+    if (npts > 0)
     {
-        for (int j = trim_pts; j < res_stride; ++j)
-        {
-            rmin_ptr[j] = NPY_NAN;
-        }
-        moving_min_c(&npts, dptr, &wlen, &skip, rmin_ptr);
-        dptr += npts; // increment by number of points in last dimension
-        rmin_ptr += res_stride;
+        Py_BEGIN_ALLOW_THREADS
+        ierr = movstat_run(&work, nrows, workers, movstream_rows);
+        Py_END_ALLOW_THREADS
     }
 
     Py_XDECREF(data);
 
-    return (PyObject *)rmin;
+    if (ierr != 0)
+    {
+        // the row state can be partially updated, so the stream cannot be continued
+        st->failed = 1;
+        for (int k = 0; k < st->nout; ++k)
+            Py_XDECREF(res[k]);
+        return PyErr_NoMemory();
+    }
+    movstream_advance(st, npts);
+
+    PyObject *out = PyTuple_New(st->nout);
+    if (!out)
+    {
+        for (int k = 0; k < st->nout; ++k)
+            Py_XDECREF(res[k]);
+        return NULL;
+    }
+    for (int k = 0; k < st->nout; ++k)
+        PyTuple_SET_ITEM(out, k, (PyObject *)res[k]);  /* steals the reference */
+
+    return out;
+}
+
+
+PyObject * moving_stats_stream_update(PyObject *NPY_UNUSED(self), PyObject *args)
+{
+    PyObject *capsule, *x_, *out;
+    int workers = 1, axis = -1;
+    MovStat_Stream_t *st;
+
+    if (!PyArg_ParseTuple(args, "OO|ii:moving_stats_stream_update", &capsule, &x_, &workers, &axis))
+        return NULL;
+
+    st = (MovStat_Stream_t *)PyCapsule_GetPointer(capsule, MOVSTAT_STREAM_NAME);
+    if (!st)
+        return NULL;
+
+    if (st->failed)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "A previous update of the stream failed, the stream "
+            "has to be restarted.");
+        return NULL;
+    }
+    /* the output sizes depend on the position in the series, and the row state is changed
+     * without the GIL, so only one update can run at a time. Checked and set with the GIL held */
+    if (st->busy)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "The stream is already being updated from another "
+            "thread.");
+        return NULL;
+    }
+
+    st->busy = 1;
+    out = movstream_update(st, x_, workers, axis);
+    st->busy = 0;
+
+    return out;
 }
 
 
@@ -648,13 +1188,17 @@ static const char rmean_doc[] = "moving_mean(a, wlen, skip)\n\n"
 "Paramters\n"
 "---------\n"
 "a : array-like\n"
-"    Array of data to compute the rolling mean for. Computation axis is the last axis.\n"
+"    Array of data to compute the rolling mean for. Computation axis is `axis`.\n"
 "wlen : int\n"
 "    Window size in samples.\n"
 "skip : int\n"
 "    Samples between window starts. `skip=wlen` would result in non-overlapping sequential windows.\n"
 "trim : bool\n"
 "    Trim the ends of the result, where a value cannot be calculated. If False, these values will be set to NaN. Default is True.\n\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
 "Returns\n"
 "-------\n"
 "rmean : numpy.ndarray\n"
@@ -667,7 +1211,7 @@ static const char rsd_doc[] = "moving_sd(a, wlen, skip, return_previous)\n\n"
 "Paramters\n"
 "---------\n"
 "a : array-like\n"
-"    Array of data to compute the rolling standar deviation for. Computation axis is the last axis.\n"
+"    Array of data to compute the rolling standar deviation for. Computation axis is `axis`.\n"
 "wlen : int\n"
 "    Window size in samples.\n"
 "skip : int\n"
@@ -675,7 +1219,11 @@ static const char rsd_doc[] = "moving_sd(a, wlen, skip, return_previous)\n\n"
 "trim : bool\n"
 "    Trim the ends of the result, where a value cannot be calculated. If False, these values will be set to NaN. Default is True.\n\n"
 "return_previous : bool\n"
-"    Return the previous rolling moments."
+"    Return the previous rolling moments.\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
 "Returns\n"
 "-------\n"
 "rsd : numpy.ndarray\n"
@@ -690,7 +1238,7 @@ static const char rskew_doc[] = "moving_skewness(a, wlen, skip, return_previous)
 "Paramters\n"
 "---------\n"
 "a : array-like\n"
-"    Array of data to compute the rolling skewness for. Computation axis is the last axis.\n"
+"    Array of data to compute the rolling skewness for. Computation axis is `axis`.\n"
 "wlen : int\n"
 "    Window size in samples.\n"
 "skip : int\n"
@@ -698,7 +1246,11 @@ static const char rskew_doc[] = "moving_skewness(a, wlen, skip, return_previous)
 "trim : bool\n"
 "    Trim the ends of the result, where a value cannot be calculated. If False, these values will be set to NaN. Default is True.\n\n"
 "return_previous : bool\n"
-"    Return the previous rolling moments."
+"    Return the previous rolling moments.\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
 "Returns\n"
 "-------\n"
 "rskew : numpy.ndarray\n"
@@ -715,7 +1267,7 @@ static const char rkurt_doc[] = "moving_kurtosis(a, wlen, skip, return_previous)
 "Parameters\n"
 "---------\n"
 "a : array-like\n"
-"    Array of data to compute the rolling kurtosis for. Computation axis is the last axis.\n"
+"    Array of data to compute the rolling kurtosis for. Computation axis is `axis`.\n"
 "wlen : int\n"
 "    Window size in samples.\n"
 "skip : int\n"
@@ -723,7 +1275,11 @@ static const char rkurt_doc[] = "moving_kurtosis(a, wlen, skip, return_previous)
 "trim : bool\n"
 "    Trim the ends of the result, where a value cannot be calculated. If False, these values will be set to NaN. Default is True.\n\n"
 "return_previous : bool\n"
-"    Return the previous rolling moments."
+"    Return the previous rolling moments.\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
 "Returns\n"
 "-------\n"
 "rkurt : numpy.ndarray\n"
@@ -741,13 +1297,17 @@ static const char rmed_doc[] = "moving_median(a, wlen, skip)\n\n"
 "Parameters\n"
 "----------\n"
 "a : array-like\n"
-"    Array of data to compute rolling median on. Computation axis is the last axis.\n"
+"    Array of data to compute rolling median on. Computation axis is `axis`.\n"
 "wlen : int\n"
 "    Window size in samples.\n"
 "skip : int\n"
 "    Samples between window starts. `skip=wlen` would result in non-overlapping sequential windows.\n"
 "trim : bool\n"
 "    Trim the ends of the result, where a value cannot be calculated. If False, these values will be set to NaN. Default is True.\n\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
 "Returns\n"
 "-------\n"
 "rmed : numpy.ndarray\n"
@@ -759,11 +1319,15 @@ static const char rmax_doc[] = "moving_max(a, wlen, skip)\n\n"
 "Parameters\n"
 "----------\n"
 "a : array-like\n"
-"    Array of data to compute rolling max on. Computation axis is the last axis.\n"
+"    Array of data to compute rolling max on. Computation axis is `axis`.\n"
 "wlen : int\n"
 "    Window size in samples.\n"
 "skip : int\n"
 "    Samples between window starts. `skip=wlen` would result in non-overlapping sequential windows.\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
 "Returns\n"
 "-------\n"
 "rmax : numpy.ndarray\n"
@@ -775,16 +1339,90 @@ static const char rmin_doc[] = "moving_min(a, wlen, skip)\n\n"
 "Parameters\n"
 "----------\n"
 "a : array-like\n"
-"    Array of data to compute rolling min on. Computation axis is the last axis.\n"
+"    Array of data to compute rolling min on. Computation axis is `axis`.\n"
 "wlen : int\n"
 "    Window size in samples.\n"
 "skip : int\n"
 "    Samples between window starts. `skip=wlen` would result in non-overlapping sequential windows.\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
 "Returns\n"
 "-------\n"
 "rmin : numpy.ndarray\n"
 "    Rolling min.";
 
+static const char rstats_doc[] = "moving_stats(a, wlen, skip, trim, stats)\n\n"
+"Compute several rolling statistics over windows of length `wlen` with `skip` samples between "
+"window starts, in a single pass over each row of the data. The moments share one computation, "
+"and the range is computed from the max and min.\n\n"
+"Parameters\n"
+"----------\n"
+"a : array-like\n"
+"    Array of data to compute the rolling statistics on. Computation axis is `axis`.\n"
+"wlen : int\n"
+"    Window size in samples.\n"
+"skip : int\n"
+"    Samples between window starts. `skip=wlen` would result in non-overlapping sequential windows.\n"
+"trim : bool\n"
+"    Trim the ends of the result, where a value cannot be calculated. If False, these values will be set to NaN.\n"
+"stats : sequence of str\n"
+"    Statistics to compute. Any of 'mean', 'sd', 'skewness', 'kurtosis', 'median', 'max', 'min', "
+"and 'range'.\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
+"Returns\n"
+"-------\n"
+"res : tuple of numpy.ndarray\n"
+"    Rolling statistics, in the order of `stats`.";
+
+static const char rstream_doc[] = "moving_stats_stream(wlen, skip, stats, nrows)\n\n"
+"Create the state for computing rolling statistics on a series that arrives in chunks, "
+"with `moving_stats_stream_update`.\n\n"
+"Parameters\n"
+"----------\n"
+"wlen : int\n"
+"    Window size in samples.\n"
+"skip : int\n"
+"    Samples between window starts.\n"
+"stats : sequence of str\n"
+"    Statistics to compute. Any of 'mean', 'sd', 'skewness', 'kurtosis', 'median', 'max', 'min', "
+"and 'range'.\n"
+"nrows : int\n"
+"    Number of rows (product of all but the computation axis) of every chunk.\n\n"
+"Returns\n"
+"-------\n"
+"stream : capsule\n"
+"    Stream state. Updating it from another thread while an update is in progress raises a "
+"RuntimeError.";
+
+static const char rstream_update_doc[] = "moving_stats_stream_update(stream, a)\n\n"
+"Add the next chunk of a series to a stream, and compute the windows it completes. Only the new "
+"samples are passed through the kernels, and the results are identical to `moving_stats` on the "
+"whole series.\n\n"
+"Parameters\n"
+"----------\n"
+"stream : capsule\n"
+"    Stream state from `moving_stats_stream`.\n"
+"a : array-like\n"
+"    Next chunk of the series. Computation axis is `axis`.\n"
+"workers : int, optional\n"
+"    Number of threads to split the rows (all but the computation axis) across. Default is 1.\n"
+"axis : int, optional\n"
+"    Computation axis. The input does not need to be contiguous along it. Default is -1.\n\n"
+"Returns\n"
+"-------\n"
+"res : tuple of numpy.ndarray\n"
+"    Rolling statistics of the completed windows, in the order of `stats`.\n\n"
+"Raises\n"
+"------\n"
+"RuntimeError\n"
+"    If the stream is being updated from another thread, or a previous update failed part way "
+"and left the stream state inconsistent.";
+
 static struct PyMethodDef methods[] = {
     {"moving_mean",   moving_mean,   1, rmean_doc},  // last is the docstring
     {"moving_sd",   moving_sd,   1, rsd_doc},  // last is the docstring
@@ -793,6 +1431,9 @@ static struct PyMethodDef methods[] = {
     {"moving_median", moving_median, 1, rmed_doc},
     {"moving_max", moving_max, 1, rmax_doc},
     {"moving_min", moving_min, 1, rmin_doc},
+    {"moving_stats", moving_stats, 1, rstats_doc},
+    {"moving_stats_stream", moving_stats_stream, 1, rstream_doc},
+    {"moving_stats_stream_update", moving_stats_stream_update, 1, rstream_update_doc},
     {NULL, NULL, 0, NULL}          /* sentinel */
 };
 
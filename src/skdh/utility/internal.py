@@ -25,6 +25,8 @@ from numpy import (
 )
 from scipy.signal import cheby1, sosfiltfilt
 
+from skdh.utility.time_anchors import TimeAnchors
+
 
 def get_day_index_intersection(starts, stops, for_inclusion, day_start, day_stop):
     """
@@ -137,8 +139,10 @@ def apply_downsample(goal_fs, time, data=(), indices=(), aa_filter=True, fs=None
     ----------
     goal_fs : float
         Desired sampling frequency in Hz.
-    time : numpy.ndarray
-        Array of original timestamps.
+    time : {numpy.ndarray, TimeAnchors}
+        Array of original timestamps. If :class:`TimeAnchors`, and `goal_fs` is an
+        integer factor of `fs`, the downsampled time is also returned as anchors,
+        without computing the full timestamp array.
     data : tuple, optional
         Tuple of arrays to normally downsample using interpolation. Must match the size of `time`.
         Can handle `None` inputs, and will return an array of zeros matching the downsampled size.
@@ -155,7 +159,7 @@ def apply_downsample(goal_fs, time, data=(), indices=(), aa_filter=True, fs=None
 
     Returns
     -------
-    time_ds : numpy.ndarray
+    time_ds : {numpy.ndarray, TimeAnchors}
         Downsampled time.
     data_ds : tuple, optional
         Downsampled data, if provided.
@@ -187,9 +191,15 @@ def apply_downsample(goal_fs, time, data=(), indices=(), aa_filter=True, fs=None
         fs = 1 / mean(diff(time[:2500]))
 
     if int(fs / goal_fs) == fs / goal_fs:
-        time_ds = time[:: int(fs / goal_fs)]
+        if isinstance(time, TimeAnchors):
+            time_ds = time.downsample(int(fs / goal_fs))
+        else:
+            time_ds = time[:: int(fs / goal_fs)]
     else:
         time_ds = arange(time[0], time[-1], 1 / goal_fs)
+        # interpolation needs every timestamp
+        if isinstance(time, TimeAnchors) and len(data) > 0:
+            time = time.materialize()
     # AA filter, if necessary
     sos = cheby1(8, 0.05, 0.8 / (fs / goal_fs), output="sos")
 
@@ -4,7 +4,15 @@ Utility math functions
 Lukas Adamowicz
 Copyright (c) 2021. Pfizer Inc. All rights reserved.
 """
-from numpy import moveaxis, ascontiguousarray, full, nan
+from threading import Lock
+
+from numpy import (
+    asarray,
+    prod,
+    full,
+    nan,
+    float64,
+)
 
 from skdh.utility import _extensions
 from skdh.utility.windowing import get_windowed_view
@@ -18,10 +26,12 @@ __all__ = [
     "moving_median",
     "moving_max",
     "moving_min",
+    "moving_stats",
+    "MovingStatsAccumulator",
 ]
 
 
-def moving_mean(a, w_len, skip, trim=True, axis=-1):
+def moving_mean(a, w_len, skip, trim=True, axis=-1, workers=1):
     r"""
     Compute the moving mean.
 
@@ -38,12 +48,14 @@ def moving_mean(a, w_len, skip, trim=True, axis=-1):
         these values will be set to NaN. Default is True.
     axis : int, optional
         Axis to compute the moving mean along. Default is -1.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Default is 1.
 
     Returns
     -------
     mmean : numpy.ndarray
-        Moving mean. Note that if the moving axis is not the last axis, then the result
-        will *not* be c-contiguous.
+        Moving mean.
 
     Notes
     -----
@@ -97,14 +109,14 @@ def moving_mean(a, w_len, skip, trim=True, axis=-1):
     >>> print(res.shape)
     (3, 9, 5, 10)
 
-    Check flags for different axis output
+    The result is c-contiguous for any moving axis
 
     >>> z = np.random.random((10, 10, 10))
     >>> moving_mean(z, 3, 3, axis=0).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_mean(z, 3, 3, axis=1).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_mean(z, 3, 3, axis=2).flags['C_CONTIGUOUS']
     True
@@ -112,20 +124,16 @@ def moving_mean(a, w_len, skip, trim=True, axis=-1):
     if w_len <= 0 or skip <= 0:
         raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
 
-    # move computation axis to end
-    x = moveaxis(a, axis, -1)
+    x = asarray(a)
 
     # check that there are enough samples
-    if w_len > x.shape[-1]:
+    if w_len > x.shape[axis]:
         raise ValueError("Window length is larger than the computation axis.")
 
-    rmean = _extensions.moving_mean(x, w_len, skip, trim)
-
-    # move computation axis back to original place and return
-    return moveaxis(rmean, -1, axis)
+    return _extensions.moving_mean(x, w_len, skip, trim, workers, axis)
 
 
-def moving_sd(a, w_len, skip, trim=True, axis=-1, return_previous=True):
+def moving_sd(a, w_len, skip, trim=True, axis=-1, return_previous=True, workers=1):
     r"""
     Compute the moving sample standard deviation.
 
@@ -145,15 +153,16 @@ def moving_sd(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     return_previous : bool, optional
         Return previous moments. These are computed either way, and are therefore optional returns.
         Default is True.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Default is 1.
 
     Returns
     -------
     msd : numpy.ndarray
-        Moving sample standard deviation. Note that if the moving axis is not the last axis,
-        then the result will *not* be c-contiguous.
+        Moving sample standard deviation.
     mmean : numpy.ndarray, optional.
-        Moving mean. Note that if the moving axis is not the last axis, then the result
-        will *not* be c-contiguous. Only returned if `return_previous=True`.
+        Moving mean. Only returned if `return_previous=True`.
 
     Notes
     -----
@@ -210,14 +219,14 @@ def moving_sd(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     >>> print(res.shape)
     (3, 9, 5, 10)
 
-    Check flags for different axis output
+    The result is c-contiguous for any moving axis
 
     >>> z = np.random.random((10, 10, 10))
     >>> moving_sd(z, 3, 3, axis=0, return_previous=False).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_sd(z, 3, 3, axis=1, return_previous=False).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_sd(z, 3, 3, axis=2, return_previous=False).flags['C_CONTIGUOUS']
     True
@@ -225,25 +234,20 @@ def moving_sd(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     if w_len <= 0 or skip <= 0:
         raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
 
-    # move computation axis to end
-    x = moveaxis(a, axis, -1)
+    x = asarray(a)
 
     # check that there are enough samples
-    if w_len > x.shape[-1]:
+    if w_len > x.shape[axis]:
         raise ValueError(
             "Cannot have a window length larger than the computation axis."
         )
 
-    res = _extensions.moving_sd(x, w_len, skip, trim, return_previous)
+    return _extensions.moving_sd(x, w_len, skip, trim, return_previous, workers, axis)
 
-    # move computation axis back to original place and return
-    if return_previous:
-        return moveaxis(res[0], -1, axis), moveaxis(res[1], -1, axis)
-    else:
-        return moveaxis(res, -1, axis)
 
-
-def moving_skewness(a, w_len, skip, trim=True, axis=-1, return_previous=True):
+def moving_skewness(
+    a, w_len, skip, trim=True, axis=-1, return_previous=True, workers=1
+):
     r"""
     Compute the moving sample skewness.
 
@@ -263,18 +267,18 @@ def moving_skewness(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     return_previous : bool, optional
         Return previous moments. These are computed either way, and are therefore optional returns.
         Default is True.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Default is 1.
 
     Returns
     -------
     mskew : numpy.ndarray
-        Moving skewness. Note that if the moving axis is not the last axis,
-        then the result will *not* be c-contiguous.
+        Moving skewness.
     msd : numpy.ndarray, optional
-        Moving sample standard deviation. Note that if the moving axis is not the last axis,
-        then the result will *not* be c-contiguous. Only returned if `return_previous=True`.
+        Moving sample standard deviation. Only returned if `return_previous=True`.
     mmean : numpy.ndarray, optional.
-        Moving mean. Note that if the moving axis is not the last axis, then the result
-        will *not* be c-contiguous. Only returned if `return_previous=True`.
+        Moving mean. Only returned if `return_previous=True`.
 
     Notes
     -----
@@ -328,14 +332,14 @@ def moving_skewness(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     >>> print(res.shape)
     (3, 9, 5, 10)
 
-    Check flags for different axis output
+    The result is c-contiguous for any moving axis
 
     >>> z = np.random.random((10, 10, 10))
     >>> moving_skewness(z, 3, 3, axis=0, return_previous=False).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_skewness(z, 3, 3, axis=1, return_previous=False).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_skewness(z, 3, 3, axis=2, return_previous=False).flags['C_CONTIGUOUS']
     True
@@ -343,25 +347,22 @@ def moving_skewness(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     if w_len <= 0 or skip <= 0:
         raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
 
-    # move computation axis to end
-    x = moveaxis(a, axis, -1)
+    x = asarray(a)
 
     # check that there are enough samples
-    if w_len > x.shape[-1]:
+    if w_len > x.shape[axis]:
         raise ValueError(
             "Cannot have a window length larger than the computation axis."
         )
 
-    res = _extensions.moving_skewness(x, w_len, skip, trim, return_previous)
-
-    # move computation axis back to original place and return
-    if return_previous:
-        return tuple(moveaxis(i, -1, axis) for i in res)
-    else:
-        return moveaxis(res, -1, axis)
+    return _extensions.moving_skewness(
+        x, w_len, skip, trim, return_previous, workers, axis
+    )
 
 
-def moving_kurtosis(a, w_len, skip, trim=True, axis=-1, return_previous=True):
+def moving_kurtosis(
+    a, w_len, skip, trim=True, axis=-1, return_previous=True, workers=1
+):
     r"""
     Compute the moving sample kurtosis.
 
@@ -381,21 +382,20 @@ def moving_kurtosis(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     return_previous : bool, optional
         Return previous moments. These are computed either way, and are therefore optional returns.
         Default is True.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Default is 1.
 
     Returns
     -------
     mkurt : numpy.ndarray
-        Moving kurtosis. Note that if the moving axis is not the last axis,
-        then the result will *not* be c-contiguous.
+        Moving kurtosis.
     mskew : numpy.ndarray, optional
-        Moving skewness. Note that if the moving axis is not the last axis,
-        then the result will *not* be c-contiguous. Only returned if `return_previous=True`.
+        Moving skewness. Only returned if `return_previous=True`.
     msd : numpy.ndarray, optional
-        Moving sample standard deviation. Note that if the moving axis is not the last axis,
-        then the result will *not* be c-contiguous. Only returned if `return_previous=True`.
+        Moving sample standard deviation. Only returned if `return_previous=True`.
     mmean : numpy.ndarray, optional.
-        Moving mean. Note that if the moving axis is not the last axis, then the result
-        will *not* be c-contiguous. Only returned if `return_previous=True`.
+        Moving mean. Only returned if `return_previous=True`.
 
     Notes
     -----
@@ -448,14 +448,14 @@ def moving_kurtosis(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     >>> print(res.shape)
     (3, 9, 5, 10)
 
-    Check flags for different axis output
+    The result is c-contiguous for any moving axis
 
     >>> z = np.random.random((10, 10, 10))
     >>> moving_kurtosis(z, 3, 3, axis=0, return_previous=False).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_kurtosis(z, 3, 3, axis=1, return_previous=False).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_kurtosis(z, 3, 3, axis=2, return_previous=False).flags['C_CONTIGUOUS']
     True
@@ -463,25 +463,20 @@ def moving_kurtosis(a, w_len, skip, trim=True, axis=-1, return_previous=True):
     if w_len <= 0 or skip <= 0:
         raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
 
-    # move computation axis to end
-    x = moveaxis(a, axis, -1)
+    x = asarray(a)
 
     # check that there are enough samples
-    if w_len > x.shape[-1]:
+    if w_len > x.shape[axis]:
         raise ValueError(
             "Cannot have a window length larger than the computation axis."
         )
 
-    res = _extensions.moving_kurtosis(x, w_len, skip, trim, return_previous)
-
-    # move computation axis back to original place and return
-    if return_previous:
-        return tuple(moveaxis(i, -1, axis) for i in res)
-    else:
-        return moveaxis(res, -1, axis)
+    return _extensions.moving_kurtosis(
+        x, w_len, skip, trim, return_previous, workers, axis
+    )
 
 
-def moving_median(a, w_len, skip=1, trim=True, axis=-1):
+def moving_median(a, w_len, skip=1, trim=True, axis=-1, workers=1):
     r"""
     Compute the moving mean.
 
@@ -498,12 +493,14 @@ def moving_median(a, w_len, skip=1, trim=True, axis=-1):
         these values will be set to NaN. Default is True.
     axis : int, optional
         Axis to compute the moving mean along. Default is -1.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Default is 1.
 
     Returns
     -------
     mmed : numpy.ndarray
-        Moving median. Note that if the moving axis is not the last axis, then the result
-        will *not* be c-contiguous.
+        Moving median.
 
     Notes
     -----
@@ -547,14 +544,14 @@ def moving_median(a, w_len, skip=1, trim=True, axis=-1):
     >>> print(res.shape)
     (3, 9, 5, 10)
 
-    Check flags for different axis output
+    The result is c-contiguous for any moving axis
 
     >>> z = np.random.random((10, 10, 10))
     >>> moving_median(z, 3, 3, axis=0).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_median(z, 3, 3, axis=1).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_median(z, 3, 3, axis=2).flags['C_CONTIGUOUS']
     True
@@ -562,22 +559,18 @@ def moving_median(a, w_len, skip=1, trim=True, axis=-1):
     if w_len <= 0 or skip <= 0:
         raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
 
-    # move computation axis to end
-    x = moveaxis(a, axis, -1)
+    x = asarray(a)
 
     # check that there are enough samples
-    if w_len > x.shape[-1]:
+    if w_len > x.shape[axis]:
         raise ValueError(
             "Cannot have a window length larger than the computation axis."
         )
 
-    rmed = _extensions.moving_median(x, w_len, skip, trim)
-
-    # move computation axis back to original place and return
-    return moveaxis(rmed, -1, axis)
+    return _extensions.moving_median(x, w_len, skip, trim, workers, axis)
 
 
-def moving_max(a, w_len, skip, trim=True, axis=-1):
+def moving_max(a, w_len, skip, trim=True, axis=-1, workers=1):
     r"""
     Compute the moving maximum value.
 
@@ -594,12 +587,15 @@ def moving_max(a, w_len, skip, trim=True, axis=-1):
         these values will be set to NaN. Default is True.
     axis : int, optional
         Axis to compute the moving max along. Default is -1.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Only used if computing with the compiled implementation, which is
+        always the case if `workers > 1`. Default is 1.
 
     Returns
     -------
     mmax : numpy.ndarray
-        Moving max. Note that if the moving axis is not the last axis, then the result
-        will *not* be c-contiguous.
+        Moving max.
 
     Notes
     -----
@@ -643,14 +639,14 @@ def moving_max(a, w_len, skip, trim=True, axis=-1):
     >>> print(res.shape)
     (3, 9, 5, 10)
 
-    Check flags for different axis output
+    The result is c-contiguous for any moving axis
 
     >>> z = np.random.random((10, 10, 10))
     >>> moving_max(z, 3, 3, axis=0).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_max(z, 3, 3, axis=1).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_max(z, 3, 3, axis=2).flags['C_CONTIGUOUS']
     True
@@ -658,27 +654,24 @@ def moving_max(a, w_len, skip, trim=True, axis=-1):
     if w_len <= 0 or skip <= 0:
         raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
 
-    # Numpy uses SIMD instructions for max/min, so it will likely be faster
-    # unless there is a lot of overlap
-    cond1 = a.ndim == 1 and (skip / w_len) < 0.005
-    cond2 = a.ndim > 1 and (skip / w_len) < 0.3  # due to c-contiguity?
-    cond3 = a.ndim > 2  # windowing doesnt handle more than 2 dimensions currently
-    if any([cond1, cond2, cond3]):
-        # move computation axis to end
-        x = moveaxis(a, axis, -1)
-
-        # check that there are enough samples
-        if w_len > x.shape[-1]:
-            raise ValueError("Window length is larger than the computation axis.")
+    x = asarray(a)
 
-        rmax = _extensions.moving_max(x, w_len, skip, trim)
+    # check that there are enough samples
+    if w_len > x.shape[axis]:
+        raise ValueError("Window length is larger than the computation axis.")
 
-        # move computation axis back to original place and return
-        return moveaxis(rmax, -1, axis)
+    # Numpy uses SIMD instructions for max/min, so it will likely be faster
+    # unless there is a lot of overlap
+    cond1 = x.ndim == 1 and (skip / w_len) < 0.005
+    cond2 = x.ndim > 1 and (skip / w_len) < 0.3  # due to c-contiguity?
+    cond3 = x.ndim > 2  # windowing doesnt handle more than 2 dimensions currently
+    cond4 = workers > 1  # only the compiled version is threaded
+    # windowing needs the moving axis first in c-contiguous data, anything else would
+    # need a full copy of the input
+    cond5 = not (x.flags["C_CONTIGUOUS"] and axis % x.ndim == 0)
+    if any([cond1, cond2, cond3, cond4, cond5]):
+        return _extensions.moving_max(x, w_len, skip, trim, workers, axis)
     else:
-        x = ascontiguousarray(
-            moveaxis(a, axis, 0)
-        )  # need to move axis to the front for windowing
         xw = get_windowed_view(x, w_len, skip)
         if trim:
             res = xw.max(axis=1)  # computation axis is still the second axis
@@ -689,10 +682,10 @@ def moving_max(a, w_len, skip, trim=True, axis=-1):
             res = full(rshape, nan)
             res[:nfill] = xw.max(axis=1)
 
-        return moveaxis(res, 0, axis)
+        return res
 
 
-def moving_min(a, w_len, skip, trim=True, axis=-1):
+def moving_min(a, w_len, skip, trim=True, axis=-1, workers=1):
     r"""
     Compute the moving maximum value.
 
@@ -709,12 +702,15 @@ def moving_min(a, w_len, skip, trim=True, axis=-1):
         these values will be set to NaN. Default is True.
     axis : int, optional
         Axis to compute the moving max along. Default is -1.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Only used if computing with the compiled implementation, which is
+        always the case if `workers > 1`. Default is 1.
 
     Returns
     -------
     mmax : numpy.ndarray
-        Moving max. Note that if the moving axis is not the last axis, then the result
-        will *not* be c-contiguous.
+        Moving max.
 
     Notes
     -----
@@ -759,14 +755,14 @@ def moving_min(a, w_len, skip, trim=True, axis=-1):
     >>> print(res.shape)
     (3, 9, 5, 10)
 
-    Check flags for different axis output
+    The result is c-contiguous for any moving axis
 
     >>> z = np.random.random((10, 10, 10))
     >>> moving_min(z, 3, 3, axis=0).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_min(z, 3, 3, axis=1).flags['C_CONTIGUOUS']
-    False
+    True
 
     >>> moving_min(z, 3, 3, axis=2).flags['C_CONTIGUOUS']
     True
@@ -774,27 +770,24 @@ def moving_min(a, w_len, skip, trim=True, axis=-1):
     if w_len <= 0 or skip <= 0:
         raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
 
-    # Numpy uses SIMD instructions for max/min, so it will likely be faster
-    # unless there is a lot of overlap
-    cond1 = a.ndim == 1 and (skip / w_len) < 0.005
-    cond2 = a.ndim > 1 and (skip / w_len) < 0.3  # due to c-contiguity?
-    cond3 = a.ndim > 2  # windowing doesnt handle more than 2 dimensions currently
-    if any([cond1, cond2, cond3]):
-        # move computation axis to end
-        x = moveaxis(a, axis, -1)
-
-        # check that there are enough samples
-        if w_len > x.shape[-1]:
-            raise ValueError("Window length is larger than the computation axis.")
+    x = asarray(a)
 
-        rmin = _extensions.moving_min(x, w_len, skip, trim)
+    # check that there are enough samples
+    if w_len > x.shape[axis]:
+        raise ValueError("Window length is larger than the computation axis.")
 
-        # move computation axis back to original place and return
-        return moveaxis(rmin, -1, axis)
+    # Numpy uses SIMD instructions for max/min, so it will likely be faster
+    # unless there is a lot of overlap
+    cond1 = x.ndim == 1 and (skip / w_len) < 0.005
+    cond2 = x.ndim > 1 and (skip / w_len) < 0.3  # due to c-contiguity?
+    cond3 = x.ndim > 2  # windowing doesnt handle more than 2 dimensions currently
+    cond4 = workers > 1  # only the compiled version is threaded
+    # windowing needs the moving axis first in c-contiguous data, anything else would
+    # need a full copy of the input
+    cond5 = not (x.flags["C_CONTIGUOUS"] and axis % x.ndim == 0)
+    if any([cond1, cond2, cond3, cond4, cond5]):
+        return _extensions.moving_min(x, w_len, skip, trim, workers, axis)
     else:
-        x = ascontiguousarray(
-            moveaxis(a, axis, 0)
-        )  # need to move axis to the front for windowing
         xw = get_windowed_view(x, w_len, skip)
         if trim:
             res = xw.min(axis=1)  # computation axis is still the second axis
@@ -805,4 +798,216 @@ def moving_min(a, w_len, skip, trim=True, axis=-1):
             res = full(rshape, nan)
             res[:nfill] = xw.min(axis=1)
 
-        return moveaxis(res, 0, axis)
+        return res
+
+
+def moving_stats(a, w_len, skip, stats, trim=True, axis=-1, workers=1):
+    r"""
+    Compute several moving statistics together, in a single pass over the data.
+
+    Parameters
+    ----------
+    a : array-like
+        Signal to compute moving statistics for.
+    w_len : int
+        Window length in number of samples.
+    skip : int
+        Window start location skip in number of samples.
+    stats : sequence of str
+        Statistics to compute. Any of "mean", "sd", "skewness", "kurtosis", "median",
+        "max", "min", and "range".
+    trim : bool, optional
+        Trim the ends of the result, where a value cannot be calculated. If False,
+        these values will be set to NaN. Default is True.
+    axis : int, optional
+        Axis to compute the moving statistics along. Default is -1.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Default is 1.
+
+    Returns
+    -------
+    res : dict
+        Dictionary of the moving statistics, with the names from `stats` as keys.
+
+    Notes
+    -----
+    The results are identical to calling the individual `moving_*` functions, but each
+    row of the data is only read once. The moments ("mean", "sd", "skewness",
+    "kurtosis") are computed together, and "range" is computed from the maximum and
+    minimum.
+
+    Examples
+    --------
+    >>> import numpy as np
+    >>> x = np.arange(10) ** 2
+    >>> res = moving_stats(x, 3, 3, ["mean", "range"])
+    >>> res["mean"]
+    array([ 1.66666667, 16.66666667, 49.66666667])
+    >>> res["range"]
+    array([ 4., 16., 28.])
+    """
+    if w_len <= 0 or skip <= 0:
+        raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
+
+    stats = list(stats)
+    x = asarray(a)
+
+    # check that there are enough samples
+    if w_len > x.shape[axis]:
+        raise ValueError("Window length is larger than the computation axis.")
+
+    res = _extensions.moving_stats(x, w_len, skip, trim, stats, workers, axis)
+
+    return dict(zip(stats, res))
+
+
+class MovingStatsAccumulator:
+    r"""
+    Compute moving statistics on data that arrives in successive chunks, such as from
+    a chunked reader or a live stream. Only the windows that are complete are returned
+    from each chunk. The kernel state (running sums, max/min queues, and median heaps) is
+    carried between chunks, so each chunk only costs its own samples, and memory use is
+    bounded by the chunk size plus one window.
+
+    Parameters
+    ----------
+    w_len : int
+        Window length in number of samples.
+    skip : int
+        Window start location skip in number of samples.
+    stats : sequence of str
+        Statistics to compute. Any of "mean", "sd", "skewness", "kurtosis", "median",
+        "max", "min", and "range".
+    axis : int, optional
+        Axis of each chunk to compute the moving statistics along. Default is -1.
+    workers : int, optional
+        Number of threads to split the rows (every axis other than the moving axis)
+        across. Default is 1.
+
+    Notes
+    -----
+    The concatenated results from all the chunks are identical to `moving_stats` with
+    `trim=True` on the concatenated chunks. Adding the results of :meth:`finish` matches
+    `trim=False`.
+
+    Chunks have to be added one at a time. Calling :meth:`update` while another thread
+    is updating the same accumulator raises a `RuntimeError`, as does any update after
+    one that failed part way (eg running out of memory), until :meth:`reset` is called.
+
+    Examples
+    --------
+    >>> import numpy as np
+    >>> x = np.random.default_rng(1).random(1000)
+    >>> acc = MovingStatsAccumulator(50, 25, ["mean", "median"])
+    >>> res = [acc.update(chunk) for chunk in np.array_split(x, 7)]
+    >>> rmean = np.concatenate([r["mean"] for r in res])
+    >>> np.array_equal(rmean, moving_mean(x, 50, 25))
+    True
+    """
+
+    def __init__(self, w_len, skip, stats, axis=-1, workers=1):
+        if w_len <= 0 or skip <= 0:
+            raise ValueError("`wlen` and `skip` cannot be less than or equal to 0.")
+
+        self.w_len = int(w_len)
+        self.skip = int(skip)
+        self.stats = list(stats)
+        self.axis = axis
+        self.workers = workers
+        # held for a whole update, so the counts and the kernel state stay consistent
+        self._lock = Lock()
+
+        self.reset()
+
+    def reset(self):
+        """
+        Clear the carried over kernel state, to start a new series.
+        """
+        self._stream = None  # kernel state, created with the first chunk
+        self._shape = None  # shape of the axes other than the moving axis
+        self._n = 0  # total samples seen
+        self.n_windows = 0  # windows returned so far
+
+    def _row_shape(self, x):
+        axis = self.axis + x.ndim if self.axis < 0 else self.axis
+        return x.shape[:axis] + x.shape[axis + 1 :]
+
+    def update(self, chunk):
+        """
+        Add the next chunk of data.
+
+        Parameters
+        ----------
+        chunk : array-like
+            Next samples of the series. All axes other than the moving axis must have
+            the same size for every chunk.
+
+        Returns
+        -------
+        res : dict
+            Moving statistics for the windows that were completed by this chunk, with
+            the names from `stats` as keys. The moving axis has length 0 if no windows
+            were completed.
+
+        Raises
+        ------
+        RuntimeError
+            If another thread is updating the accumulator, or a previous update failed
+            part way.
+        """
+        if not self._lock.acquire(blocking=False):
+            raise RuntimeError(
+                "The accumulator is already being updated from another thread."
+            )
+        try:
+            return self._update(chunk)
+        finally:
+            self._lock.release()
+
+    def _update(self, chunk):
+        x = asarray(chunk, dtype=float64)
+        shape = self._row_shape(x)
+
+        if self._stream is None:
+            self._stream = _extensions.moving_stats_stream(
+                self.w_len, self.skip, self.stats, int(prod(shape))
+            )
+            self._shape = shape
+        elif shape != self._shape:
+            raise ValueError(
+                "All axes other than the moving axis must have the same size for every "
+                "chunk."
+            )
+
+        res = _extensions.moving_stats_stream_update(
+            self._stream, x, self.workers, self.axis
+        )
+
+        self._n += x.shape[self.axis]
+        self.n_windows += res[0].shape[self.axis]
+
+        return dict(zip(self.stats, res))
+
+    def finish(self):
+        """
+        Get the windows at the end of the series that could not be completed. These are
+        filled with NaN, matching the `moving_*` functions with `trim=False`.
+
+        Returns
+        -------
+        res : dict
+            NaN results for the incomplete windows, with the names from `stats` as keys.
+        """
+        if self._stream is None:
+            raise ValueError("No data has been added.")
+
+        n_total = (self._n - 1) // self.skip + 1 if self._n > 0 else 0
+        n = max(n_total - self.n_windows, 0)
+
+        # put the moving axis back in the same place as in the chunks
+        shape = list(self._shape)
+        axis = self.axis + len(shape) + 1 if self.axis < 0 else self.axis
+        shape.insert(axis, n)
+
+        return {k: full(shape, nan) for k in self.stats}
@@ -0,0 +1,263 @@
+"""
+Compact timestamp representation
+
+Lukas Adamowicz
+Copyright (c) 2021. Pfizer Inc. All rights reserved.
+"""
+from numbers import Integral
+
+from numpy import (
+    asarray,
+    arange,
+    searchsorted,
+    minimum,
+    around,
+    ceil,
+    concatenate,
+    full,
+    nonzero,
+    diff,
+    float64,
+    int64,
+    ndarray,
+    dtype as np_dtype,
+)
+
+__all__ = ["TimeAnchors", "interp_anchors"]
+
+
+def interp_anchors(index, t0, fs, samples):
+    """
+    Compute the timestamps of samples from time anchors. Each anchor gives the time
+    `t0` of the sample at `index`, and the following samples (up to the next anchor)
+    are spaced at `1 / fs`.
+
+    Parameters
+    ----------
+    index : numpy.ndarray
+        Sample index of each anchor, in increasing order. The first must be 0.
+    t0 : numpy.ndarray
+        Time of the sample at each anchor.
+    fs : numpy.ndarray
+        Sampling frequency of the samples from each anchor.
+    samples : {int, array-like}
+        Indices of the samples to get the time for.
+
+    Returns
+    -------
+    time : {float, numpy.ndarray}
+        Timestamps of `samples`.
+    """
+    samples = asarray(samples)
+    i = searchsorted(index, samples, side="right") - 1
+    return t0[i] + (samples - index[i]) / fs[i]
+
+
+class TimeAnchors:
+    """
+    Timestamps of a regularly sampled recording, stored as one anchor per block of
+    samples instead of one value per sample. Each anchor is `(index, t0, fs)`, the
+    sample index, time, and sampling frequency of the samples from that index up to
+    the next anchor.
+
+    Behaves like a read-only 1D array of timestamps: indexing computes only the
+    requested timestamps, and numpy functions (eg `numpy.asarray`) materialize the
+    full array.
+
+    Parameters
+    ----------
+    index : array-like
+        Sample index of each anchor, in increasing order, starting at 0.
+    t0 : array-like
+        Time of the sample at each anchor, in seconds.
+    fs : array-like
+        Sampling frequency of the samples from each anchor.
+    n : int
+        Number of samples.
+    ns : bool, optional
+        Return timestamps as int64 nanoseconds instead of float64 seconds. Default
+        is False.
+
+    Examples
+    --------
+    >>> time = TimeAnchors([0, 120], [1.6e9, 1.6e9 + 1.2], [100.0, 100.0], 240)
+    >>> time[121]
+    1600000001.21
+    >>> numpy.asarray(time).shape
+    (240,)
+    """
+
+    ndim = 1
+
+    def __init__(self, index, t0, fs, n, ns=False):
+        self.index = asarray(index, dtype=int64)
+        self.t0 = asarray(t0, dtype=float64)
+        self.fs = asarray(fs, dtype=float64)
+        self.n = int(n)
+        self.ns = ns
+
+        if not (self.index.size == self.t0.size == self.fs.size):
+            raise ValueError("`index`, `t0`, and `fs` must be the same size.")
+        if (self.n > 0) and ((self.index.size == 0) or (self.index[0] != 0)):
+            raise ValueError("The first anchor must be at index 0.")
+
+    @classmethod
+    def from_time(cls, time, block_samples, fs, offset=0, ns=False):
+        """
+        from_time(time, block_samples, fs, offset=0, ns=False)
+
+        Create anchors from a full timestamp array that is linear within each block
+        of samples, eg the data blocks of a device file.
+
+        Parameters
+        ----------
+        time : numpy.ndarray
+            Timestamps, in seconds.
+        block_samples : int
+            Number of samples in each block.
+        fs : float
+            Nominal sampling frequency, used for blocks with only 1 sample.
+        offset : int, optional
+            Sample index in the blocks of the first sample in `time`, if `time` does
+            not start at the start of a block. Default is 0.
+        ns : bool, optional
+            Return timestamps as int64 nanoseconds. Default is False.
+
+        Returns
+        -------
+        anchors : TimeAnchors
+        """
+        time = asarray(time, dtype=float64)
+        n = time.size
+        block_samples = max(int(block_samples), 1)
+        if n == 0:
+            return cls([], [], [], 0, ns=ns)
+
+        first = (block_samples - offset % block_samples) % block_samples
+        index = arange(first, n, block_samples)
+        if first != 0:
+            index = concatenate(([0], index))
+        last = minimum(concatenate((index[1:], [n])), n) - 1
+
+        dt = time[last] - time[index]
+        with_fs = (last > index) & (dt > 0)
+        fs_ = full(index.size, float(fs))
+        fs_[with_fs] = (last - index)[with_fs] / dt[with_fs]
+
+        return cls(index, time[index], fs_, n, ns=ns)
+
+    @property
+    def size(self):
+        return self.n
+
+    @property
+    def shape(self):
+        return (self.n,)
+
+    @property
+    def dtype(self):
+        return np_dtype(int64) if self.ns else np_dtype(float64)
+
+    @property
+    def nbytes(self):
+        return self.index.nbytes + self.t0.nbytes + self.fs.nbytes
+
+    def __len__(self):
+        return self.n
+
+    def __repr__(self):
+        return f"TimeAnchors(n={self.n}, anchors={self.index.size}, ns={self.ns})"
+
+    def _convert(self, t):
+        if self.ns:
+            return around(asarray(t) * 1e9).astype(int64)
+        return t
+
+    def at(self, samples):
+        """
+        at(samples)
+
+        Timestamps of specific samples.
+
+        Parameters
+        ----------
+        samples : {int, array-like}
+            Indices of the samples. Negative indices count from the end.
+
+        Returns
+        -------
+        time : {float, int, numpy.ndarray}
+        """
+        samples = asarray(samples)
+        if samples.size and ((samples.max() >= self.n) or (samples.min() < -self.n)):
+            raise IndexError(f"index out of bounds for size {self.n}")
+        samples = samples + (samples < 0) * self.n
+
+        t = self._convert(interp_anchors(self.index, self.t0, self.fs, samples))
+        return t[()] if isinstance(t, ndarray) and t.ndim == 0 else t
+
+    def __getitem__(self, key):
+        if isinstance(key, slice):
+            return self.at(arange(*key.indices(self.n)))
+        if isinstance(key, Integral):
+            return self.at(int(key))
+
+        key = asarray(key)
+        if key.dtype == bool:
+            key = nonzero(key)[0]
+        return self.at(key)
+
+    def materialize(self):
+        """
+        materialize()
+
+        Compute the full timestamp array.
+
+        Returns
+        -------
+        time : numpy.ndarray
+        """
+        return self.at(arange(self.n))
+
+    def __array__(self, dtype=None, copy=None):
+        t = self.materialize()
+        return t if dtype is None else t.astype(dtype)
+
+    def downsample(self, step):
+        """
+        downsample(step)
+
+        Anchors for every `step`-th sample, the same as `time[::step]`.
+
+        Parameters
+        ----------
+        step : int
+            Downsampling factor.
+
+        Returns
+        -------
+        anchors : TimeAnchors
+        """
+        step = int(step)
+        n = -(-self.n // step)
+
+        # first downsampled sample from each anchor
+        index = ceil(self.index / step).astype(int64)
+        # anchors with no downsampled samples are replaced by the next anchor
+        keep = concatenate((diff(index) > 0, [True])) & (index < n)
+        index = index[keep]
+        t0 = self.t0[keep] + (index * step - self.index[keep]) / self.fs[keep]
+
+        return TimeAnchors(index, t0, self.fs[keep] / step, n, ns=self.ns)
+
+    def seconds(self):
+        """
+        seconds()
+
+        The same timestamps, as float64 seconds.
+
+        Returns
+        -------
+        anchors : TimeAnchors
+        """
+        return TimeAnchors(self.index, self.t0, self.fs, self.n, ns=False)
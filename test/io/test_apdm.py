@@ -2,7 +2,7 @@ import pytest
 import h5py
 from tempfile import NamedTemporaryFile
 
-from numpy import allclose
+from numpy import allclose, concatenate
 
 from skdh.io import ReadApdmH5
 from skdh.io.apdm import SensorNotFoundError
@@ -30,6 +30,50 @@ class TestReadBin:
                 with pytest.raises(Exception):
                     ReadApdmH5("Lumbar").predict(tmpf.name)
 
+        # chunked reading checks the file the same way, when it is called
+        with NamedTemporaryFile(suffix=".abc") as tmpf:
+            with pytest.raises(ValueError, match=r"expected \[.h5\]"):
+                ReadApdmH5("Lumbar", ext_error="raise").iter_chunks(tmpf.name, n_samples=10)
+            assert list(ReadApdmH5("Lumbar", ext_error="skip").iter_chunks(tmpf.name, n_samples=10)) == []
+        with pytest.raises(FileNotFoundError):
+            ReadApdmH5("Lumbar").iter_chunks("missing.h5", n_samples=10)
+
     def test_bad_sensor(self, apdm_file):
         with pytest.raises(SensorNotFoundError):
             ReadApdmH5("badSensor", gravity_acceleration=9.81).predict(apdm_file)
+
+    def test_time_range(self, apdm_file):
+        full = ReadApdmH5("Lumbar").predict(apdm_file)
+        t = full["time"]
+        t1, t2 = t[t.size // 4], t[t.size // 2]
+
+        res = ReadApdmH5("Lumbar", start_time=t1, stop_time=t2).predict(apdm_file)
+
+        mask = (t >= t1) & (t < t2)
+        assert allclose(res["time"], t[mask])
+        assert allclose(res["accel"], full["accel"][mask])
+        assert allclose(res["gyro"], full["gyro"][mask])
+        assert allclose(res["temperature"], full["temperature"][mask])
+
+        with pytest.raises(ValueError):
+            ReadApdmH5("Lumbar", start_time=t2, stop_time=t1)
+
+    @pytest.mark.parametrize("range_", (False, True))
+    def test_iter_chunks(self, apdm_file, range_):
+        kw = {}
+        if range_:
+            t = ReadApdmH5("Lumbar").predict(apdm_file)["time"]
+            kw = dict(start_time=t[t.size // 3], stop_time=t[-10])
+        rdr = ReadApdmH5("Lumbar", **kw)
+        full = rdr.predict(apdm_file)
+
+        chunks = list(rdr.iter_chunks(apdm_file, n_samples=full["time"].size // 4))
+
+        assert chunks[0]["index"] == 0
+        for c1, c2 in zip(chunks[:-1], chunks[1:]):
+            assert c2["index"] == c1["index"] + c1["time"].size
+        for k in ["time", "accel", "gyro", "temperature"]:
+            assert allclose(concatenate([c[k] for c in chunks]), full[k])
+
+        with pytest.raises(ValueError):
+            next(rdr.iter_chunks(apdm_file))
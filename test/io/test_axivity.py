@@ -1,14 +1,33 @@
+from concurrent.futures import ThreadPoolExecutor
 from tempfile import NamedTemporaryFile
+import struct
 
 import pytest
-from numpy import allclose, ndarray
+from numpy import (
+    allclose,
+    asarray,
+    ndarray,
+    ones,
+    diff,
+    concatenate,
+    array_equal,
+    float32,
+    int16,
+    int64,
+    inf,
+    shares_memory,
+)
 
-from skdh.io import ReadCwa, FileSizeError
+from skdh.io import ReadCwa, FileSizeError, ReadBuffers, counts_to_values
+from skdh.io._extensions import read_axivity
 
 
 class TestReadCwa:
-    def test_ax3(self, ax3_file, ax3_truth):
-        res = ReadCwa(bases=8, periods=12).predict(ax3_file)
+    @pytest.mark.parametrize(("use_mmap", "workers"), ((True, 1), (False, 1), (True, 4)))
+    def test_ax3(self, use_mmap, workers, ax3_file, ax3_truth):
+        res = ReadCwa(
+            bases=8, periods=12, use_mmap=use_mmap, workers=workers
+        ).predict(ax3_file)
 
         # make sure it will catch small differences
         assert allclose(
@@ -25,8 +44,11 @@ class TestReadCwa:
         assert all([i in res["day_ends"] for i in ax3_truth["day_ends"]])
         assert allclose(res["day_ends"][(8, 12)], ax3_truth["day_ends"][(8, 12)])
 
-    def test_ax6(self, ax6_file, ax6_truth):
-        res = ReadCwa(bases=8, periods=12).predict(ax6_file)
+    @pytest.mark.parametrize(("use_mmap", "workers"), ((True, 1), (False, 1), (True, 4)))
+    def test_ax6(self, use_mmap, workers, ax6_file, ax6_truth):
+        res = ReadCwa(
+            bases=8, periods=12, use_mmap=use_mmap, workers=workers
+        ).predict(ax6_file)
 
         # make sure it will catch small differences
         assert allclose(
@@ -43,6 +65,266 @@ class TestReadCwa:
         assert all([i in res["day_ends"] for i in ax6_truth["day_ends"]])
         assert allclose(res["day_ends"][(8, 12)], ax6_truth["day_ends"][(8, 12)])
 
+    @pytest.mark.parametrize("workers", (1, 3))
+    def test_skip_checksum(self, workers, ax6_file):
+        full = ReadCwa(bases=8, periods=12, workers=workers).predict(ax6_file)
+        res = ReadCwa(
+            bases=8, periods=12, workers=workers, verify_checksum=False
+        ).predict(ax6_file)
+
+        # all the blocks in the sample file are good
+        for k in ["time", "accel", "gyro", "temperature"]:
+            assert array_equal(res[k], full[k])
+        assert array_equal(res["day_ends"][(8, 12)], full["day_ends"][(8, 12)])
+
+    @pytest.mark.parametrize("workers", (1, 3))
+    def test_bad_blocks(self, workers, ax3_file, tmp_path):
+        data = bytearray(ax3_file.read_bytes())
+        n_blocks = len(data) // 512 - 2
+        # fail the checksum of runs of data blocks at the start, middle, and end
+        for block in [0, 1, 8, 9, 10, n_blocks - 1]:
+            data[(block + 2) * 512 + 100] ^= 0x55
+        bad_file = tmp_path / "bad.cwa"
+        bad_file.write_bytes(data)
+
+        full = ReadCwa(workers=workers).predict(ax3_file)
+        with pytest.warns(RuntimeWarning, match="6 bad data blocks"):
+            res = ReadCwa(workers=workers).predict(bad_file)
+
+        bs = full["time"].size // n_blocks
+        n = full["time"].size
+        assert full["bad_blocks"].shape == (0, 2)
+        assert array_equal(
+            res["bad_blocks"], [[0, 2 * bs], [8 * bs, 11 * bs], [n - bs, n]]
+        )
+
+        good = ones(n, dtype=bool)
+        for i1, i2 in res["bad_blocks"]:
+            good[i1:i2] = False
+            assert (res["accel"][i1:i2] == 0).all()
+        assert array_equal(res["accel"][good], full["accel"][good])
+
+        # repaired timestamps are close to the actual ones
+        assert (diff(res["time"]) > 0).all()
+        assert allclose(res["time"], full["time"], rtol=0, atol=0.05)
+
+        with pytest.warns(RuntimeWarning):
+            chunks = list(ReadCwa().iter_chunks(bad_file, n_blocks=4))
+        bad_blocks = concatenate([c["bad_blocks"] + c["index"] for c in chunks])
+        assert array_equal(bad_blocks, res["bad_blocks"])
+        assert array_equal(concatenate([c["time"] for c in chunks]), res["time"])
+
+        # the run of bad blocks in the middle spans chunks
+        with pytest.warns(RuntimeWarning):
+            chunks = list(ReadCwa().iter_chunks(bad_file, n_blocks=3))
+        assert array_equal(concatenate([c["time"] for c in chunks]), res["time"])
+
+    def test_concurrent(self, ax3_file, ax6_file):
+        # the same file twice, read at the same time as the stream reader
+        files = [ax3_file, ax6_file, ax3_file, ax6_file]
+        seq = [ReadCwa(bases=8, periods=12, use_mmap=False).predict(f) for f in files]
+
+        def read(file):
+            return ReadCwa(bases=8, periods=12, use_mmap=False).predict(file)
+
+        with ThreadPoolExecutor(max_workers=len(files)) as pool:
+            par = list(pool.map(read, files))
+
+        for r_seq, r_par in zip(seq, par):
+            for k in ["time", "accel", "temperature"]:
+                assert array_equal(r_par[k], r_seq[k])
+            assert array_equal(r_par["day_ends"][(8, 12)], r_seq["day_ends"][(8, 12)])
+
+    @pytest.mark.parametrize(
+        ("time_ns", "start"), ((False, None), (True, None), (False, 0.3))
+    )
+    def test_time_anchors(self, time_ns, start, ax3_file):
+        full = ReadCwa(bases=8, periods=12).predict(ax3_file)
+        if start is not None:
+            t0, t1 = full["time"][0], full["time"][-1]
+            start = t0 + start * (t1 - t0)
+
+        kw = dict(bases=8, periods=12, time_ns=time_ns, start_time=start)
+        truth = ReadCwa(**kw).predict(ax3_file)
+        res = ReadCwa(time_anchors=True, **kw).predict(ax3_file)
+
+        assert res["time"].size == truth["time"].size
+        assert res["time"].nbytes < truth["time"].nbytes // 10
+        # 1 microsecond
+        atol = 1000 if time_ns else 1e-6
+        assert allclose(asarray(res["time"]), truth["time"], rtol=0, atol=atol)
+        assert array_equal(res["accel"], truth["accel"])
+        assert array_equal(res["day_ends"][(8, 12)], truth["day_ends"][(8, 12)])
+
+    @pytest.mark.parametrize("n_blocks", (1, 7, 1000000))
+    def test_iter_chunks(self, n_blocks, ax6_file):
+        reader = ReadCwa(bases=8, periods=12)
+        full = reader.predict(ax6_file)
+        chunks = list(reader.iter_chunks(ax6_file, n_blocks=n_blocks))
+
+        assert chunks[0]["index"] == 0
+        assert chunks[-1]["index"] + chunks[-1]["time"].size == full["time"].size
+
+        for k in ["time", "accel", "gyro", "temperature"]:
+            assert array_equal(concatenate([c[k] for c in chunks]), full[k])
+
+        day_ends = concatenate([c["day_ends"][(8, 12)] for c in chunks])
+        assert array_equal(day_ends, full["day_ends"][(8, 12)])
+
+    def test_iter_chunks_seconds(self, ax3_file):
+        reader = ReadCwa()
+        full = reader.predict(ax3_file)
+        chunks = list(reader.iter_chunks(ax3_file, n_seconds=60))
+
+        # 60 seconds at 200hz, with 120 samples per block
+        assert all(c["time"].size == 12000 for c in chunks[:-1])
+        assert array_equal(concatenate([c["accel"] for c in chunks]), full["accel"])
+
+    def test_iter_chunks_size_error(self, ax3_file):
+        with pytest.raises(ValueError):
+            next(ReadCwa().iter_chunks(ax3_file))
+        with pytest.raises(ValueError):
+            next(ReadCwa().iter_chunks(ax3_file, n_blocks=5, n_seconds=5))
+
+    @pytest.mark.parametrize(("start", "stop"), ((0.25, 0.5), (None, 0.1), (0.9, None)))
+    def test_time_range(self, start, stop, ax6_file):
+        full = ReadCwa().predict(ax6_file)
+        t0, t1 = full["time"][0], full["time"][-1]
+
+        start = None if start is None else t0 + start * (t1 - t0)
+        stop = None if stop is None else t0 + stop * (t1 - t0)
+        res = ReadCwa(start_time=start, stop_time=stop).predict(ax6_file)
+
+        mask = (full["time"] >= (-inf if start is None else start)) & (
+            full["time"] < (inf if stop is None else stop)
+        )
+        assert array_equal(res["time"], full["time"][mask])
+        assert array_equal(res["accel"], full["accel"][mask])
+        assert array_equal(res["gyro"], full["gyro"][mask])
+
+    def test_time_range_windows(self, ax6_file):
+        full = ReadCwa(bases=[0, 8], periods=[24, 12]).predict(ax6_file)
+        res = ReadCwa(
+            bases=[0, 8],
+            periods=[24, 12],
+            start_time=full["time"][0] - 1,
+            stop_time=full["time"][-1] + 1,
+        ).predict(ax6_file)
+
+        assert array_equal(res["time"], full["time"])
+        for k in full["day_ends"]:
+            assert array_equal(res["day_ends"][k], full["day_ends"][k])
+
+    def test_time_range_error(self):
+        with pytest.raises(ValueError):
+            ReadCwa(start_time=10.0, stop_time=5.0)
+
+    @pytest.mark.parametrize("workers", (1, 4))
+    def test_dtype(self, workers, ax6_file):
+        full = ReadCwa(workers=workers).predict(ax6_file)
+        res32 = ReadCwa(workers=workers, dtype="float32").predict(ax6_file)
+        res16 = ReadCwa(workers=workers, dtype="int16", time_ns=True).predict(ax6_file)
+
+        assert res32["accel"].dtype == float32
+        assert res32["temperature"].dtype == float32
+        assert allclose(res32["accel"], full["accel"])
+
+        assert res16["accel"].dtype == int16
+        assert res16["gyro"].dtype == int16
+        for k in ["accel", "gyro"]:
+            # one scale for the whole recording
+            assert res16[f"{k}_scale"].shape == (1, 3)
+            assert array_equal(res16[f"{k}_scale_index"], [0])
+            values = (res16[k] - res16[f"{k}_offset"]) / res16[f"{k}_scale"]
+            assert array_equal(values, full[k])
+
+        assert res16["time"].dtype == int64
+        assert allclose(res16["time"] / 1e9, full["time"], rtol=0, atol=1e-6)
+
+    @pytest.mark.parametrize("workers", (1, 4))
+    def test_int16_range_change(self, workers, tmp_path, ax6_file):
+        data = bytearray(open(ax6_file, "rb").read())
+        nblocks = len(data) // 512
+
+        def set_checksum(i):
+            data[512 * i + 510 : 512 * (i + 1)] = b"\0\0"
+            total = sum(struct.unpack("<256H", bytes(data[512 * i : 512 * (i + 1)])))
+            data[512 * i + 510 : 512 * (i + 1)] = struct.pack("<H", -total & 0xFFFF)
+
+        # change the accel range half way through the recording
+        for i in range(2 + (nblocks - 2) // 2, nblocks):
+            (light,) = struct.unpack("<H", data[512 * i + 18 : 512 * i + 20])
+            light = (light & 0x1FFF) | (1 << 13)
+            data[512 * i + 18 : 512 * i + 20] = struct.pack("<H", light)
+            set_checksum(i)
+        # and put a block out of the range of the file
+        data[512 * 20 + 10 : 512 * 20 + 14] = struct.pack("<i", 10**7)
+        set_checksum(20)
+
+        file = tmp_path / "range.cwa"
+        file.write_bytes(data)
+
+        with pytest.warns(RuntimeWarning, match="1 bad data blocks"):
+            full = ReadCwa(workers=workers).predict(file)
+        with pytest.warns(RuntimeWarning, match="1 bad data blocks"):
+            res16 = ReadCwa(workers=workers, dtype="int16").predict(file)
+
+        block_samples = 40
+        assert array_equal(
+            res16["accel_scale_index"], [0, (nblocks - 2) // 2 * block_samples]
+        )
+        assert array_equal(res16["accel_scale"][:, 0], [2048.0, 512.0])
+        for k in ["accel", "gyro"]:
+            values = counts_to_values(
+                res16[k], res16[f"{k}_scale"], res16[f"{k}_offset"],
+                res16[f"{k}_scale_index"]
+            )
+            assert array_equal(values, full[k])
+
+        # the bad block is left as 0
+        assert (full["accel"][18 * block_samples : 19 * block_samples] == 0).all()
+
+        with pytest.raises(ValueError, match="scale_index"):
+            counts_to_values(res16["accel"], res16["accel_scale"], 0.0)
+
+    @pytest.mark.parametrize("dtype", ("float64", "int16"))
+    def test_buffers(self, dtype, ax3_file, ax6_file):
+        buffers = ReadBuffers()
+        reader = ReadCwa(bases=8, periods=12, dtype=dtype, buffers=buffers)
+
+        # files of different sizes, all decoded into the same storage
+        for file in [ax6_file, ax3_file, ax6_file]:
+            truth = ReadCwa(bases=8, periods=12, dtype=dtype).predict(file)
+            res = reader.predict(file)
+
+            for k in ["time", "accel", "temperature", "bad_blocks"]:
+                assert array_equal(res[k], truth[k])
+            assert array_equal(res["day_ends"][(8, 12)], truth["day_ends"][(8, 12)])
+
+            # no copies out of the buffers, including the sensors of 6 axis files
+            names = {
+                "accel": "imu",
+                "gyro": "imu",
+                "time": "time",
+                "temperature": "temperature",
+            }
+            for k, name in names.items():
+                if k in res:
+                    assert shares_memory(res[k], buffers._buffers[name])
+        assert buffers.nbytes > 0
+
+        with pytest.raises(ValueError):
+            ReadCwa(buffers={})
+
+    def test_buffers_too_small(self, ax3_file):
+        bases, periods = asarray([0]), asarray([12])
+        with pytest.raises(ValueError, match="out_imu"):
+            read_axivity(str(ax3_file), bases, periods, True, 1, "float64", False, True, ones(10))
+
+    def test_dtype_error(self):
+        with pytest.raises(ValueError):
+            ReadCwa(dtype="float16")
+
     def test_window_inputs(self):
         r = ReadCwa(bases=None, periods=None)
         assert not r.window
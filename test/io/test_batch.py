@@ -0,0 +1,73 @@
+import pytest
+from numpy import array_equal
+
+from skdh.io import ReadBatch, ReadCwa, ReadBin, ReadBuffers
+
+
+class TestReadBatch:
+    @pytest.mark.parametrize("ordered", (True, False))
+    def test_batch(self, ordered, ax3_file, ax6_file, gnactv_file, tmp_path):
+        bad = tmp_path / "bad.cwa"
+        bad.write_bytes(b"abc")
+
+        files = [ax3_file, gnactv_file, bad, ax6_file, ax3_file, tmp_path / "none.bin"]
+
+        results = list(
+            ReadBatch(max_workers=3, ordered=ordered, bases=8, periods=12).iter(files)
+        )
+
+        assert len(results) == len(files)
+        if ordered:
+            assert [r.index for r in results] == list(range(len(files)))
+        results = sorted(results, key=lambda r: r.index)
+
+        # per-file errors do not stop the batch
+        assert [r.ok for r in results] == [True, True, False, True, True, False]
+        assert results[2].data is None
+        assert isinstance(results[5].error, FileNotFoundError)
+
+        for r in results:
+            if not r.ok:
+                continue
+            rdr = ReadBin if r.file.suffix == ".bin" else ReadCwa
+            truth = rdr(bases=8, periods=12).predict(r.file)
+
+            for k in ["time", "accel", "temperature"]:
+                assert array_equal(r.data[k], truth[k])
+            assert array_equal(r.data["day_ends"][(8, 12)], truth["day_ends"][(8, 12)])
+
+    def test_readers(self, ax6_file, gnactv_file):
+        res = ReadBatch(readers={".CWA": ReadCwa(dtype="float32")}).predict(
+            [gnactv_file, ax6_file]
+        )
+
+        assert [r.index for r in res] == [0, 1]
+        assert not res[0].ok
+        assert isinstance(res[0].error, ValueError)
+        assert res[1].ok
+        assert res[1].data["accel"].dtype == "float32"
+
+    @pytest.mark.parametrize("ordered", (True, False))
+    def test_buffers(self, ordered, ax3_file, ax6_file, gnactv_file):
+        # different files read at the same time with the same reader buffers
+        files = [ax3_file, ax6_file, gnactv_file, ax6_file, ax3_file]
+        batch = ReadBatch(
+            max_workers=2, ordered=ordered, bases=8, periods=12, buffers=ReadBuffers()
+        )
+
+        results = []
+        for r in batch.iter(files):
+            assert r.ok
+            rdr = ReadBin if r.file.suffix == ".bin" else ReadCwa
+            truth = rdr(bases=8, periods=12).predict(r.file)
+
+            # the data are only valid until the next result
+            for k in ["time", "accel", "temperature"]:
+                assert array_equal(r.data[k], truth[k])
+            assert array_equal(r.data["day_ends"][(8, 12)], truth["day_ends"][(8, 12)])
+            results.append(r.index)
+
+        assert sorted(results) == list(range(len(files)))
+
+        with pytest.raises(ValueError):
+            batch.predict(files)
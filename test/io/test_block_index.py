@@ -0,0 +1,163 @@
+from os import utime
+from shutil import copy
+
+import pytest
+from numpy import allclose, array_equal, clip, inf
+
+from skdh.io import ReadCwa, ReadBin, BlockIndex, get_block_index
+
+
+BASES = [0, 8, 9, 12, 20]
+PERIODS = [24, 12, 1, 6, 23]
+
+
+class TestBlockIndex:
+    @pytest.mark.parametrize("reader", ["ax3_file", "ax6_file", "gnactv_file"])
+    def test_build(self, reader, request):
+        file = request.getfixturevalue(reader)
+        rdr = ReadBin if file.suffix == ".bin" else ReadCwa
+
+        res = rdr(bases=BASES, periods=PERIODS).predict(file)
+        index = BlockIndex.build(file)
+
+        assert index.n_samples == res["time"].size
+
+        good = index.status == 0
+        assert allclose(
+            index.time[good],
+            res["time"][index.sequence[good] * index.block_samples],
+            rtol=0,
+            atol=1e-9,
+        )
+
+        day_ends = index.day_ends(BASES, PERIODS)
+        for k in res["day_ends"]:
+            assert array_equal(day_ends[k], res["day_ends"][k])
+
+    def test_sidecar(self, ax6_file, tmp_path):
+        file = tmp_path / ax6_file.name
+        copy(ax6_file, file)
+
+        assert BlockIndex.load(file) is None
+
+        index = get_block_index(file)
+        assert BlockIndex.sidecar_path(file).is_file()
+
+        loaded = BlockIndex.load(file)
+        assert loaded is not None
+        for k in BlockIndex._arrays:
+            assert array_equal(getattr(loaded, k), getattr(index, k))
+
+        # modifying the data file makes the index stale
+        utime(file, ns=(index.file_mtime + 10**9, index.file_mtime + 10**9))
+        assert BlockIndex.load(file) is None
+
+        rebuilt = get_block_index(file)
+        assert rebuilt.is_current
+        assert BlockIndex.load(file) is not None
+
+        # only the sidecar is left behind by saving
+        assert [p.name for p in tmp_path.iterdir() if p != file] == [
+            BlockIndex.sidecar_path(file).name
+        ]
+
+    @pytest.mark.parametrize("content", [b"", b"PK\x03\x04 truncated"])
+    def test_sidecar_corrupt(self, content, ax6_file, tmp_path):
+        file = tmp_path / ax6_file.name
+        copy(ax6_file, file)
+
+        path = BlockIndex.sidecar_path(file)
+        path.write_bytes(content)
+        assert BlockIndex.load(file) is None
+
+        # a corrupt sidecar is replaced
+        assert get_block_index(file).is_current
+        assert BlockIndex.load(file) is not None
+
+    def test_reader_index(self, gnactv_file, tmp_path):
+        file = tmp_path / gnactv_file.name
+        copy(gnactv_file, file)
+
+        truth = ReadBin(bases=BASES, periods=PERIODS, index=False).predict(file)
+        assert not BlockIndex.sidecar_path(file).is_file()
+
+        # recorded while parsing, then used for the windows of the next read
+        for _ in range(2):
+            res = ReadBin(bases=BASES, periods=PERIODS, index=True).predict(file)
+            assert BlockIndex.load(file) is not None
+
+            assert array_equal(res["accel"], truth["accel"])
+            for k in truth["day_ends"]:
+                assert array_equal(res["day_ends"][k], truth["day_ends"][k])
+
+        index = BlockIndex.load(file)
+        built = BlockIndex.build(file)
+        for k in BlockIndex._arrays:
+            assert array_equal(getattr(index, k), getattr(built, k))
+
+    @pytest.mark.parametrize("workers", (1, 3))
+    def test_reader_index_cwa(self, workers, ax3_file, tmp_path):
+        # bad data blocks, which change the block times and windows after them
+        data = bytearray(ax3_file.read_bytes())
+        n_blocks = len(data) // 512 - 2
+        for block in [1, 8, 9, n_blocks - 1]:
+            data[(block + 2) * 512 + 100] ^= 0x55
+        file = tmp_path / "bad.cwa"
+        file.write_bytes(data)
+
+        kw = dict(bases=BASES, periods=PERIODS, workers=workers)
+        with pytest.warns(RuntimeWarning):
+            truth = ReadCwa(**kw).predict(file)
+
+        # recorded while decoding, then used for the next read
+        for _ in range(2):
+            with pytest.warns(RuntimeWarning):
+                res = ReadCwa(index=True, **kw).predict(file)
+            assert BlockIndex.load(file, verify=True) is not None
+
+            for k in ["time", "accel", "temperature", "bad_blocks"]:
+                assert array_equal(res[k], truth[k])
+            for k in truth["day_ends"]:
+                assert array_equal(res["day_ends"][k], truth["day_ends"][k])
+
+        index = BlockIndex.load(file)
+        built = BlockIndex.build(file)
+        for k in BlockIndex._arrays:
+            assert array_equal(getattr(index, k), getattr(built, k))
+
+        # an index of which blocks are bad only applies with the same verification
+        assert BlockIndex.load(file, verify=False) is None
+
+    @pytest.mark.parametrize(("start", "stop"), ((0.25, 0.5), (None, 0.1), (0.9, None)))
+    def test_reader_index_range(self, start, stop, ax6_file, tmp_path):
+        file = tmp_path / ax6_file.name
+        copy(ax6_file, file)
+        get_block_index(file)
+
+        full = ReadCwa(bases=BASES, periods=PERIODS).predict(file)
+        t0, t1 = full["time"][0], full["time"][-1]
+        start = None if start is None else t0 + start * (t1 - t0)
+        stop = None if stop is None else t0 + stop * (t1 - t0)
+
+        kw = dict(bases=BASES, periods=PERIODS, start_time=start, stop_time=stop)
+        truth = ReadCwa(**kw).predict(file)
+        res = ReadCwa(index=True, **kw).predict(file)
+
+        for k in ["time", "accel", "gyro", "temperature"]:
+            assert array_equal(res[k], truth[k])
+
+        # windows of the whole file, cut off at the ends of the range
+        mask = (full["time"] >= (-inf if start is None else start)) & (
+            full["time"] < (inf if stop is None else stop)
+        )
+        first, n = mask.argmax(), mask.sum()
+        for k in full["day_ends"]:
+            win = clip(full["day_ends"][k] - first, 0, n - 1)
+            assert array_equal(res["day_ends"][k], win[win[:, 1] > win[:, 0]])
+
+    def test_extension_error(self, tmp_path):
+        file = tmp_path / "test.abc"
+        file.write_bytes(b"abc")
+
+        with pytest.raises(ValueError):
+            BlockIndex.build(file)
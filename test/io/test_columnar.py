@@ -0,0 +1,116 @@
+import pytest
+from numpy import allclose, asarray, array_equal, clip, float32, int16
+
+from skdh.io import ReadCwa, ReadBin, ReadColumnar, WriteColumnar
+from skdh.utility.time_anchors import TimeAnchors
+
+
+class TestColumnar:
+    @pytest.mark.parametrize("compression", (None, "zlib"))
+    @pytest.mark.parametrize("mmap", (True, False))
+    def test_round_trip(self, tmp_path, ax6_file, compression, mmap):
+        truth = ReadCwa().predict(ax6_file)
+
+        out = WriteColumnar(
+            save_name=str(tmp_path / "{file}.skdhcol"),
+            chunk_seconds=60.0,
+            compression=compression,
+        ).predict(**truth)
+        assert out["cache_file"] == str(tmp_path / "ax6_sample.skdhcol")
+
+        res = ReadColumnar(mmap=mmap).predict(file=out["cache_file"])
+
+        assert res["fs"] == truth["fs"]
+        assert allclose(res["time"], truth["time"], rtol=0, atol=1e-6)
+        for k in ["accel", "gyro", "temperature"]:
+            assert res[k].dtype == float32
+            assert allclose(res[k], truth[k], atol=1e-5)
+            # uncompressed columns are views of the mapped file, and can be modified
+            assert res[k].flags.owndata != (mmap and compression is None)
+            assert res[k].flags.writeable
+
+    def test_geneactiv(self, tmp_path, gnactv_file):
+        truth = ReadBin(bases=8, periods=12).predict(gnactv_file)
+
+        out = WriteColumnar(save_name=str(tmp_path / "data.skdhcol")).predict(**truth)
+        res = ReadColumnar(bases=8, periods=12).predict(file=out["cache_file"])
+
+        # anchors at the 300 sample data pages
+        assert allclose(res["time"], truth["time"], rtol=0, atol=1e-6)
+        for k in ["accel", "temperature", "light"]:
+            assert allclose(res[k], truth[k], atol=1e-5)
+        assert array_equal(res["day_ends"][(8, 12)], truth["day_ends"][(8, 12)])
+
+    def test_int16(self, tmp_path, ax3_file):
+        truth = ReadCwa(dtype="int16").predict(ax3_file)
+
+        out = WriteColumnar(save_name=str(tmp_path / "data.skdhcol")).predict(**truth)
+        res = ReadColumnar(time_anchors=True).predict(file=out["cache_file"])
+
+        assert isinstance(res["time"], TimeAnchors)
+        # anchors at the data blocks, from the full timestamps
+        assert allclose(asarray(res["time"]), truth["time"], rtol=0, atol=1e-6)
+        assert res["accel"].dtype == int16
+        assert array_equal(res["accel"], truth["accel"])
+        assert array_equal(res["accel_scale"], truth["accel_scale"])
+        assert array_equal(res["accel_scale_index"], truth["accel_scale_index"])
+        assert array_equal(res["accel_offset"], truth["accel_offset"])
+
+        with pytest.raises(ValueError, match="not raw sensor counts"):
+            WriteColumnar(dtype="int16").predict(
+                file=ax3_file, **ReadCwa().predict(ax3_file)
+            )
+
+        # full timestamps without the data block size
+        del truth["block_samples"]
+        with pytest.raises(ValueError, match="block_samples"):
+            WriteColumnar(save_name=str(tmp_path / "data.skdhcol")).predict(**truth)
+
+    @pytest.mark.parametrize("time_anchors", (True, False))
+    def test_time_range_windows(self, tmp_path, ax3_file, time_anchors):
+        full = ReadCwa(bases=8, periods=12, time_anchors=time_anchors).predict(ax3_file)
+        out = WriteColumnar(
+            save_name=str(tmp_path / "data.skdhcol"), chunk_seconds=30.0
+        ).predict(**full)
+
+        t = asarray(full["time"])
+
+        # the windows of the device reader
+        res = ReadColumnar(bases=8, periods=12).predict(file=out["cache_file"])
+        assert array_equal(res["day_ends"][(8, 12)], full["day_ends"][(8, 12)])
+
+        # range ends between samples
+        i1, i2 = t.size // 3, t.size // 2
+        t1, t2 = (t[i1] + t[i1 + 1]) / 2, (t[i2] + t[i2 + 1]) / 2
+        res = ReadColumnar(
+            bases=8, periods=12, start_time=t1, stop_time=t2, time_anchors=True
+        ).predict(file=out["cache_file"])
+        mask = (t >= t1) & (t < t2)
+
+        assert allclose(asarray(res["time"]), t[mask], rtol=0, atol=1e-6)
+        assert allclose(res["accel"], full["accel"][mask], atol=1e-5)
+
+        # range ends at samples, the same as comparing the stored timestamps
+        tc = ReadColumnar().predict(file=out["cache_file"])["time"]
+        res = ReadColumnar(start_time=tc[i1], stop_time=tc[i2]).predict(
+            file=out["cache_file"]
+        )
+        assert res["time"].size == i2 - i1
+        assert allclose(res["time"], tc[i1:i2], rtol=0, atol=1e-6)
+
+        # windows of the whole file, cut off at the ends of the range
+        win = clip(full["day_ends"][(8, 12)] - mask.argmax(), 0, mask.sum() - 1)
+        assert array_equal(res["day_ends"][(8, 12)], win[win[:, 1] > win[:, 0]])
+
+        # windows that were not stored are computed from the timestamps
+        res = ReadColumnar(bases=[8, 0], periods=[12, 24]).predict(
+            file=out["cache_file"]
+        )
+        assert list(res["day_ends"]) == [(8, 12), (0, 24)]
+
+    def test_not_cache(self, tmp_path):
+        file = tmp_path / "bad.skdhcol"
+        file.write_bytes(b"\x00" * 2000)
+
+        with pytest.raises(ValueError, match="not a columnar cache"):
+            ReadColumnar().predict(file=file)
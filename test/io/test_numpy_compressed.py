@@ -0,0 +1,76 @@
+import pytest
+from numpy import allclose, array_equal, arange, random, memmap, savez_compressed, save, zeros
+
+from skdh.io import ReadNumpyFile, WriteNumpyFile
+
+
+@pytest.fixture
+def reader_output():
+    rng = random.default_rng(5)
+    n = 5000
+    return {
+        "time": 1.6e9 + arange(n) / 50.0,
+        "accel": rng.normal(size=(n, 3)),
+        "temperature": rng.normal(size=n) + 25.0,
+        "fs": 50.0,
+        "day_ends": {(8, 12): arange(6).reshape((3, 2)), (0, 24): arange(2).reshape((1, 2))},
+    }
+
+
+class TestWriteReadNumpyFile:
+    @pytest.mark.parametrize("mmap", (False, True))
+    def test_round_trip(self, tmp_path, reader_output, mmap):
+        src = tmp_path / "data.cwa"
+        out = WriteNumpyFile().predict(file=str(src), **reader_output)
+
+        assert out["numpy_file"] == str(tmp_path / "data.cwa.skdh.npz")
+
+        res = ReadNumpyFile(mmap=mmap).predict(file=out["numpy_file"])
+
+        for k in ["time", "accel", "temperature"]:
+            assert array_equal(res[k], reader_output[k])
+            assert isinstance(res[k], memmap) == mmap
+        assert res["fs"] == 50.0
+        assert res["day_ends"].keys() == reader_output["day_ends"].keys()
+        for k in reader_output["day_ends"]:
+            assert array_equal(res["day_ends"][k], reader_output["day_ends"][k])
+
+    def test_save_name(self, tmp_path, reader_output):
+        src = tmp_path / "data.cwa"
+        save_name = str(tmp_path / "{file}_ingested.npz")
+
+        out = WriteNumpyFile(save_name=save_name, keys=["time", "accel"]).predict(
+            file=str(src), **reader_output
+        )
+        assert out["numpy_file"] == str(tmp_path / "data_ingested.npz")
+
+        res = ReadNumpyFile(mmap=True).predict(file=out["numpy_file"])
+        assert "temperature" not in res
+        assert "day_ends" not in res
+        assert allclose(res["accel"], reader_output["accel"])
+
+    def test_compressed_mmap(self, tmp_path, reader_output):
+        # compressed arrays can not be mapped, and are read into memory
+        file = tmp_path / "data.npz"
+        savez_compressed(file, time=reader_output["time"], accel=reader_output["accel"])
+
+        res = ReadNumpyFile(mmap=True).predict(file=file)
+
+        assert not isinstance(res["accel"], memmap)
+        assert array_equal(res["accel"], reader_output["accel"])
+
+    def test_npy(self, tmp_path, reader_output):
+        file = tmp_path / "data.npy"
+        arr = zeros(reader_output["time"].size, dtype=[("time", "f8"), ("accel", "f8", (3,))])
+        arr["time"] = reader_output["time"]
+        arr["accel"] = reader_output["accel"]
+        save(file, arr)
+
+        res = ReadNumpyFile(mmap=True).predict(file=file)
+
+        assert array_equal(res["time"], reader_output["time"])
+        assert array_equal(res["accel"], reader_output["accel"])
+
+        save(file, reader_output["accel"])
+        with pytest.raises(ValueError, match="structured array"):
+            ReadNumpyFile(mmap=True).predict(file=file)
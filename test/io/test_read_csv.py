@@ -1,8 +1,8 @@
 import pytest
-from numpy import isclose, allclose, array
+from numpy import isclose, allclose, array, arange, random, savetxt, column_stack, delete, array_equal
 
 from skdh.io import ReadCSV
-from skdh.io.csv import handle_timestamp_inconsistency, handle_accel, handle_windows
+from skdh.io.csv import handle_timestamp_inconsistency, handle_accel, handle_windows, handle_windows_seconds
 
 
 class TestHandleTimestampInconsistency:
@@ -90,3 +90,107 @@ class TestHandleWindows:
         assert len(out) == 2
         assert allclose(out[(14, 3)], truth_14_3)
         assert allclose(out[(10, 8)], truth_10_8)
+
+
+class TestHandleWindowsSeconds:
+    def test_matches_datetime(self, dummy_csv_contents):
+        raw, fs, n_full = dummy_csv_contents(drop=False)
+        time_dt = raw['_datetime_']
+        time = time_dt.astype(int).values / 1e9
+
+        out = handle_windows_seconds(time, [14, 10, 0], [3, 8, 24], run_windowing=True)
+        truth = handle_windows(time_dt, [14, 10, 0], [3, 8, 24], run_windowing=True)
+
+        assert out.keys() == truth.keys()
+        for k in truth:
+            assert array_equal(out[k], truth[k])
+
+        assert handle_windows_seconds(time, [0], [24], run_windowing=False) == {}
+
+
+class TestReadCSVNative:
+    @staticmethod
+    def write_csv(path, gap=True):
+        # 30 hours of data at 2hz, starting at noon, with a 10 minute gap
+        fs = 2.0
+        t = 1591444800 + arange(0, 30 * 3600, 1 / fs)
+        acc = random.default_rng(1357).normal(size=(t.size, 3))
+        if gap:
+            t = delete(t, range(5000, 6200))
+            acc = delete(acc, range(5000, 6200), axis=0)
+
+        savetxt(path, column_stack((t, acc)), delimiter=",", fmt="%.6f", header="ts,ax,ay,az", comments="")
+        return fs
+
+    @pytest.mark.parametrize("workers", (1, 4))
+    def test_matches_pandas(self, tmp_path, workers):
+        file = tmp_path / "data.csv"
+        fs = self.write_csv(file)
+
+        kw = dict(
+            time_col_name="ts",
+            accel_col_names=["ax", "ay", "az"],
+            to_datetime_kwargs={"unit": "s"},
+            bases=[8, 0],
+            periods=[12, 24],
+        )
+        res_pd = ReadCSV(**kw).predict(file=file)
+        res_nt = ReadCSV(engine="native", workers=workers, **kw).predict(file=file)
+
+        assert isclose(res_nt["fs"], fs)
+        assert isclose(res_nt["fs"], res_pd["fs"])
+        assert res_nt["time"].size == 30 * 3600 * fs
+        assert allclose(res_nt["time"], res_pd["time"])
+        assert allclose(res_nt["accel"], res_pd["accel"])
+        assert allclose(res_nt["accel"][5000:6200], [0.0, 0.0, 1.0])
+
+        assert res_nt["day_ends"].keys() == res_pd["day_ends"].keys()
+        for k in res_pd["day_ends"]:
+            assert array_equal(res_nt["day_ends"][k], res_pd["day_ends"][k])
+
+    def test_not_in_g(self, tmp_path):
+        file = tmp_path / "data.csv"
+        self.write_csv(file, gap=False)
+
+        kw = dict(time_col_name="ts", accel_col_names=["ax", "ay", "az"], to_datetime_kwargs={"unit": "s"})
+        res_g = ReadCSV(engine="native", **kw).predict(file=file)
+        res_ms2 = ReadCSV(engine="native", accel_in_g=False, g_value=9.81, **kw).predict(file=file)
+
+        assert allclose(res_ms2["accel"] * 9.81, res_g["accel"])
+
+    def test_gaps_no_fill(self, tmp_path):
+        file = tmp_path / "data.csv"
+        self.write_csv(file)
+
+        rdr = ReadCSV("ts", ["ax", "ay", "az"], fill_gaps=False, to_datetime_kwargs={"unit": "s"}, engine="native")
+
+        with pytest.raises(ValueError, match="data gaps"):
+            rdr.predict(file=file)
+
+    def test_bad_row(self, tmp_path):
+        file = tmp_path / "data.csv"
+        # an unused header column, so the file is over the 1kb minimum size
+        file.write_text(f"ts,ax,ay,az,{'x' * 1000}\n0.0,1,0,0\n0.5,1,0,0\n1.0,1,a,0\n")
+
+        rdr = ReadCSV("ts", ["ax", "ay", "az"], to_datetime_kwargs={"unit": "s"}, engine="native")
+
+        with pytest.raises(ValueError, match="row 3"):
+            rdr.predict(file=file)
+
+    @pytest.mark.parametrize("engine", ("pandas", "native"))
+    def test_no_rows(self, tmp_path, engine):
+        file = tmp_path / "data.csv"
+        file.write_text(f"ts,ax,ay,az,{'x' * 1000}\n")
+
+        rdr = ReadCSV("ts", ["ax", "ay", "az"], to_datetime_kwargs={"unit": "s"}, engine=engine)
+
+        with pytest.raises(ValueError, match="No data rows"):
+            rdr.predict(file=file)
+
+    def test_unsupported_options(self):
+        with pytest.raises(ValueError):
+            ReadCSV("ts", ["ax", "ay", "az"], engine="other")
+        with pytest.raises(ValueError):
+            ReadCSV("ts", ["ax", "ay", "az"], to_datetime_kwargs={"format": "%Y"}, engine="native")
+        with pytest.raises(ValueError):
+            ReadCSV("ts", ["ax", "ay", "az"], read_csv_kwargs={"skiprows": 2}, engine="native")
@@ -1,9 +1,10 @@
+from datetime import datetime, timedelta
 from tempfile import NamedTemporaryFile
 
 import pytest
-from numpy import allclose, ndarray
+from numpy import allclose, array_equal, asarray, diff, ndarray, float32, int16, int64
 
-from skdh.io import ReadBin, FileSizeError
+from skdh.io import ReadBin, FileSizeError, ReadBuffers
 
 
 class TestReadBin:
@@ -24,6 +25,94 @@ class TestReadBin:
         assert all([i in res["day_ends"] for i in gnactv_truth["day_ends"]])
         assert allclose(res["day_ends"][(8, 12)], gnactv_truth["day_ends"][(8, 12)])
 
+    def test_dtype(self, gnactv_file):
+        full = ReadBin().predict(gnactv_file)
+        res32 = ReadBin(dtype="float32").predict(gnactv_file)
+        res16 = ReadBin(dtype="int16", time_ns=True).predict(gnactv_file)
+
+        assert res32["accel"].dtype == float32
+        assert res32["light"].dtype == float32
+        assert allclose(res32["accel"], full["accel"])
+
+        assert res16["accel"].dtype == int16
+        values = (res16["accel"] - res16["accel_offset"]) / res16["accel_scale"]
+        assert allclose(values, full["accel"])
+
+        assert res16["time"].dtype == int64
+        assert allclose(res16["time"] / 1e9, full["time"], rtol=0, atol=1e-6)
+
+    def test_time_anchors(self, gnactv_file):
+        full = ReadBin(bases=8, periods=12).predict(gnactv_file)
+        res = ReadBin(bases=8, periods=12, time_anchors=True).predict(gnactv_file)
+
+        assert res["time"].size == full["time"].size
+        assert allclose(asarray(res["time"]), full["time"], rtol=0, atol=1e-6)
+        assert array_equal(res["accel"], full["accel"])
+        assert array_equal(res["day_ends"][(8, 12)], full["day_ends"][(8, 12)])
+
+    @pytest.mark.parametrize("use_mmap, workers", [(True, 1), (True, 3), (False, 4)])
+    def test_mmap_workers(self, gnactv_file, use_mmap, workers):
+        ref = ReadBin(bases=[8, 0], periods=[12, 24], use_mmap=False).predict(
+            gnactv_file
+        )
+        res = ReadBin(
+            bases=[8, 0], periods=[12, 24], use_mmap=use_mmap, workers=workers
+        ).predict(gnactv_file)
+
+        for k in ["time", "accel", "temperature", "light"]:
+            assert array_equal(res[k], ref[k])
+        for k in ref["day_ends"]:
+            assert array_equal(res["day_ends"][k], ref["day_ends"][k])
+
+    def test_long_recording(self, gnactv_file, tmp_path):
+        # pages one hour apart make a 33 day recording, longer than the window
+        # storage originally allocated
+        lines = gnactv_file.read_bytes().split(b"\n")
+        i = lines.index(b"Recorded Data")
+        header = [
+            b"Number of Pages:800" if ln.startswith(b"Number of Pages") else ln
+            for ln in lines[:i]
+        ]
+        page = lines[i : i + 10]
+
+        t0 = datetime(2019, 5, 21, 23, 59, 58, 500000)
+        out = header
+        for k in range(800):
+            t = t0 + timedelta(hours=k)
+            page[2] = b"Sequence Number:%d" % k
+            page[3] = b"Page Time:" + t.strftime("%Y-%m-%d %H:%M:%S:%f")[:-3].encode()
+            out += page
+
+        file = tmp_path / "long.bin"
+        file.write_bytes(b"\n".join(out) + b"\n")
+
+        res = ReadBin(bases=8, periods=12).predict(file)
+        days = res["day_ends"][(8, 12)]
+
+        assert days.shape[0] == 33
+        assert (diff(days[:, 0]) == 24 * 300).all()
+
+    @pytest.mark.parametrize("dtype", ("float64", "float32"))
+    def test_buffers(self, dtype, gnactv_file):
+        buffers = ReadBuffers()
+        reader = ReadBin(bases=8, periods=12, dtype=dtype, buffers=buffers)
+        truth = ReadBin(bases=8, periods=12, dtype=dtype).predict(gnactv_file)
+
+        # the second read re-uses the storage of the first
+        res1 = reader.predict(gnactv_file)
+        nbytes = buffers.nbytes
+        res2 = reader.predict(gnactv_file)
+
+        assert buffers.nbytes == nbytes
+        for res in [res1, res2]:
+            for k in ["time", "accel", "temperature", "light"]:
+                assert array_equal(res[k], truth[k])
+            assert array_equal(res["day_ends"][(8, 12)], truth["day_ends"][(8, 12)])
+
+    def test_dtype_error(self):
+        with pytest.raises(ValueError):
+            ReadBin(dtype="float16")
+
     def test_window_inputs(self):
         r = ReadBin(bases=None, periods=None)
         assert not r.window
@@ -1,5 +1,5 @@
 import pytest
-from numpy import allclose, array, arange
+from numpy import allclose, array, arange, asarray
 
 from skdh.utility.internal import (
     get_day_index_intersection,
@@ -7,6 +7,7 @@ from skdh.utility.internal import (
     rle,
     invert_indices,
 )
+from skdh.utility.time_anchors import TimeAnchors
 
 
 class TestGetDayIndexIntersection:
@@ -120,6 +121,19 @@ class TestApplyDownsample:
         assert allclose(idx_ds_1, dummy_idx_1d[1])
         assert allclose(idx_ds_2, dummy_idx_2d[1])
 
+    def test_time_anchors(self, dummy_time, dummy_idx_1d, np_rng):
+        x = np_rng.random((dummy_time.size, 3))
+        anchors = TimeAnchors.from_time(dummy_time, 100, 50.0)
+        tds, (x_ds,), (idx_ds,) = apply_downsample(
+            10.0, anchors, (x,), (dummy_idx_1d[0],), fs=50.0
+        )
+        truth = apply_downsample(10.0, dummy_time, (x,), (dummy_idx_1d[0],), fs=50.0)
+
+        assert isinstance(tds, TimeAnchors)
+        assert allclose(asarray(tds), truth[0])
+        assert allclose(x_ds, truth[1][0])
+        assert allclose(idx_ds, truth[2][0])
+
     def test_none(self, dummy_time):
         tds, (acc_ds,), (idx_ds,) = apply_downsample(10.0, dummy_time, (None,), (None,))
 
@@ -1,7 +1,23 @@
 from collections.abc import Iterable
+from concurrent.futures import ThreadPoolExecutor
 
 import pytest
-from numpy import allclose, mean, std, median, max, min, nan, full
+from numpy import (
+    allclose,
+    array_equal,
+    array_split,
+    concatenate,
+    asarray,
+    ascontiguousarray,
+    moveaxis,
+    mean,
+    std,
+    median,
+    max,
+    min,
+    nan,
+    full,
+)
 from scipy.stats import skew, kurtosis
 
 from skdh.utility.windowing import get_windowed_view
@@ -13,6 +29,8 @@ from skdh.utility.math import (
     moving_median,
     moving_max,
     moving_min,
+    moving_stats,
+    MovingStatsAccumulator,
 )
 
 
@@ -107,6 +125,36 @@ class BaseMovingStatsTester:
         else:
             assert pred.shape == out_shape
 
+    @pytest.mark.parametrize("trim", (True, False))
+    def test_workers(self, trim, np_rng):
+        x = np_rng.random((7, 2000))
+
+        pred1 = self.function(x, 150, 7, trim=trim, axis=-1)
+        pred4 = self.function(x, 150, 7, trim=trim, axis=-1, workers=4)
+
+        if isinstance(pred1, tuple):
+            for p1, p4 in zip(pred1, pred4):
+                assert allclose(p1, p4, equal_nan=True)
+        else:
+            assert allclose(pred1, pred4, equal_nan=True)
+
+    @pytest.mark.parametrize("order", ("C", "F"))
+    def test_strided_axis(self, order, np_rng):
+        x = np_rng.random((3, 2000, 4))
+        # non-contiguous along every axis
+        xs = asarray(x, order=order)[:, ::2, 1:]
+
+        truth = self.function(ascontiguousarray(moveaxis(xs, 1, -1)), 150, 7)
+        pred = self.function(xs, 150, 7, axis=1)
+
+        if isinstance(pred, tuple):
+            for p, t in zip(pred, truth):
+                assert p.flags["C_CONTIGUOUS"]
+                assert allclose(p, moveaxis(t, -1, 1))
+        else:
+            assert pred.flags["C_CONTIGUOUS"]
+            assert allclose(pred, moveaxis(truth, -1, 1))
+
     def test_window_length_shape_error(self, np_rng):
         x = np_rng.random((5, 10))
 
@@ -163,14 +211,157 @@ class TestMovingMedian(BaseMovingStatsTester):
     truth_function = staticmethod(median)
     truth_kw = {}
 
+    def test_threads(self, np_rng):
+        # the GIL is released during computation, make sure concurrent calls
+        # with different window lengths dont share heap state
+        x = np_rng.random((8, 5000))
+        wlens = [3, 4, 51, 100, 7, 250, 2, 33]
+        truth = [moving_median(x[i], w, 1) for i, w in enumerate(wlens)]
+
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            for _ in range(5):
+                pred = list(pool.map(lambda a: moving_median(*a, 1), zip(x, wlens)))
+
+                for p, t in zip(pred, truth):
+                    assert allclose(p, t)
+
 
 class TestMovingMax(BaseMovingStatsTester):
     function = staticmethod(moving_max)
     truth_function = staticmethod(max)
     truth_kw = {}
 
+    @pytest.mark.parametrize("axis", (0, 1))
+    def test_contiguous(self, axis, np_rng):
+        # large skip uses the numpy windowing when the moving axis is first
+        x = np_rng.random((2000, 3))
+        xm = ascontiguousarray(moveaxis(x, 0, axis))
+
+        pred = moving_max(xm, 100, 50, axis=axis)
+        truth = max(get_windowed_view(x, 100, 50), axis=1)
+
+        assert pred.flags["C_CONTIGUOUS"]
+        assert allclose(pred, moveaxis(truth, 0, axis))
+
 
 class TestMovingMin(BaseMovingStatsTester):
     function = staticmethod(moving_min)
     truth_function = staticmethod(min)
     truth_kw = {}
+
+    @pytest.mark.parametrize("axis", (0, 1))
+    def test_contiguous(self, axis, np_rng):
+        # large skip uses the numpy windowing when the moving axis is first
+        x = np_rng.random((2000, 3))
+        xm = ascontiguousarray(moveaxis(x, 0, axis))
+
+        pred = moving_min(xm, 100, 50, axis=axis)
+        truth = min(get_windowed_view(x, 100, 50), axis=1)
+
+        assert pred.flags["C_CONTIGUOUS"]
+        assert allclose(pred, moveaxis(truth, 0, axis))
+
+
+class TestMovingStats:
+    @pytest.mark.parametrize("trim", (True, False))
+    @pytest.mark.parametrize(
+        "stats",
+        (
+            ["mean", "sd", "skewness", "kurtosis", "median", "max", "min", "range"],
+            ["range", "sd"],
+            ["kurtosis", "median"],
+        ),
+    )
+    def test(self, stats, trim, np_rng):
+        x = np_rng.random((2000, 3))
+        singles = {
+            "mean": moving_mean,
+            "sd": lambda **kw: moving_sd(**kw, return_previous=False),
+            "skewness": lambda **kw: moving_skewness(**kw, return_previous=False),
+            "kurtosis": lambda **kw: moving_kurtosis(**kw, return_previous=False),
+            "median": moving_median,
+            "max": moving_max,
+            "min": moving_min,
+            "range": lambda **kw: moving_max(**kw) - moving_min(**kw),
+        }
+        kw = dict(a=x, w_len=150, skip=7, trim=trim, axis=0)
+
+        res = moving_stats(x, 150, 7, stats, trim=trim, axis=0, workers=2)
+
+        assert list(res.keys()) == stats
+        for k in stats:
+            assert allclose(res[k], singles[k](**kw), equal_nan=True)
+
+    @pytest.mark.parametrize("stats", (["mean", "mean"], ["variance"], [], [1]))
+    def test_bad_stats(self, stats, np_rng):
+        with pytest.raises(ValueError):
+            moving_stats(np_rng.random(100), 10, 1, stats)
+
+
+class TestMovingStatsAccumulator:
+    @pytest.mark.parametrize(("w_len", "skip"), ((150, 7), (150, 150), (50, 170)))
+    def test(self, w_len, skip, np_rng):
+        stats = ["mean", "sd", "kurtosis", "median", "max", "min", "range"]
+        x = np_rng.random((3, 5000))
+        # uneven chunks, including ones smaller than a window
+        splits = sorted(np_rng.integers(0, x.shape[1], 12))
+
+        acc = MovingStatsAccumulator(w_len, skip, stats, axis=-1)
+        res = [acc.update(c) for c in array_split(x, splits, axis=1)]
+        res.append(acc.finish())
+
+        # the kernel state is carried between chunks, so results are identical
+        truth = moving_stats(x, w_len, skip, stats, trim=False)
+        for k in stats:
+            pred = concatenate([r[k] for r in res], axis=1)
+            assert pred.shape == truth[k].shape
+            assert array_equal(pred, truth[k], equal_nan=True)
+
+    def test_single_samples(self, np_rng):
+        stats = ["skewness", "median", "range"]
+        x = np_rng.random((400, 2))
+
+        acc = MovingStatsAccumulator(30, 4, stats, axis=0)
+        res = [acc.update(x[i : i + 1]) for i in range(x.shape[0])]
+
+        truth = moving_stats(x, 30, 4, stats, axis=0)
+        for k in stats:
+            assert array_equal(concatenate([r[k] for r in res], axis=0), truth[k])
+
+    def test_shape_mismatch(self, np_rng):
+        acc = MovingStatsAccumulator(10, 1, ["mean"])
+        acc.update(np_rng.random((3, 50)))
+
+        with pytest.raises(ValueError):
+            acc.update(np_rng.random((2, 50)))
+
+    def test_reset(self, np_rng):
+        x = np_rng.random(1000)
+        acc = MovingStatsAccumulator(100, 10, ["median"])
+
+        acc.update(np_rng.random(555))
+        acc.reset()
+        res = acc.update(x)
+
+        assert array_equal(res["median"], moving_median(x, 100, 10))
+
+        with pytest.raises(ValueError):
+            MovingStatsAccumulator(100, 10, ["median"]).finish()
+
+    def test_threads(self, np_rng):
+        x = np_rng.random((4, 200_000))
+        acc = MovingStatsAccumulator(500, 50, ["median", "max"])
+
+        def update(chunk):
+            try:
+                return acc.update(chunk)
+            except RuntimeError:
+                return None
+
+        # updates that overlap another one raise, instead of sharing the kernel state
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            res = list(pool.map(update, [x] * 8))
+
+        done = [r for r in res if r is not None]
+        assert len(done) > 0
+        assert acc.n_windows == sum(r["median"].shape[-1] for r in done)
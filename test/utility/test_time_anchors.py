@@ -0,0 +1,76 @@
+import pytest
+from numpy import allclose, arange, asarray, concatenate, int64
+
+from skdh.utility.time_anchors import TimeAnchors, interp_anchors
+
+
+@pytest.fixture(scope="module")
+def block_time():
+    # 120 sample blocks at ~100hz, with a gap and a slightly different rate
+    return concatenate(
+        (
+            1.6e9 + arange(240) / 100.0,
+            1.6e9 + 10 + arange(120) / 100.5,
+            1.6e9 + 10 + 120 / 100.5 + arange(50) / 100.0,
+        )
+    )
+
+
+class TestInterpAnchors:
+    def test(self):
+        t = interp_anchors(
+            asarray([0, 10]), asarray([0.0, 5.0]), asarray([10.0, 2.0]), [0, 9, 10, 13]
+        )
+
+        assert allclose(t, [0.0, 0.9, 5.0, 6.5])
+
+
+class TestTimeAnchors:
+    @pytest.mark.parametrize("offset", (0, 30))
+    def test_from_time(self, offset, block_time):
+        time = block_time[offset:]
+        anchors = TimeAnchors.from_time(time, 120, 100.0, offset=offset)
+
+        assert anchors.size == len(anchors) == time.size
+        assert anchors.nbytes < time.nbytes // 10
+        assert allclose(asarray(anchors), time, rtol=0, atol=1e-6)
+        assert allclose(anchors.materialize(), time, rtol=0, atol=1e-6)
+
+    def test_indexing(self, block_time):
+        anchors = TimeAnchors.from_time(block_time, 120, 100.0)
+
+        assert allclose(anchors[250], block_time[250], rtol=0, atol=1e-6)
+        assert allclose(anchors[-1], block_time[-1], rtol=0, atol=1e-6)
+        assert allclose(anchors[100:300:7], block_time[100:300:7], rtol=0, atol=1e-6)
+        assert allclose(anchors[[0, 5, 239]], block_time[[0, 5, 239]], rtol=0, atol=1e-6)
+
+        mask = block_time > block_time[200]
+        assert allclose(anchors[mask], block_time[mask], rtol=0, atol=1e-6)
+
+        with pytest.raises(IndexError):
+            anchors[block_time.size]
+
+    def test_ns(self, block_time):
+        anchors = TimeAnchors.from_time(block_time, 120, 100.0, ns=True)
+
+        assert anchors.dtype == int64
+        # float64 seconds have a resolution of ~240ns at this time
+        assert allclose(anchors[:10], block_time[:10] * 1e9, rtol=0, atol=1000)
+        assert allclose(anchors.seconds()[:10], block_time[:10], rtol=0, atol=1e-6)
+
+    @pytest.mark.parametrize("step", (1, 5, 7, 120, 500))
+    def test_downsample(self, step, block_time):
+        anchors = TimeAnchors.from_time(block_time, 120, 100.0).downsample(step)
+
+        assert anchors.size == block_time[::step].size
+        assert allclose(asarray(anchors), block_time[::step], rtol=0, atol=1e-6)
+
+    def test_empty(self):
+        anchors = TimeAnchors.from_time(arange(0), 120, 100.0)
+
+        assert anchors.size == 0
+        assert asarray(anchors).size == 0
+
+    def test_first_index_error(self):
+        with pytest.raises(ValueError):
+            TimeAnchors([5], [0.0], [100.0], 10)